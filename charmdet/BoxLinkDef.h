@@ -13,6 +13,8 @@
 #pragma link C++ class PixelModulesPoint+;
 #pragma link C++ class MufluxSpectrometer+;
 #pragma link C++ class MufluxSpectrometerHit+;
+#pragma link C++ struct MufluxStationInfo+;
+#pragma link C++ struct MufluxStationInfoColumns+;
 #pragma link C++ class MufluxSpectrometerPoint+;
 #pragma link C++ class SciFi+;
 #pragma link C++ class SciFiPoint+;
@@ -27,7 +29,21 @@
 #pragma link C++ class ReProcessAbsorber+;
 #pragma link C++ class RPCTrack+;
 #pragma link C++ class MufluxReco+;
+#pragma link C++ struct DTClusterHit+;
+#pragma link C++ class MufluxHistoRegistry+;
+#pragma link C++ class MufluxRPCMatcher+;
+#pragma link C++ struct RPCTrackLine+;
+#pragma link C++ class MuonTaggerStripTable+;
+#pragma link C++ class MufluxTrackFinder+;
+#pragma link C++ struct MufluxPatRecHits+;
+#pragma link C++ struct MufluxPatRecSegment+;
+#pragma link C++ struct MufluxPatRecTrack+;
+#pragma link C++ class RTRelation+;
+#pragma link C++ class DtAlignmentStore+;
+#pragma link C++ struct DtWireEnds+;
 #pragma link C++ class MillepedeCaller+;
+#pragma link C++ class MilleBufferedWriter+;
+#pragma link C++ class DtMilleDriver+;
 
 #endif
 
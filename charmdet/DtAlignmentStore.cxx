@@ -0,0 +1,208 @@
+#include "DtAlignmentStore.h"
+#include "MufluxHistoRegistry.h"
+#include "MufluxSpectrometerHit.h"
+
+#include "TClonesArray.h"
+#include "TRotation.h"
+
+#include <iostream>
+
+namespace {
+const Int_t kTubes =
+   MufluxHistoRegistry::kStations * 2 * MufluxHistoRegistry::kPlanes * MufluxHistoRegistry::kLayers * MufluxHistoRegistry::kStraws;
+}
+
+DtAlignmentStore::DtAlignmentStore()
+   : TObject(), fModule(kTubes, -1), fNominal(6 * kTubes, 0), fCorrected(), fChanged(kTRUE)
+{
+   for (Int_t m = 0; m < kModules; m++) {
+      fCenterSet[m] = 0;
+      for (Int_t i = 0; i < 3; i++) {
+         fCenter[m][i] = 0;
+      }
+   }
+   ResetCorrections();
+}
+
+DtAlignmentStore::~DtAlignmentStore() {}
+
+void DtAlignmentStore::SetTube(Int_t detID, Int_t module, const TVector3 &bot, const TVector3 &top)
+{
+   Int_t index = MufluxHistoRegistry::ChannelIndex(detID);
+   if (index < 0 || module < 0 || module >= kModules) {
+      std::cout << "DtAlignmentStore::SetTube: invalid detector ID " << detID << " or module " << module << std::endl;
+      return;
+   }
+   fModule[index] = module;
+   Double_t *nominal = &fNominal[6 * index];
+   for (Int_t i = 0; i < 3; i++) {
+      nominal[i] = bot[i];
+      nominal[3 + i] = top[i];
+   }
+   fChanged = kTRUE;
+}
+
+void DtAlignmentStore::SetModuleCenter(Int_t module, const TVector3 &center)
+{
+   if (module < 0 || module >= kModules) {
+      std::cout << "DtAlignmentStore::SetModuleCenter: invalid module " << module << std::endl;
+      return;
+   }
+   for (Int_t i = 0; i < 3; i++) {
+      fCenter[module][i] = center[i];
+   }
+   fCenterSet[module] = 1;
+   fChanged = kTRUE;
+}
+
+void DtAlignmentStore::SetCorrection(Int_t module, Double_t dx, Double_t dy, Double_t dz, Double_t phi,
+                                     Double_t theta, Double_t psi)
+{
+   if (module < 0 || module >= kModules) {
+      std::cout << "DtAlignmentStore::SetCorrection: invalid module " << module << std::endl;
+      return;
+   }
+   fTranslation[module][0] = dx;
+   fTranslation[module][1] = dy;
+   fTranslation[module][2] = dz;
+   TRotation rotation;
+   rotation.SetXEulerAngles(phi, theta, psi);
+   const Double_t matrix[9] = {rotation.XX(), rotation.XY(), rotation.XZ(), rotation.YX(), rotation.YY(),
+                               rotation.YZ(), rotation.ZX(), rotation.ZY(), rotation.ZZ()};
+   for (Int_t i = 0; i < 9; i++) {
+      fRotation[module][i] = matrix[i];
+   }
+   // Without rotation the end points are only shifted, bit identical to adding the translation
+   fRotated[module] = phi != 0 || theta != 0 || psi != 0;
+   fChanged = kTRUE;
+}
+
+void DtAlignmentStore::ResetCorrections()
+{
+   for (Int_t m = 0; m < kModules; m++) {
+      for (Int_t i = 0; i < 3; i++) {
+         fTranslation[m][i] = 0;
+      }
+      for (Int_t i = 0; i < 9; i++) {
+         fRotation[m][i] = (i % 4 == 0) ? 1 : 0;
+      }
+      fRotated[m] = 0;
+   }
+   fChanged = kTRUE;
+}
+
+Bool_t DtAlignmentStore::HasTube(Int_t detID) const
+{
+   return GetModule(detID) >= 0;
+}
+
+Int_t DtAlignmentStore::GetModule(Int_t detID) const
+{
+   Int_t index = MufluxHistoRegistry::ChannelIndex(detID);
+   return index < 0 ? -1 : fModule[index];
+}
+
+TVector3 DtAlignmentStore::GetModuleCenter(Int_t module) const
+{
+   if (module < 0 || module >= kModules) {
+      return TVector3();
+   }
+   Update();
+   return TVector3(fModuleCenter[module][0], fModuleCenter[module][1], fModuleCenter[module][2]);
+}
+
+TVector3 DtAlignmentStore::GetTranslation(Int_t module) const
+{
+   if (module < 0 || module >= kModules) {
+      return TVector3();
+   }
+   return TVector3(fTranslation[module][0], fTranslation[module][1], fTranslation[module][2]);
+}
+
+void DtAlignmentStore::Update() const
+{
+   if (!fChanged) {
+      return;
+   }
+   // Centers of modules without a given one, mean of the tube centers
+   Double_t sum[kModules][3] = {};
+   Int_t n[kModules] = {};
+   for (Int_t t = 0; t < kTubes; t++) {
+      Int_t m = fModule[t];
+      if (m < 0 || fCenterSet[m]) {
+         continue;
+      }
+      for (Int_t i = 0; i < 3; i++) {
+         sum[m][i] += (fNominal[6 * t + i] + fNominal[6 * t + 3 + i]) / 2.;
+      }
+      n[m]++;
+   }
+   for (Int_t m = 0; m < kModules; m++) {
+      for (Int_t i = 0; i < 3; i++) {
+         fModuleCenter[m][i] = fCenterSet[m] ? fCenter[m][i] : (n[m] > 0 ? sum[m][i] / n[m] : 0);
+      }
+   }
+   fCorrected.assign(6 * kTubes, 0);
+   for (Int_t t = 0; t < kTubes; t++) {
+      Int_t m = fModule[t];
+      if (m < 0) {
+         continue;
+      }
+      const Double_t *p = &fNominal[6 * t];
+      Double_t *c = &fCorrected[6 * t];
+      const Double_t *R = fRotation[m];
+      for (Int_t e = 0; e < 6; e += 3) {
+         if (fRotated[m]) {
+            Double_t d[3] = {p[e] - fModuleCenter[m][0], p[e + 1] - fModuleCenter[m][1], p[e + 2] - fModuleCenter[m][2]};
+            for (Int_t i = 0; i < 3; i++) {
+               c[e + i] = R[3 * i] * d[0] + R[3 * i + 1] * d[1] + R[3 * i + 2] * d[2] + fModuleCenter[m][i] +
+                          fTranslation[m][i];
+            }
+         } else {
+            for (Int_t i = 0; i < 3; i++) {
+               c[e + i] = p[e + i] + fTranslation[m][i];
+            }
+         }
+      }
+   }
+   fChanged = kFALSE;
+}
+
+Bool_t DtAlignmentStore::GetEndPoints(Int_t detID, TVector3 &bot, TVector3 &top) const
+{
+   Int_t index = MufluxHistoRegistry::ChannelIndex(detID);
+   if (index < 0 || fModule[index] < 0) {
+      return kFALSE;
+   }
+   Update();
+   const Double_t *c = &fCorrected[6 * index];
+   bot.SetXYZ(c[0], c[1], c[2]);
+   top.SetXYZ(c[3], c[4], c[5]);
+   return kTRUE;
+}
+
+Int_t DtAlignmentStore::GetEndPoints(const TClonesArray *hits, DtWireEnds &ends) const
+{
+   Update();
+   const Int_t n = hits->GetEntriesFast();
+   for (auto column : {&ends.botX, &ends.botY, &ends.botZ, &ends.topX, &ends.topY, &ends.topZ}) {
+      column->resize(n);
+   }
+   ends.known.resize(n);
+   for (Int_t k = 0; k < n; k++) {
+      Int_t index =
+         MufluxHistoRegistry::ChannelIndex(static_cast<const MufluxSpectrometerHit *>(hits->UncheckedAt(k))->GetDetectorID());
+      Bool_t known = index >= 0 && fModule[index] >= 0;
+      const Double_t *c = known ? &fCorrected[6 * index] : nullptr;
+      ends.botX[k] = known ? c[0] : 0;
+      ends.botY[k] = known ? c[1] : 0;
+      ends.botZ[k] = known ? c[2] : 0;
+      ends.topX[k] = known ? c[3] : 0;
+      ends.topY[k] = known ? c[4] : 0;
+      ends.topZ[k] = known ? c[5] : 0;
+      ends.known[k] = known;
+   }
+   return n;
+}
+
+ClassImp(DtAlignmentStore)
@@ -0,0 +1,74 @@
+#ifndef DTALIGNMENTSTORE_H
+#define DTALIGNMENTSTORE_H 1
+
+#include "TObject.h"
+#include "TVector3.h"
+
+#include <vector>
+
+class TClonesArray;
+
+/** Corrected wire end points of the hits of an event, one column per coordinate **/
+struct DtWireEnds {
+   std::vector<Double_t> botX;
+   std::vector<Double_t> botY;
+   std::vector<Double_t> botZ;
+   std::vector<Double_t> topX;
+   std::vector<Double_t> topY;
+   std::vector<Double_t> topZ;
+   std::vector<Int_t> known; // 0 if the tube of the hit is not in the store, end points are 0
+};
+
+/* Alignment of the drift tubes in flat arrays, the C++ counterpart of the DtAlignment package.
+   Every tube has nominal wire end points and belongs to a module. A module has a rigid body
+   correction, a translation and a rotation (Euler angles in the x-convention of TRotation, as
+   DetElement) about its center:  p' = R (p - center) + center + translation.
+   The corrected end points of all tubes are computed once after the corrections change, the end
+   points of the hits of an event are then a lookup by detector ID. */
+class DtAlignmentStore : public TObject {
+public:
+   enum { kModules = 64 };
+
+   DtAlignmentStore();
+   virtual ~DtAlignmentStore();
+
+   /** Nominal wire end points of a tube and its module */
+   void SetTube(Int_t detID, Int_t module, const TVector3 &bot, const TVector3 &top);
+   /** Center of rotation of a module, without it the mean of the centers of its tubes (calculate_center_from_lot) */
+   void SetModuleCenter(Int_t module, const TVector3 &center);
+   /** Rigid body correction of a module, replaces the previous one */
+   void SetCorrection(Int_t module, Double_t dx, Double_t dy, Double_t dz, Double_t phi = 0, Double_t theta = 0,
+                      Double_t psi = 0);
+   void ResetCorrections();
+
+   Bool_t HasTube(Int_t detID) const;
+   Int_t GetModule(Int_t detID) const;
+   TVector3 GetModuleCenter(Int_t module) const;
+   TVector3 GetTranslation(Int_t module) const;
+
+   /** Corrected end points of a tube, false if it is not in the store */
+   Bool_t GetEndPoints(Int_t detID, TVector3 &bot, TVector3 &top) const;
+   /** Corrected end points of all hits of a Digi_MufluxSpectrometerHits array, returns the number of hits */
+   Int_t GetEndPoints(const TClonesArray *hits, DtWireEnds &ends) const;
+
+private:
+   void Update() const;
+
+   // Tubes by MufluxHistoRegistry::ChannelIndex, nominal end points bot x,y,z and top x,y,z
+   std::vector<Int_t> fModule;
+   std::vector<Double_t> fNominal;
+   // Modules, center x,y,z, translation x,y,z and rotation matrix xx,xy,xz,yx,...
+   Double_t fCenter[kModules][3];
+   Int_t fCenterSet[kModules];
+   Double_t fTranslation[kModules][3];
+   Double_t fRotation[kModules][9];
+   Int_t fRotated[kModules];
+
+   mutable std::vector<Double_t> fCorrected;    //! corrected end points as fNominal
+   mutable Double_t fModuleCenter[kModules][3]; //! given or mean center
+   mutable Bool_t fChanged;                     //!
+
+   ClassDef(DtAlignmentStore, 1)
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "DtMilleDriver.h"
+#include "DtAlignmentStore.h"
+#include "MilleBufferedWriter.h"
+#include "MufluxSpectrometerHit.h"
+#include "RTRelation.h"
+
+#include "AbsFitterInfo.h"
+#include "AbsMeasurement.h"
+#include "Exception.h"
+#include "FitStatus.h"
+#include "MeasuredStateOnPlane.h"
+#include "Track.h"
+#include "TrackPoint.h"
+
+#include "TChain.h"
+#include "TClonesArray.h"
+#include "TFile.h"
+#include "TMath.h"
+#include "TTree.h"
+#include "TVector3.h"
+
+#include <iostream>
+
+DtMilleDriver::DtMilleDriver(MilleBufferedWriter *writer, const DtAlignmentStore *alignment, const RTRelation *rt)
+   : TObject(), fWriter(writer), fAlignment(alignment), fRT(rt), fPMin(0)
+{
+}
+
+DtMilleDriver::~DtMilleDriver() {}
+
+Int_t DtMilleDriver::ProcessTrack(const genfit::Track *track, const TClonesArray *hits)
+{
+   if (!fWriter || !fAlignment || !track) {
+      return 0;
+   }
+   fResiduals.clear();
+   fSigmas.clear();
+   fLocal.clear();
+   fGlobal.clear();
+   fLabels.clear();
+   // reference z of the two track segments, the first hit of each
+   Double_t zRef[2] = {0, 0};
+   Bool_t hasRef[2] = {kFALSE, kFALSE};
+   const Int_t nPoints = track->getNumPointsWithMeasurement();
+   for (Int_t i = 0; i < nPoints; i++) {
+      genfit::TrackPoint *tp = track->getPointWithMeasurement(i);
+      const genfit::AbsMeasurement *raw = tp->getRawMeasurement();
+      const Int_t detID = raw->getDetId();
+      const Int_t module = fAlignment->GetModule(detID);
+      TVector3 bot, top;
+      if (module < 0 || raw->getDim() < 7 || !tp->getFitterInfo() || !fAlignment->GetEndPoints(detID, bot, top)) {
+         continue;
+      }
+      TVector3 pos, dir;
+      try {
+         tp->getFitterInfo()->getFittedState().getPosDir(pos, dir);
+      } catch (genfit::Exception &e) {
+         continue;
+      }
+      Double_t rDrift = raw->getRawHitCoords()[6];
+      if (fRT && hits) {
+         const Int_t hitId = raw->getHitId();
+         if (hitId >= 0 && hitId < hits->GetEntriesFast()) {
+            const MufluxSpectrometerHit *hit = static_cast<const MufluxSpectrometerHit *>(hits->UncheckedAt(hitId));
+            if (hit->GetDetectorID() == detID) {
+               rDrift = fRT->Eval(detID / 10000000, hit->GetDigi());
+            }
+         }
+      }
+      // points of closest approach of track and wire, u the direction from the wire to the track
+      const TVector3 wire = top - bot;
+      const TVector3 w0 = pos - bot;
+      TVector3 u = dir.Cross(wire);
+      const Double_t a = dir.Dot(dir), b = dir.Dot(wire), c = wire.Dot(wire), d = dir.Dot(w0), e = wire.Dot(w0);
+      const Double_t den = a * c - b * b;
+      if (u.Mag2() == 0 || den == 0) {
+         continue;
+      }
+      u = u.Unit();
+      Double_t dist = w0.Dot(u);
+      if (dist < 0) {
+         u = -u;
+         dist = -dist;
+      }
+      const Double_t zTrack = pos.Z() + (b * e - c * d) / den * dir.Z();
+      const TVector3 onWire = bot + (a * e - b * d) / den * wire;
+
+      const Int_t segment = detID / 10000000 < 3 ? 0 : 1;
+      if (!hasRef[segment]) {
+         zRef[segment] = zTrack;
+         hasRef[segment] = kTRUE;
+      }
+      const Double_t dz = zTrack - zRef[segment];
+      Float_t local[kLocal] = {};
+      if (segment == 0) {
+         local[0] = u.X();
+         local[1] = u.Y();
+         local[2] = u.X() * dz;
+         local[3] = u.Y() * dz;
+      } else {
+         local[4] = u.X();
+         local[5] = u.X() * dz;
+      }
+      const TVector3 center = fAlignment->GetModuleCenter(module);
+      const Float_t global[kGlobal] = {Float_t(-u.X()), Float_t(-u.Y()), Float_t(-u.Z()),
+                                       Float_t(u.X() * (onWire.Y() - center.Y()) - u.Y() * (onWire.X() - center.X()))};
+      fResiduals.push_back(rDrift - dist);
+      fSigmas.push_back(TMath::Sqrt(raw->getRawHitCov()(6, 6)));
+      fLocal.insert(fLocal.end(), local, local + kLocal);
+      fGlobal.insert(fGlobal.end(), global, global + kGlobal);
+      for (Int_t k = 1; k <= kGlobal; k++) {
+         fLabels.push_back(100 * (module + 1) + k);
+      }
+   }
+   const Int_t n = fResiduals.size();
+   if (n == 0 || !fWriter->AddTrack(n, fResiduals.data(), fSigmas.data(), kLocal, fLocal.data(), kGlobal,
+                                    fGlobal.data(), fLabels.data())) {
+      return 0;
+   }
+   return n;
+}
+
+Long64_t DtMilleDriver::ProcessTree(TTree *tree, Long64_t nEvents)
+{
+   // private chain on the files of the tree, the branch addresses of the caller (sTree of python) are not touched
+   TChain chain(tree->GetName());
+   if (tree->InheritsFrom(TChain::Class())) {
+      chain.Add(static_cast<TChain *>(tree));
+   } else if (tree->GetCurrentFile()) {
+      chain.Add(tree->GetCurrentFile()->GetName());
+   } else {
+      std::cout << "DtMilleDriver::ProcessTree: tree " << tree->GetName() << " is not read from a file" << std::endl;
+      return 0;
+   }
+   TClonesArray *tracks = new TClonesArray("genfit::Track");
+   TClonesArray *hits = nullptr;
+   chain.SetBranchAddress("FitTracks", &tracks);
+   if (chain.GetBranch("Digi_MufluxSpectrometerHits")) {
+      hits = new TClonesArray("MufluxSpectrometerHit");
+      chain.SetBranchAddress("Digi_MufluxSpectrometerHits", &hits);
+   }
+   const Long64_t N = chain.GetEntries();
+   if (nEvents < 0 || nEvents > N) {
+      nEvents = N;
+   }
+   Long64_t nRecords = 0;
+   for (Long64_t n = 0; n < nEvents; n++) {
+      chain.GetEntry(n);
+      for (Int_t k = 0; k < tracks->GetEntriesFast(); k++) {
+         const genfit::Track *track = static_cast<const genfit::Track *>(tracks->UncheckedAt(k));
+         if (!track->getFitStatus()->isFitConverged()) {
+            continue;
+         }
+         try {
+            if (track->getFittedState(0).getMomMag() < fPMin) {
+               continue;
+            }
+         } catch (genfit::Exception &e) {
+            continue;
+         }
+         if (ProcessTrack(track, hits) > 0) {
+            nRecords++;
+         }
+      }
+   }
+   chain.ResetBranchAddresses();
+   delete tracks;
+   delete hits;
+   if (fWriter) {
+      fWriter->Flush();
+   }
+   return nRecords;
+}
+
+ClassImp(DtMilleDriver)
@@ -0,0 +1,63 @@
+#ifndef DTMILLEDRIVER_H
+#define DTMILLEDRIVER_H 1
+
+#include "TObject.h"
+
+#include <vector>
+
+class TClonesArray;
+class TTree;
+class DtAlignmentStore;
+class MilleBufferedWriter;
+class RTRelation;
+namespace genfit {
+class Track;
+}
+
+/* Millepede input for the drift tube alignment from fitted tracks, without python in the loop.
+   One record per track, one measurement per hit: the drift radius minus the distance of the fitted
+   track to the wire, sigma from the hit covariance of the fit.
+   Local parameters, straight lines before and after the magnet at the z of their first hit:
+     1-4  x, y, dx/dz, dy/dz  stations 1-2
+     5-6  x, dx/dz            stations 3-4 (x views only)
+   Global parameters of the DtAlignmentStore module m, labels 100*(m+1)+k:
+     k = 1-3  translation x, y, z
+     k = 4    rotation about z around the module center
+   The wires are the corrected end points of the store, the drift radius the one of the fit, or from
+   the TDC of the MufluxSpectrometerHit (hit ID of the measurement) with a RTRelation. */
+class DtMilleDriver : public TObject {
+public:
+   enum { kLocal = 6, kGlobal = 4 };
+
+   DtMilleDriver(MilleBufferedWriter *writer = nullptr, const DtAlignmentStore *alignment = nullptr,
+                 const RTRelation *rt = nullptr);
+   virtual ~DtMilleDriver();
+
+   /** Only tracks with converged fit and momentum above pMin */
+   void SetMinMomentum(Double_t pMin) { fPMin = pMin; }
+   /** Record of one track, hits the Digi_MufluxSpectrometerHits of the event or null.
+    *  Returns the number of measurements written. */
+   Int_t ProcessTrack(const genfit::Track *track, const TClonesArray *hits = nullptr);
+   /** All tracks of the branch FitTracks of nEvents events, returns the number of records written.
+    *  The events are read with a separate chain on the files of the tree, its branch addresses are unchanged. */
+   Long64_t ProcessTree(TTree *tree, Long64_t nEvents = -1);
+
+private:
+   DtMilleDriver(const DtMilleDriver &);
+   DtMilleDriver &operator=(const DtMilleDriver &);
+
+   MilleBufferedWriter *fWriter;       //!
+   const DtAlignmentStore *fAlignment; //!
+   const RTRelation *fRT;              //!
+   Double_t fPMin;
+   // derivative blocks of the current track
+   std::vector<Float_t> fResiduals;    //!
+   std::vector<Float_t> fSigmas;       //!
+   std::vector<Float_t> fLocal;        //!
+   std::vector<Float_t> fGlobal;       //!
+   std::vector<Int_t> fLabels;         //!
+
+   ClassDef(DtMilleDriver, 1)
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include "MilleBufferedWriter.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <cstring>
+#include <iostream>
+
+MilleBufferedWriter::MilleBufferedWriter(const char *outFileName, Bool_t compress, Int_t bufferSize,
+                                         Bool_t writeZero)
+   : TObject(), fFile(nullptr), fGzFile(nullptr), fWriteZero(writeZero), fBuffer(),
+     fBufferSize(bufferSize > 0 ? bufferSize : 1), fRecordFloat(), fRecordInt(), fNRecords(0), fNBytes(0)
+{
+   if (compress) {
+#ifdef HAVE_ZLIB
+      gzFile f = gzopen(outFileName, "wb");
+      if (f) {
+         gzbuffer(f, 1 << 17);
+      }
+      fGzFile = f;
+#else
+      std::cout << "MilleBufferedWriter: built without zlib, " << outFileName << " is written uncompressed"
+                << std::endl;
+      compress = kFALSE;
+#endif
+   }
+   if (!compress) {
+      fFile = std::fopen(outFileName, "wb");
+      if (fFile) {
+         // the buffer is ours, every flush is a single write
+         std::setvbuf(fFile, nullptr, _IONBF, 0);
+      }
+   }
+   if (!IsOpen()) {
+      std::cout << "MilleBufferedWriter: could not open " << outFileName << " as output file" << std::endl;
+   }
+   fBuffer.reserve(fBufferSize);
+}
+
+MilleBufferedWriter::~MilleBufferedWriter()
+{
+   Close();
+}
+
+Bool_t MilleBufferedWriter::AddTrack(Int_t n, const Float_t *residuals, const Float_t *sigmas, Int_t nLocal,
+                                     const Float_t *local, Int_t nGlobal, const Float_t *global, const Int_t *labels)
+{
+   if (!IsOpen()) {
+      return kFALSE;
+   }
+   // position 0 is the error counter of Mille
+   fRecordFloat.assign(1, 0.);
+   fRecordInt.assign(1, 0);
+   for (Int_t k = 0; k < n; k++) {
+      if (sigmas[k] <= 0.) {
+         continue;
+      }
+      fRecordFloat.push_back(residuals[k]);
+      fRecordInt.push_back(0);
+      const Float_t *derLc = local + k * nLocal;
+      for (Int_t i = 0; i < nLocal; i++) {
+         if (derLc[i] || fWriteZero) {
+            fRecordFloat.push_back(derLc[i]);
+            fRecordInt.push_back(i + 1);
+         }
+      }
+      fRecordFloat.push_back(sigmas[k]);
+      fRecordInt.push_back(0);
+      const Float_t *derGl = global + k * nGlobal;
+      const Int_t *label = labels + k * nGlobal;
+      for (Int_t i = 0; i < nGlobal; i++) {
+         if (derGl[i] || fWriteZero) {
+            if ((label[i] > 0 || fWriteZero) && label[i] <= kMaxLabel) {
+               fRecordFloat.push_back(derGl[i]);
+               fRecordInt.push_back(label[i]);
+            } else {
+               std::cout << "MilleBufferedWriter::AddTrack: invalid label " << label[i] << std::endl;
+            }
+         }
+      }
+   }
+   if (fRecordFloat.size() < 2) {
+      return kFALSE;
+   }
+   const Int_t nWords = 2 * fRecordFloat.size();
+   const size_t nFloat = fRecordFloat.size() * sizeof(Float_t);
+   const size_t nInt = fRecordInt.size() * sizeof(Int_t);
+   const size_t nRecord = sizeof(nWords) + nFloat + nInt;
+   if (!fBuffer.empty() && fBuffer.size() + nRecord > fBufferSize) {
+      Flush();
+   }
+   const size_t pos = fBuffer.size();
+   fBuffer.resize(pos + nRecord);
+   char *out = fBuffer.data() + pos;
+   std::memcpy(out, &nWords, sizeof(nWords));
+   std::memcpy(out + sizeof(nWords), fRecordFloat.data(), nFloat);
+   std::memcpy(out + sizeof(nWords) + nFloat, fRecordInt.data(), nInt);
+   fNRecords++;
+   return kTRUE;
+}
+
+void MilleBufferedWriter::Flush()
+{
+   if (fBuffer.empty()) {
+      return;
+   }
+   size_t written = 0;
+   if (fFile) {
+      written = std::fwrite(fBuffer.data(), 1, fBuffer.size(), fFile);
+   }
+#ifdef HAVE_ZLIB
+   if (fGzFile) {
+      Int_t rc = gzwrite(static_cast<gzFile>(fGzFile), fBuffer.data(), fBuffer.size());
+      written = rc > 0 ? rc : 0;
+   }
+#endif
+   if (written != fBuffer.size()) {
+      std::cout << "MilleBufferedWriter::Flush: wrote " << written << " of " << fBuffer.size() << " bytes"
+                << std::endl;
+   }
+   fNBytes += written;
+   fBuffer.clear();
+}
+
+void MilleBufferedWriter::Close()
+{
+   Flush();
+   if (fFile) {
+      std::fclose(fFile);
+      fFile = nullptr;
+   }
+#ifdef HAVE_ZLIB
+   if (fGzFile) {
+      gzclose(static_cast<gzFile>(fGzFile));
+      fGzFile = nullptr;
+   }
+#endif
+}
+
+ClassImp(MilleBufferedWriter)
@@ -0,0 +1,57 @@
+#ifndef MILLEBUFFEREDWRITER_H
+#define MILLEBUFFEREDWRITER_H 1
+
+#include "TObject.h"
+
+#include <cstdio>
+#include <vector>
+
+/* Writer of Millepede-II C binary records, a track at a time.
+   A record is built from the derivative blocks of all measurements of a track and appended to an
+   output buffer, the buffer goes to the file with one write when it is full. The records are the
+   same as the ones of Mille::mille/Mille::end: zero derivatives and labels <= 0 are dropped,
+   measurements with sigma <= 0 are skipped.
+   With compress the file is written with zlib as gzip, which pede reads directly (if built with
+   zlib). Without zlib in the build the file is written uncompressed. */
+class MilleBufferedWriter : public TObject {
+public:
+   MilleBufferedWriter(const char *outFileName = "mp2input.bin", Bool_t compress = kFALSE,
+                       Int_t bufferSize = 8 << 20, Bool_t writeZero = kFALSE);
+   virtual ~MilleBufferedWriter();
+
+   Bool_t IsOpen() const { return fFile || fGzFile; }
+
+   /** One record with the n measurements of a track. Row k of the blocks belongs to measurement k,
+    *  local derivatives local[k*nLocal+i], global derivatives global[k*nGlobal+j] with the labels
+    *  labels[k*nGlobal+j]. Returns false if nothing was stored. */
+   Bool_t AddTrack(Int_t n, const Float_t *residuals, const Float_t *sigmas, Int_t nLocal, const Float_t *local,
+                   Int_t nGlobal, const Float_t *global, const Int_t *labels);
+   /** Write the buffered records to the file */
+   void Flush();
+   /** Flush and close the file, done by the destructor */
+   void Close();
+
+   Long64_t GetNRecords() const { return fNRecords; }
+   Long64_t GetNBytes() const { return fNBytes; }
+
+private:
+   MilleBufferedWriter(const MilleBufferedWriter &);
+   MilleBufferedWriter &operator=(const MilleBufferedWriter &);
+
+   // largest label allowed: 2^31 - 1, as Mille
+   enum { kMaxLabel = 0x7FFFFFFF };
+
+   FILE *fFile;                       //!
+   void *fGzFile;                     //! gzFile
+   Bool_t fWriteZero;                 //!
+   std::vector<char> fBuffer;         //! records waiting for the next write
+   size_t fBufferSize;                //!
+   std::vector<Float_t> fRecordFloat; //! record under construction, as Mille
+   std::vector<Int_t> fRecordInt;     //!
+   Long64_t fNRecords;                //!
+   Long64_t fNBytes;                  //!
+
+   ClassDef(MilleBufferedWriter, 1)
+};
+
+#endif
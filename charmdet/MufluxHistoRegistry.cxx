@@ -0,0 +1,94 @@
+#include "MufluxHistoRegistry.h"
+
+#include "TDirectory.h"
+#include "TH1D.h"
+
+#include <cstdlib>
+#include <cstring>
+
+MufluxHistoRegistry::MufluxHistoRegistry()
+   : TObject(), fHitMaps(kStations * kPlanes * kLayers * kViews, nullptr), fTDC(),
+     fTDCChannel(kStations * 2 * kPlanes * kLayers * kStraws, nullptr), fNRTBins(0)
+{
+}
+
+MufluxHistoRegistry::~MufluxHistoRegistry() {}
+
+TString MufluxHistoRegistry::HitMapName(Int_t s, Int_t p, Int_t l, Int_t view)
+{
+   const char *views[kViews] = {"_x", "_u", "_v"};
+   TString name;
+   name.Form("%d%s", 1000 * s + 100 * p + 10 * l, views[view]);
+   return name;
+}
+
+TString MufluxHistoRegistry::TDCName(Int_t nRTbin, Bool_t noToT)
+{
+   TString name = "TDC";
+   name += nRTbin;
+   if (noToT) {
+      name += "_noToT";
+   }
+   return name;
+}
+
+void MufluxHistoRegistry::Resolve(Int_t RTsegmentation, TDirectory *dir)
+{
+   if (!dir) {
+      dir = gDirectory;
+   }
+   TList *list = dir->GetList();
+   for (Int_t s = 1; s <= kStations; s++) {
+      for (Int_t p = 0; p < kPlanes; p++) {
+         for (Int_t l = 0; l < kLayers; l++) {
+            for (Int_t view = 0; view < kViews; view++) {
+               fHitMaps[((s - 1) * kPlanes + p) * kLayers * kViews + l * kViews + view] =
+                  (TH1D *)list->FindObject(HitMapName(s, p, l, view));
+            }
+         }
+      }
+   }
+   fNRTBins = RTsegmentation > 0 ? kNRT / RTsegmentation + 1 : 0;
+   fTDC.assign(2 * fNRTBins, nullptr);
+   for (Int_t n = 0; n < fNRTBins; n++) {
+      fTDC[2 * n] = (TH1D *)list->FindObject(TDCName(n, kFALSE));
+      fTDC[2 * n + 1] = (TH1D *)list->FindObject(TDCName(n, kTRUE));
+   }
+   // One pass over the list for the channel histograms, "TDC" followed by a detector ID
+   fTDCChannel.assign(fTDCChannel.size(), nullptr);
+   TIter next(list);
+   while (TObject *obj = next()) {
+      const char *name = obj->GetName();
+      if (strncmp(name, "TDC", 3) != 0) {
+         continue;
+      }
+      char *end;
+      Int_t detID = strtol(name + 3, &end, 10);
+      if (end == name + 3 || *end != '\0') {
+         continue;
+      }
+      Int_t index = ChannelIndex(detID);
+      // Names of nRT bins are short numbers, they give no valid channel index
+      if (index >= 0 && detID >= 10000000 && !fTDCChannel[index]) {
+         fTDCChannel[index] = (TH1D *)obj;
+      }
+   }
+}
+
+void MufluxHistoRegistry::CloneHistograms(std::vector<std::pair<TH1 *, TH1 *>> &clones)
+{
+   for (auto table : {&fHitMaps, &fTDC, &fTDCChannel}) {
+      for (auto &h : *table) {
+         if (!h) {
+            continue;
+         }
+         TH1D *clone = (TH1D *)h->Clone();
+         clone->SetDirectory(nullptr);
+         clone->Reset();
+         clones.push_back(std::make_pair((TH1 *)h, (TH1 *)clone));
+         h = clone;
+      }
+   }
+}
+
+ClassImp(MufluxHistoRegistry)
@@ -0,0 +1,81 @@
+#ifndef MUFLUXHISTOREGISTRY_H
+#define MUFLUXHISTOREGISTRY_H 1
+
+#include "TObject.h"
+#include "TString.h"
+
+#include <utility>
+#include <vector>
+
+class TH1;
+class TH1D;
+class TDirectory;
+
+/* Histograms of the drift tube hit maps, resolved once by name into dense arrays.
+   Per hit the histogram is a pointer load instead of a TString and a linear
+   FindObject over all booked histograms.
+   Names as booked by drifttubeMonitoring.py:
+     hit maps            "<1000*s+100*p+10*l>_x|_u|_v"  indexed by station 1-4, plane, layer, view
+     TDC per nRT bin     "TDC<nRT/RTsegmentation>[_noToT]"
+     TDC per channel     "TDC<detector ID>"            indexed by ChannelIndex(detector ID) */
+class MufluxHistoRegistry : public TObject {
+public:
+   enum { kStations = 4, kPlanes = 2, kLayers = 2, kViews = 3, kNRT = 576, kStraws = 64 };
+
+   MufluxHistoRegistry();
+   virtual ~MufluxHistoRegistry();
+
+   /** Resolve all names in dir, gDirectory if null. Missing histograms stay null. */
+   void Resolve(Int_t RTsegmentation, TDirectory *dir = nullptr);
+   /** Replace all histograms by empty clones without directory, e.g. one set per thread. The pairs (histogram,
+    *  clone) are appended to clones, the clones belong to the caller. */
+   void CloneHistograms(std::vector<std::pair<TH1 *, TH1 *>> &clones);
+
+   TH1D *HitMap(Int_t s, Int_t p, Int_t l, Int_t view) const
+   {
+      if (s < 1 || s > kStations || p < 0 || p >= kPlanes || l < 0 || l >= kLayers || view < 0 || view >= kViews) {
+         return nullptr;
+      }
+      return fHitMaps[((s - 1) * kPlanes + p) * kLayers * kViews + l * kViews + view];
+   }
+   TH1D *TDC(Int_t nRTbin, Bool_t noToT) const
+   {
+      if (nRTbin < 0 || nRTbin >= fNRTBins) {
+         return nullptr;
+      }
+      return fTDC[nRTbin * 2 + (noToT ? 1 : 0)];
+   }
+   TH1D *TDCChannel(Int_t detID) const
+   {
+      Int_t index = ChannelIndex(detID);
+      return index < 0 ? nullptr : fTDCChannel[index];
+   }
+   Int_t GetNRTBins() const { return fNRTBins; }
+
+   /** Dense index of a drift tube from station, view number, plane, layer and straw of the detector ID, -1 if
+    *  outside of the table. */
+   static Int_t ChannelIndex(Int_t detID)
+   {
+      Int_t s = detID / 10000000;
+      Int_t v = (detID / 1000000) % 10;
+      Int_t p = (detID / 100000) % 10;
+      Int_t l = (detID / 10000) % 10;
+      Int_t straw = detID % 1000;
+      if (detID < 0 || s < 1 || s > kStations || v > 1 || p >= kPlanes || l >= kLayers || straw >= kStraws) {
+         return -1;
+      }
+      return (((s - 1) * 2 + v) * kPlanes * kLayers + p * kLayers + l) * kStraws + straw;
+   }
+   static TString HitMapName(Int_t s, Int_t p, Int_t l, Int_t view);
+   static TString TDCName(Int_t nRTbin, Bool_t noToT);
+
+private:
+   std::vector<TH1D *> fHitMaps;    //!
+   std::vector<TH1D *> fTDC;        //!
+   std::vector<TH1D *> fTDCChannel; //!
+   Int_t fNRTBins;
+
+   ClassDef(MufluxHistoRegistry, 1)
+};
+
+#endif
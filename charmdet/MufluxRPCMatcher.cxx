@@ -0,0 +1,91 @@
+#include "MufluxRPCMatcher.h"
+#include "MuonTaggerHit.h"
+
+#include "TClonesArray.h"
+#include "TMath.h"
+
+#include <algorithm>
+#include <iostream>
+
+MufluxRPCMatcher::MufluxRPCMatcher() : TObject()
+{
+   for (Int_t s = 0; s < kStations; s++) {
+      for (Int_t v = 0; v < kViews; v++) {
+         fZMin[s][v] = 0;
+         fZMax[s][v] = 0;
+      }
+   }
+}
+
+MufluxRPCMatcher::~MufluxRPCMatcher() {}
+
+Int_t MufluxRPCMatcher::SetHits(const TClonesArray *hits, const std::map<int, TVector3> &positions)
+{
+   for (Int_t s = 0; s < kStations; s++) {
+      for (Int_t v = 0; v < kViews; v++) {
+         fPlanes[s][v].clear();
+      }
+   }
+   Int_t n = 0;
+   for (Int_t k = 0; k < hits->GetEntriesFast(); k++) {
+      const MuonTaggerHit *hit = static_cast<const MuonTaggerHit *>(hits->UncheckedAt(k));
+      const Int_t channelID = hit->GetDetectorID();
+      const Int_t s = channelID / 10000;
+      const Int_t v = (channelID - 10000 * s) / 1000;
+      if (s < 1 || s > kStations || v < 0 || v >= kViews) {
+         std::cout << "MufluxRPCMatcher::SetHits: unknown RPC detector ID " << channelID << std::endl;
+         continue;
+      }
+      Strip strip;
+      auto position = positions.find(channelID);
+      if (position != positions.end()) {
+         strip.pos = position->second;
+      }
+      strip.c = v == 0 ? strip.pos[1] : strip.pos[0];
+      strip.hit = k;
+      fPlanes[s - 1][v].push_back(strip);
+      n++;
+   }
+   for (Int_t s = 0; s < kStations; s++) {
+      for (Int_t v = 0; v < kViews; v++) {
+         std::vector<Strip> &plane = fPlanes[s][v];
+         if (plane.empty()) {
+            continue;
+         }
+         std::stable_sort(plane.begin(), plane.end());
+         fZMin[s][v] = fZMax[s][v] = plane[0].pos[2];
+         for (auto &strip : plane) {
+            fZMin[s][v] = TMath::Min(fZMin[s][v], strip.pos[2]);
+            fZMax[s][v] = TMath::Max(fZMax[s][v], strip.pos[2]);
+         }
+      }
+   }
+   return n;
+}
+
+Int_t MufluxRPCMatcher::CountMatched(const RPCTrackLine &line, Int_t s, Int_t v, Double_t maxDistance) const
+{
+   const std::vector<Strip> &plane = fPlanes[s - 1][v];
+   if (plane.empty()) {
+      return 0;
+   }
+   // window of the line over the z range of the strips, with some room for the float arithmetic of At
+   const Double_t zMid = 0.5 * (fZMin[s - 1][v] + fZMax[s - 1][v]);
+   const Double_t slope = (v == 0 ? line.mom[1] : line.mom[0]) / line.mom[2];
+   const Double_t halfWidth = maxDistance + TMath::Abs(slope) * 0.5 * (fZMax[s - 1][v] - fZMin[s - 1][v]) + 0.1;
+   TVector3 p;
+   line.At(zMid, p);
+   Strip low, high;
+   low.c = (v == 0 ? p[1] : p[0]) - halfWidth;
+   high.c = (v == 0 ? p[1] : p[0]) + halfWidth;
+   Int_t n = 0;
+   for (auto it = std::lower_bound(plane.begin(), plane.end(), low);
+        it != plane.end() && !(high < *it); ++it) {
+      if (TMath::Abs(Predict(line, v, it->pos) - it->c) < maxDistance) {
+         n++;
+      }
+   }
+   return n;
+}
+
+ClassImp(MufluxRPCMatcher)
@@ -0,0 +1,71 @@
+#ifndef MUFLUXRPCMATCHER_H
+#define MUFLUXRPCMATCHER_H 1
+
+#include "TObject.h"
+#include "TVector3.h"
+
+#include <map>
+#include <vector>
+
+class TClonesArray;
+
+/** Straight line of a track behind the last drift tube station, the muon tagger region is field free **/
+struct RPCTrackLine {
+   TVector3 pos; // fitted state the line starts from
+   TVector3 mom;
+   /** Position at z, the same arithmetic as the linear extrapolation of MufluxReco::extrapolateToPlane */
+   void At(Float_t z, TVector3 &p) const
+   {
+      Float_t lam = (z - pos[2]) / mom[2];
+      p.SetXYZ(pos[0] + lam * mom[0], pos[1] + lam * mom[1], z);
+   }
+};
+
+/* RPC hits of an event indexed by station and view, for matching with extrapolated tracks.
+   The hits of a station and view are sorted by the measured coordinate, y of the horizontal strips
+   (view 0) and x of the vertical strips (view 1). The hits of a track are found with a binary search
+   in a window which includes the spread of the strip z positions, then checked at their own z. */
+class MufluxRPCMatcher : public TObject {
+public:
+   enum { kStations = 5, kViews = 2 };
+
+   MufluxRPCMatcher();
+   virtual ~MufluxRPCMatcher();
+
+   /** Index the Digi_MuonTaggerHits of an event, strip positions by detector ID as MufluxReco::setRPCPositions.
+    *  Hits of unknown stations or views are skipped, returns the number of indexed hits. */
+   Int_t SetHits(const TClonesArray *hits, const std::map<int, TVector3> &positions);
+
+   /** Hits of station s (1-5) and view v, in order of the measured coordinate */
+   Int_t GetNHits(Int_t s, Int_t v) const { return fPlanes[s - 1][v].size(); }
+   const TVector3 &GetPosition(Int_t s, Int_t v, Int_t i) const { return fPlanes[s - 1][v][i].pos; }
+   Int_t GetHitIndex(Int_t s, Int_t v, Int_t i) const { return fPlanes[s - 1][v][i].hit; }
+   /** Range of the strip z positions of the hits of station s and view v */
+   Double_t GetZMin(Int_t s, Int_t v) const { return fZMin[s - 1][v]; }
+   Double_t GetZMax(Int_t s, Int_t v) const { return fZMax[s - 1][v]; }
+
+   /** Measured coordinate of view v of the line at the z of a strip */
+   static Double_t Predict(const RPCTrackLine &line, Int_t v, const TVector3 &hitPos)
+   {
+      TVector3 p;
+      line.At(hitPos[2], p);
+      return v == 0 ? p[1] : p[0];
+   }
+   /** Number of hits of station s and view v closer than maxDistance to the line */
+   Int_t CountMatched(const RPCTrackLine &line, Int_t s, Int_t v, Double_t maxDistance) const;
+
+private:
+   struct Strip {
+      Double_t c; // measured coordinate
+      TVector3 pos;
+      Int_t hit;
+      bool operator<(const Strip &o) const { return c < o.c; }
+   };
+   std::vector<Strip> fPlanes[kStations][kViews]; //!
+   Double_t fZMin[kStations][kViews];             //!
+   Double_t fZMax[kStations][kViews];             //!
+
+   ClassDef(MufluxRPCMatcher, 1)
+};
+
+#endif
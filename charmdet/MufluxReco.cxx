@@ -15,24 +15,43 @@
 #include "ShipMCTrack.h"
 #include "MufluxSpectrometerHit.h"
 #include "MuonTaggerHit.h"
+#include "MufluxHistoRegistry.h"
+#include "TFile.h"
 #include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 TVector3* parallelToZ = new TVector3(0., 0., 1.);
-TVector3* NewPosition = new TVector3(0., 0., 0.);
+// genfit material effects are not thread safe, extrapolations through the spectrometer one at a time
+std::mutex genfitExtrapolation;
 std::vector<int> charmExtern = {4332,4232,4132,4232,4122,431,411,421};
 std::vector<int> beautyExtern = {5332,5232,5132,5232,5122,531,511,521};
 std::vector<int> muSources   = {221,223,333,113,331};
 // -----   Standard constructor   ------------------------------------------ 
-MufluxReco::MufluxReco() {}
+MufluxReco::MufluxReco()
+{
+  xSHiP = 0;
+  MCdata = false;
+  fRandom = 0;
+  fSeed = 13;
+}
 // -----   Standard constructor   ------------------------------------------ 
 MufluxReco::MufluxReco(TTreeReader* t)
 {
   xSHiP = t;
-  MCdata = false;
-  if (xSHiP->GetTree()->GetBranch("MCTrack")){MCdata=true;}
+  fRandom = 0;
+  fSeed = 13;
   std::cout << "MufluxReco initialized for "<<xSHiP->GetEntries(true) << " events "<<std::endl;
   xSHiP->ls();
+  setBranches();
+}
+void MufluxReco::setBranches()
+{
+  MCdata = false;
+  if (xSHiP->GetTree()->GetBranch("MCTrack")){MCdata=true;}
   FitTracks = 0;
   TrackInfos = 0;
   RPCTrackY = 0;
@@ -54,18 +73,6 @@ MufluxReco::MufluxReco(TTreeReader* t)
   fChain->SetBranchAddress("RPCTrackX", &RPCTrackX, &b_RPCTrackX);
 }
 
-/*
-std::vector<int> MufluxReco::getKeys(std::unordered_map<int,MufluxSpectrometerHit*>> map){
- std::vector<int> keys;
- keys.reserve(map.size());
- std::vector<std::string> vals;
- vals.reserve(allHits.size());
- for(auto kv : allHits) {
-    keys.push_back(kv.first);
-    vals.push_back(kv.second);
- return  keys;
-}*/
-
 // Sort and group integers in arrays iff a[j] - a[i] <= span, where j > i >=0
 std::vector<std::vector<int>> MufluxReco::GroupIntegers(std::vector<int>& input_array, size_t span) {
     if (input_array.empty())
@@ -88,148 +95,164 @@ std::vector<std::vector<int>> MufluxReco::GroupIntegers(std::vector<int>& input_
     output.emplace_back(running_array);
     return output;
 }
-/* unfinished C++ conversion
-std::map<int,std::vector<int>> viewsI = { {1,{0,1}},{2,{0,2}},{3,{0}},{4,{0}} };
-std::unordered_map<int,int> Nchannels = { {1,12},{2,12},{3,48},{4,48}};
-
-
-std::vector<std::vector<int>>  MufluxReco::findDTClusters(TClonesArray* hits, removeBigClusters=True){
-   spectrHitsSorted* = new nestedList();
-   sortHits(hits, spectrHitsSorted);
-   // if Debug: nicePrintout(spectrHitsSorted)
-   std::vector<std::vector<int>> clusters;
-   for (int s = 1; s<5; ++s) {
-    for ( auto view = viewsI[s].begin(); view != viewsI[s].end(); view++ )   {
-     std::map<int,std::unordered_map<int,MufluxSpectrometerHit*>> allHits = std::map<int,std::unordered_map<int,MufluxSpectrometerHit*>>();
-     ncl=0;
-     for ( int l = 0; l<4; l++ )   {
-      for (auto hit = spectrHitsSorted[*view][s][l].begin(); hit != spectrHitsSorted[view][s][l].end(); hit++ )   {
-       Int_t channelID = *hit->GetDetectorID()%1000;
-       allHits[l][channelID] = hit;
+namespace {
+// views and channels per station, viewsI and Nchannels of drifttubeMonitoring.py
+const std::vector<Int_t> DTViews[5] = {{}, {0,1}, {0,2}, {0}, {0}};
+const Int_t DTChannels[5] = {0, 12, 12, 48, 48};
+const Int_t DTStraws = 64; // bits of a layer bitmap
+const Int_t DTLayers = 4;
+// hits of one view, a bitmap of the channels per layer
+struct DTViewHits {
+  uint64_t bits[DTLayers];
+  MufluxSpectrometerHit* hit[DTLayers][DTStraws];
+};
+uint64_t DTChannelMask(Int_t first, Int_t last){ return (last-first+1 >= 64 ? ~0ULL : ((1ULL<<(last-first+1))-1)) << first;}
+}
+
+void MufluxReco::setStrawPositions(Int_t detID, TVector3 bot, TVector3 top){
+  Int_t index = MufluxHistoRegistry::ChannelIndex(detID);
+  if (index<0){
+    std::cout<< "setStrawPositions: detector ID outside of the table "<<detID<<std::endl;
+    return;
+  }
+  if (strawKnown.empty()){
+    strawX.assign(MufluxHistoRegistry::kStations*2*MufluxHistoRegistry::kPlanes*MufluxHistoRegistry::kLayers*MufluxHistoRegistry::kStraws,0);
+    strawZ.assign(strawX.size(),0);
+    strawKnown.assign(strawX.size(),0);
+  }
+  strawX[index] = (bot[0]+top[0])/2.;
+  strawZ[index] = (bot[2]+top[2])/2.;
+  strawKnown[index] = 1;
+}
+
+// Clusters of drift tube hits per station and view, as findDTClusters of drifttubeMonitoring.py:
+// runs of more than maxClusterSize neighbouring channels in a layer are removed as cross talk,
+// for every channel the hits of the 4 layers within +-1 channel are a cluster if 2 layers are hit,
+// hits further than 2.5cm from the mean are dropped and clusters contained in others removed.
+// The hits of a view are channel bitmaps per layer, clusters are 4 masks of the bitmaps.
+void MufluxReco::findDTClusters(TClonesArray* hits, DTClusterList* clusters, Bool_t removeBigClusters){
+ DTViewHits viewHits[5][3];
+ for (Int_t s=1;s<5;s++){ for (Int_t v=0;v<3;v++){ for (Int_t l=0;l<DTLayers;l++){ viewHits[s][v].bits[l]=0;}}}
+ for (Int_t k=0;k<hits->GetEntries();k++) {
+   MufluxSpectrometerHit* hit = (MufluxSpectrometerHit*)hits->At(k);
+   MufluxStationInfo info;
+   if (!selectHit(hit,kTRUE,info)){continue;}
+   if (info.station<1 || info.station>4 || info.channel<0 || info.channel>=DTStraws){continue;}
+   Int_t index = MufluxHistoRegistry::ChannelIndex(hit->GetDetectorID());
+   if (index<0 || strawKnown.empty() || !strawKnown[index]){
+     std::cout<< "findDTClusters: no straw position for "<<hit->GetDetectorID()<<std::endl;
+     continue;
+   }
+   DTViewHits& vh = viewHits[info.station][info.iview];
+   Int_t l = info.plane*2+info.layer;
+   vh.bits[l] |= 1ULL<<info.channel;
+   vh.hit[l][info.channel] = hit; // last hit of a channel, as in the dictionary of channels
+ }
+ Int_t maxClusterSize = cuts["maxClusterSize"];
+ DTClusterList result;
+ std::vector<std::array<uint64_t,DTLayers>> tmp;
+ std::vector<Int_t> marked;
+ for (Int_t s=1;s<5;s++){
+  for (Int_t view : DTViews[s]){
+   DTViewHits& vh = viewHits[s][view];
+   auto x = [&](Int_t l,Int_t c){ return strawX[MufluxHistoRegistry::ChannelIndex(vh.hit[l][c]->GetDetectorID())];};
+   if (removeBigClusters){
+    // kill cross talk brute force, runs of set bits
+    for (Int_t l=0;l<DTLayers;l++){
+      uint64_t w = vh.bits[l];
+      while (w){
+        Int_t first = __builtin_ctzll(w);
+        uint64_t rest = ~(w>>first);
+        Int_t size = rest ? __builtin_ctzll(rest) : 64-first;
+        uint64_t run = DTChannelMask(first,first+size-1);
+        if (size>maxClusterSize){ vh.bits[l] &= ~run;}
+        w &= ~run;
       }
+    }
+   }
+   // clusters in a window of 3 channels over the 4 layers, hits close to the mean
+   Int_t N = DTChannels[s];
+   tmp.clear();
+   for (Int_t i=1;i<N+1;i++){
+     uint64_t window = DTChannelMask(std::max(1,i-1),std::min(N,i+1));
+     std::array<uint64_t,DTLayers> cl;
+     Int_t nLayers = 0;
+     Double_t mean = 0;
+     Int_t n = 0;
+     for (Int_t l=0;l<DTLayers;l++){
+       cl[l] = vh.bits[l] & window;
+       nLayers += cl[l]!=0;
+       for (uint64_t w=cl[l];w;w&=w-1){ mean+=x(l,__builtin_ctzll(w)); n++;}
      }
-     if (removeBigClusters){
-      std::map<int,std::vector<int>>  clustersPerLayer = std::map<int,std::vector<int>>();
-      for ( int l = 0; l<4; l++ )   {
-       clustersPerLayer[l] = GroupIntegers( getKeys(allHits[l]), 1);
-       for ( auto Acl = clustersPerLayer[l].begin(); Acl!=clustersPerLayer[l].end(); Acl++ )   {
-        if ( clustersPerLayer[l][*Acl].size()>cuts["maxClusterSize"]) {
-                       // kill cross talk brute force
-          for ( auto x = clustersPerLayer[l][*Acl].begin(); x!=clustersPerLayer[l][*Acl].end(); x++ )   {
-              allHits[l].pop(*x);}
-        }
+     if (nLayers<2){continue;}
+     mean = mean/n;
+     for (Int_t l=0;l<DTLayers;l++){
+       for (uint64_t w=cl[l];w;w&=w-1){
+         Int_t c = __builtin_ctzll(w);
+         if (!(TMath::Abs(mean-x(l,c))<2.5)){ cl[l] &= ~(1ULL<<c);}
        }
-      }
      }
-     ncl=0;
-     std::unordered_map<int,std::vector<MufluxSpectrometerHit*>> tmp = std::unordered_map<int,std::vector<MufluxSpectrometerHit*>>();
-     std::unordered_map<int,std::vector<int>> perLayerUsedHits = std::unordered_map<int,std::vector<int>>();
-     int level = 1;
-     for ( int i = 1; i<Nchannels[s]+1; i++ )   {
-       std::unordered_map<int,int> perLayer = { {0,0},{1,0},{2,0},{3,0} };
-       for ( int i0 =  max(1,i-1); i0<min(Nchannels[s]+1,i+2); i0++ ) {
-        auto search = allHits[0].find(i0);
-        if (search != example.end()) {
-          tmp[ncl].push_back(allHits[0][i0]);
-          perLayer[0]=1;
-        }
-       }
-       for ( int i1 =  max(1,i-1); i1<min(Nchannels[s]+1,i+2); i1++ ) {
-        auto search = allHits[1].find(i1);
-        if (search != example.end()) {
-          tmp[ncl].push_back(allHits[1][i1]);
-          perLayer[1]=1;
-        }
-       }
-       for ( int i2 =  max(1,i-1); i2<min(Nchannels[s]+1,i+2); i2++ ) {
-        auto search = allHits[2].find(i2);
-        if (search != example.end()) {
-          tmp[ncl].push_back(allHits[2][i2]);
-          perLayer[2]=1;
-        }
-       }
-       for ( int i3 =  max(1,i-1); i3<min(Nchannels[s]+1,i+2); i3++ ) {
-        auto search = allHits[3].find(i3);
-        if (search != example.end()) {
-          tmp[ncl].push_back(allHits[3][i3]);
-          perLayer[3]=1;
-        }
+     tmp.push_back(cl);
+   }
+   // remove clusters contained in another cluster
+   marked.assign(tmp.size(),0);
+   for (size_t n1=0;n1<tmp.size();n1++){
+     if (!(tmp[n1][0]|tmp[n1][1]|tmp[n1][2]|tmp[n1][3])){continue;}
+     for (size_t n2=0;n2<tmp.size();n2++){
+       if (n1==n2 || marked[n2]){continue;}
+       if (!((tmp[n1][0]&~tmp[n2][0])|(tmp[n1][1]&~tmp[n2][1])|(tmp[n1][2]&~tmp[n2][2])|(tmp[n1][3]&~tmp[n2][3]))){
+         marked[n1] = 1;
+         break;
        }
-       if ( (perLayer[0]+perLayer[1]+perLayer[2]+perLayer[3]) > level){
-       // at least 2 hits per station
-        ncl+=1;
+     }
+   }
+   std::vector<DTCluster>& viewClusters = result[s][view];
+   for (size_t n1=0;n1<tmp.size();n1++){
+     Int_t n = 0;
+     for (Int_t l=0;l<DTLayers;l++){ n+=__builtin_popcountll(tmp[n1][l]);}
+     if (n<2 || marked[n1]){continue;}
+     Double_t mean = 0;
+     for (Int_t l=0;l<DTLayers;l++){ for (uint64_t w=tmp[n1][l];w;w&=w-1){ mean+=x(l,__builtin_ctzll(w));}}
+     mean = mean/n;
+     DTCluster cl;
+     for (Int_t l=0;l<DTLayers;l++){
+       for (uint64_t w=tmp[n1][l];w;w&=w-1){
+         Int_t c = __builtin_ctzll(w);
+         MufluxSpectrometerHit* hit = vh.hit[l][c];
+         Int_t index = MufluxHistoRegistry::ChannelIndex(hit->GetDetectorID());
+         if (TMath::Abs(mean-strawX[index])<2.5){ cl.push_back({hit,strawX[index],strawZ[index],hit->GetDetectorID()%1000});}
        }
      }
-// cleanup, outliers
-     tmpClean = {}
-     for ( int ncl = 0; ncl<tmp.size(); ncl++ ) {
-       std::unordered_map<int,std::vector<int>> tmp = std::unordered_map<int,std::vector<int>>();
-       mean = 0;
-       for (auto hit = tmp[ncl].begin(); hit != tmp[ncl].end(); hit++ )   {
-          bot,top =  strawPositionsBotTop[hit.GetDetectorID()]
-          x = (bot[0]+top[0])/2.
-          mean+=x
-          test.append([hit,x])
-       mean=mean/float(len(test))
-# more cleanup, outliers
-       tmpClean[ncl]=[]
-       for cl in test:
-          if abs(mean-cl[1])<2.5 : 
-            tmpClean[ncl].append(cl[0])
-# cleanup, remove lists contained in another list
-     clusters[s][view]=[]
-     if len(tmpClean)>0:
-      ncl = 0
-      marked = []
-      for n1 in range(len(tmpClean)):
-        if len(tmpClean[n1])==0: continue
-        contained = False
-        for n2 in range(len(tmpClean)):
-          if n1==n2: continue
-          if n2 in marked: continue
-          if set(tmpClean[n1]) <= set(tmpClean[n2]):
-           contained = True
-           break
-        if contained:  marked.append(n1)
-      for n1 in range(len(tmpClean)):
-         if len(tmpClean[n1])<2: continue
-         if n1 in marked: continue
-         test = []
-         mean = 0
-         for hit in tmpClean[n1]:
-          bot,top =  strawPositionsBotTop[hit.GetDetectorID()]
-          x = (bot[0]+top[0])/2.
-          z = (bot[2]+top[2])/2.
-          mean+=x
-          test.append([hit,x,z,hit.GetDetectorID()%1000])
-         mean=mean/float(len(test))
-# more cleanup, outliers
-         clusters[s][view].append([])
-         for cl in test:
-          if abs(mean-cl[1])<2.5: clusters[s][view][ncl].append(cl)
-         if len(clusters[s][view][ncl])==0:
-           clusters[s][view].pop(ncl)
-         else: ncl+=1
-     rc = h['clsN'].Fill(ncl)
-# eventually split too big clusters for stero layers:
-   for s in [1,2]:
-    for view in viewsI[s]:
-     if view==0:continue
-     tmp = {}
-     for cl in clusters[s][view]:
-      if len(cl)>5:
-       for hit in cl: 
-         if not tmp.has_key(hit[3]):tmp[hit[3]]=[]
-         tmp[hit[3]].append(hit)
-     for n in tmp:
-       if len(tmp[n])>1:
-         clusters[s][view].append(tmp[n])
-   if Debug: 
-    for s in range(1,5):
-     for view in viewsI[s]:
-      printClustersPerStation(clusters,s,view)
-   return clusters
-*/
+     if (!cl.empty()){viewClusters.push_back(cl);}
+   }
+  }
+ }
+ *clusters = result;
+}
+
+// eventually split too big clusters of the stereo views into clusters per channel
+void MufluxReco::splitStereoClusters(DTClusterList* clusters){
+ for (Int_t s=1;s<3;s++){
+  for (Int_t view : DTViews[s]){
+   if (view==0){continue;}
+   std::vector<DTCluster>& viewClusters = (*clusters)[s][view];
+   std::map<Int_t,DTCluster> tmp;
+   for (auto& cl : viewClusters){
+     if (cl.size()<6){continue;}
+     for (auto& hit : cl){
+       DTCluster& perChannel = tmp[hit.channel];
+       Bool_t known = kFALSE;
+       for (auto& other : perChannel){ if (other.hit->GetDetectorID()==hit.hit->GetDetectorID()){known = kTRUE;}}
+       if (!known){perChannel.push_back(hit);}
+     }
+   }
+   for (auto& perChannel : tmp){
+     if (perChannel.second.size()>1){viewClusters.push_back(perChannel.second);}
+   }
+  }
+ }
+}
+
 Bool_t MufluxReco::checkCharm(){
    Bool_t check = false;
    for (Int_t m=0;m<MCTrack->GetEntries();m++) {
@@ -239,12 +262,12 @@ Bool_t MufluxReco::checkCharm(){
    }
    return check;
 }
-Int_t MufluxReco::checkDiMuon(){
+Int_t MufluxReco::checkDiMuon(TH2D* h_weightVsSource){
    Int_t mode = -1;
    Int_t channel = -1;
    std::vector<int> processed;
    Double_t weight;
-   TH2D* h_weightVsSource=(TH2D*)(gDirectory->GetList()->FindObject("weightVsSource"));
+   if (!h_weightVsSource){h_weightVsSource=(TH2D*)(gDirectory->GetList()->FindObject("weightVsSource"));}
    for (Int_t n=0;n<MufluxSpectrometerPoints->GetEntries();n++) {
       MufluxSpectrometerPoint* hit = (MufluxSpectrometerPoint*)MufluxSpectrometerPoints->At(n);
       Int_t i = hit->GetTrackID();
@@ -304,51 +327,75 @@ Bool_t MufluxReco::findSimpleEvent(Int_t nmin, Int_t nmax){
    return passed;
 }
 
-void MufluxReco::RPCextrap(Int_t nMax){
- Int_t N = xSHiP->GetEntries(true);
- TTree* sTree = xSHiP->GetTree();
- if (nMax<0){nMax=N;}
- xSHiP->Restart();
- gROOT->cd();
- std::cout<< "make RPC analysis: "<< N <<std::endl;
- std::map<int,TH2D*> h_RPCResX;
- std::map<int,TH2D*> h_RPCResY;
- std::map<int,TH1D*> h_RPCextTrack;
- std::map<int,TH1D*> h_RPCfired;
- std::map<int,TH1D*> h_RPCfired_or;
- std::map<int,TH1D*> h_RPC;
+void MufluxReco::resolveRPCAnalysis(MufluxRPCAnalysis& a){
+ // histograms indexed by station 1-5 and view 0-1
+ a = MufluxRPCAnalysis();
  TString hname;
  for ( int s = 1; s<6; s++ )   {
   for ( int v = 0; v<2; v++ )   {
    hname = "RPCResY_";
-   h_RPCResY[s*10+v]=(TH2D*)(gDirectory->GetList()->FindObject(hname+=(s*10+v)));
+   a.resY[s][v]=(TH2D*)(gDirectory->GetList()->FindObject(hname+=(s*10+v)));
    hname = "RPCResX_";
-   h_RPCResX[s*10+v]=(TH2D*)(gDirectory->GetList()->FindObject(hname+=(s*10+v)));
+   a.resX[s][v]=(TH2D*)(gDirectory->GetList()->FindObject(hname+=(s*10+v)));
    hname = "RPCextTrack_";
-   h_RPCextTrack[s*10+v]=(TH1D*)(gDirectory->GetList()->FindObject(hname+=(s*10+v)));
+   a.extTrack[s][v]=(TH1D*)(gDirectory->GetList()->FindObject(hname+=(s*10+v)));
    hname = "RPCfired_";
-   h_RPCfired[s*10+v]=(TH1D*)(gDirectory->GetList()->FindObject(hname+=(s*10+v)));
+   a.fired[s][v]=(TH1D*)(gDirectory->GetList()->FindObject(hname+=(s*10+v)));
   }
   hname = "RPCfired_or_";
-  h_RPCfired_or[s]=(TH1D*)(gDirectory->GetList()->FindObject(hname+=(s)));
+  a.firedOr[s]=(TH1D*)(gDirectory->GetList()->FindObject(hname+=(s)));
   }
  for ( int k = 2; k<20; k++ )   {
   hname = "RPC<";hname+=(k);hname+="_p";
-  h_RPC[k]=(TH1D*)(gDirectory->GetList()->FindObject(hname));
+  a.nMatched[k]=(TH1D*)(gDirectory->GetList()->FindObject(hname));
  }
- TH1D* h_RPC_p =  (TH1D*)(gDirectory->GetList()->FindObject("RPC_p"));
- TH2D* h_RPCResX1_p =  (TH2D*)(gDirectory->GetList()->FindObject("RPCResX1_p"));
- TH2D* h_RPC_2XY =  (TH2D*)(gDirectory->GetList()->FindObject("RPC<2XY"));
- TH3D* h_RPCMatchedHits =  (TH3D*)(gDirectory->GetList()->FindObject("RPCMatchedHits"));
+ a.p =  (TH1D*)(gDirectory->GetList()->FindObject("RPC_p"));
+ a.resX1p =  (TH2D*)(gDirectory->GetList()->FindObject("RPCResX1_p"));
+ a.xy2 =  (TH2D*)(gDirectory->GetList()->FindObject("RPC<2XY"));
+ a.matchedHits =  (TH3D*)(gDirectory->GetList()->FindObject("RPCMatchedHits"));
+ a.maxDistance = cuts["RPCmaxDistance"];
+ a.zRPC1 = cuts["zRPC1"];
+ a.xLRPC1 = cuts["xLRPC1"];
+ a.xRRPC1 = cuts["xRRPC1"];
+ a.yBRPC1 = cuts["yBRPC1"];
+ a.yTRPC1 = cuts["yTRPC1"];
+ a.zLinear = cuts["lastDTStation_z"] + 10;
+ a.linear = cuts["RPClinearExtrapolation"]>0;
+ a.skipResiduals = cuts["RPCskipResiduals"]>0;
+}
 
+void MufluxReco::RPCextrap(Int_t nMax){
+ Int_t N = xSHiP->GetEntries(true);
+ TTree* sTree = xSHiP->GetTree();
+ if (nMax<0){nMax=N;}
+ xSHiP->Restart();
+ gROOT->cd();
+ std::cout<< "make RPC analysis: "<< N <<std::endl;
+ MufluxRPCAnalysis a;
+ resolveRPCAnalysis(a);
  Int_t nx = 0;
  while (nx<nMax){
    sTree->GetEvent(nx);
    nx+=1;
+   RPCextrapEvent(a);
+ }
+}
+
+void MufluxReco::rpcTrackLine(genfit::Track* aTrack, RPCTrackLine& line){
+ // state of extrapolateToPlane for z behind the last station, taken once per track
+ Int_t nmeas = aTrack->getNumPointsWithMeasurement();
+ Int_t M = TMath::Min(nmeas-1,30);
+ genfit::StateOnPlane fstate = aTrack->getFittedState(M);
+ line.pos = fstate.getPos();
+ line.mom = fstate.getMom();
+}
+
+void MufluxReco::RPCextrapEvent(const MufluxRPCAnalysis& a){
    Int_t Nhits = Digi_MuonTaggerHits->GetEntries();
-   if (Nhits==0){ continue;}
+   if (Nhits==0){ return;}
    Int_t Ntracks = FitTracks->GetEntries();
-   if (!findSimpleEvent(2,6)){continue;}
+   if (!findSimpleEvent(2,6)){return;}
+   rpcMatcher.SetHits(Digi_MuonTaggerHits,RPCPositions);
    for (Int_t tr=0;tr<Ntracks;tr++) {
      genfit::Track* aTrack = (genfit::Track*)FitTracks->At(tr);
      auto fitStatus   = aTrack->getFitStatus();
@@ -363,32 +410,46 @@ void MufluxReco::RPCextrap(Int_t nMax){
      Double_t pMom0 = aTrack->getFittedState(0).getMomMag();
      if (pMom0 < 1.){continue;}
 
-     std::map<int,std::vector<int>> matchedHits;
+     // number of matched hits per station and view
+     Int_t matchedHits[6][2] = {};
      TVector3 posRPC;TVector3 pos1; TVector3 momRPC;
-     Double_t rc = MufluxReco::extrapolateToPlane(aTrack,cuts["zRPC1"], pos1, momRPC);
+     RPCTrackLine line;
+     rpcTrackLine(aTrack,line);
+     if (a.linear || a.zRPC1 >= a.zLinear){ line.At(a.zRPC1,pos1);}
+     else { MufluxReco::extrapolateToPlane(aTrack,a.zRPC1, pos1, momRPC);}
      Bool_t inAcc = kFALSE;
-     if (pos1[0]>cuts["xLRPC1"] && pos1[0]<cuts["xRRPC1"] && pos1[1]>cuts["yBRPC1"] && pos1[1]<cuts["yTRPC1"]){
+     if (pos1[0]>a.xLRPC1 && pos1[0]<a.xRRPC1 && pos1[1]>a.yBRPC1 && pos1[1]<a.yTRPC1){
        inAcc=kTRUE;}
-     for (Int_t nHit=0;nHit<Nhits;nHit++) {
-        MuonTaggerHit* hit = (MuonTaggerHit*)Digi_MuonTaggerHits->At(nHit);
-        Int_t channelID = hit->GetDetectorID();
-        Int_t s  = channelID/10000;
-        Int_t v  = (channelID-10000*s)/1000;
-        Float_t z = RPCPositions[channelID][2];
-        rc = MufluxReco::extrapolateToPlane(aTrack, z, posRPC, momRPC);
-        Double_t res;
-        if (v==0){
-          res = posRPC[1]-RPCPositions[channelID][1];
-          h_RPCResY[10*s+v]->Fill(res,RPCPositions[channelID][1]);
-        } else {
-          res = posRPC[0]-RPCPositions[channelID][0];
-          h_RPCResX[10*s+v]->Fill(res,RPCPositions[channelID][0]);
-          if(s==1){ h_RPCResX1_p->Fill(res,pMom0);}
+     for (Int_t s=1;s<6;s++) {
+      for (Int_t v=0;v<2;v++) {
+        Int_t n = rpcMatcher.GetNHits(s,v);
+        if (n==0){continue;}
+        // field free behind the stations: straight line
+        Bool_t straight = a.linear || Float_t(rpcMatcher.GetZMin(s,v)) >= a.zLinear;
+        if (straight && a.skipResiduals){
+          // only the matched hits, binary search in the index without visiting the other hits
+          matchedHits[s][v] = rpcMatcher.CountMatched(line,s,v,a.maxDistance);
+          continue;
         }
-        if (TMath::Abs(res) < cuts["RPCmaxDistance"]){
-           matchedHits[s*10+v].push_back(nHit);
+        for (Int_t i=0;i<n;i++) {
+          const TVector3& hitPos = rpcMatcher.GetPosition(s,v,i);
+          if (straight){ line.At(hitPos[2],posRPC);}
+          else { MufluxReco::extrapolateToPlane(aTrack, hitPos[2], posRPC, momRPC);}
+          Double_t res;
+          if (v==0){
+            res = posRPC[1]-hitPos[1];
+            a.resY[s][v]->Fill(res,hitPos[1]);
+          } else {
+            res = posRPC[0]-hitPos[0];
+            a.resX[s][v]->Fill(res,hitPos[0]);
+            if(s==1){ a.resX1p->Fill(res,pMom0);}
+          }
+          if (TMath::Abs(res) < a.maxDistance){
+             matchedHits[s][v]+=1;
+          }
         }
        }
+     }
        // record number of hits per station and view and track momentum
        // but only for tracks in acceptance
        if (inAcc){
@@ -401,28 +462,27 @@ void MufluxReco::RPCextrap(Int_t nMax){
 */
         for (Int_t k=1;k<5;k++) {
          for (Int_t v=0;v<2;v++) {
-           if( matchedHits[ (k+1)*10+v].size()==0){continue;}
-           h_RPCextTrack[10*k+v]->Fill(p);
-           if ( matchedHits[k*10+v].size()>0){h_RPCfired[10*k+v]->Fill(p);}
+           if( matchedHits[k+1][v]==0){continue;}
+           a.extTrack[k][v]->Fill(p);
+           if ( matchedHits[k][v]>0){a.fired[k][v]->Fill(p);}
            if (v==0){
-             if ( matchedHits[k*10+v].size()>0 || matchedHits[k*10+v+1].size()>0){ h_RPCfired_or[k]->Fill(p);}
+             if ( matchedHits[k][v]>0 || matchedHits[k][v+1]>0){ a.firedOr[k]->Fill(p);}
            }
           }
         }
         for (Int_t s=1;s<6;s++) {
          for (Int_t v=0;v<2;v++) {
-          h_RPCMatchedHits->Fill(2*s-1+v,matchedHits[s*10+v].size(),p);
-          Nmatched+=matchedHits[s*10+v].size();
+          a.matchedHits->Fill(2*s-1+v,matchedHits[s][v],p);
+          Nmatched+=matchedHits[s][v];
          }
         }
-        if ( Nmatched <2 && p>30){ h_RPC_2XY->Fill(pos1[0],pos1[1]);}
-        h_RPC_p->Fill(p);
+        if ( Nmatched <2 && p>30){ a.xy2->Fill(pos1[0],pos1[1]);}
+        a.p->Fill(p);
         for (Int_t k=2;k<20;k++) {
-         if (Nmatched<k) {h_RPC[k]->Fill(p);}
+         if (Nmatched<k) {a.nMatched[k]->Fill(p);}
         }
       }
   } // end track loop
- } // end event loop
 }
 
 Double_t MufluxReco::extrapolateToPlane(genfit::Track* fT,Float_t z, TVector3& pos, TVector3& mom){
@@ -443,14 +503,15 @@ Double_t MufluxReco::extrapolateToPlane(genfit::Track* fT,Float_t z, TVector3& p
       }
     }
     genfit::StateOnPlane fstate =  fT->getFittedState(mClose);
-    NewPosition->SetXYZ(0., 0., z);
+    TVector3 NewPosition(0., 0., z);
+    std::lock_guard<std::mutex> lock(genfitExtrapolation);
     Int_t pdgcode = -int(13*fstate.getCharge());
     genfit::RKTrackRep* rep      = new genfit::RKTrackRep( pdgcode );
     genfit::StateOnPlane* state   = new genfit::StateOnPlane(rep);
     auto Pos = fstate.getPos();
     auto Mom = fstate.getMom();
     rep->setPosMom(*state,Pos,Mom);
-    rc = rep->extrapolateToPlane(*state, *NewPosition, *parallelToZ );
+    rc = rep->extrapolateToPlane(*state, NewPosition, *parallelToZ );
     pos = (state->getPos());
     mom = (state->getMom());
     delete rep;
@@ -480,10 +541,8 @@ StringVecIntMap MufluxReco::countMeasurements(TrackInfo* trInfo){
  StringVecIntMap mStatistics = StringVecIntMap();
  for (Int_t n=0;n<trInfo->N();n++) {
     Int_t detID = trInfo->detId(n);
-    MufluxSpectrometerHit* hit = new MufluxSpectrometerHit(detID,0);
-    auto info = hit->StationInfo();
-    delete hit;
-    Int_t s=info[0]; Int_t v=info[4]; Int_t p=info[2]; Int_t l=info[3]; Int_t channelNr=info[5]; 
+    auto info = MufluxSpectrometerHit::GetStationInfo(detID);
+    Int_t s=info.station; Int_t v=info.iview; Int_t p=info.plane; Int_t l=info.layer; Int_t channelNr=info.channel; 
     if (trInfo->wL(n) <0.1 && trInfo->wR(n) <0.1){ continue;}
     if (v != 0){ 
        mStatistics["uv"].push_back(detID);
@@ -503,6 +562,29 @@ StringVecIntMap MufluxReco::countMeasurements(TrackInfo* trInfo){
  return mStatistics;
 }
 
+void MufluxReco::resolveKinematicsAnalysis(MufluxKinematicsAnalysis& a, Float_t chi2UL){
+ a = MufluxKinematicsAnalysis();
+ a.scalers =  (TH1D*)(gDirectory->GetList()->FindObject("Trscalers"));
+ a.weightVsSource = (TH2D*)(gDirectory->GetList()->FindObject("weightVsSource"));
+ // source 0 is all tracks, 1-6 the channels of checkDiMuon
+ std::vector<TString> h1names = {"chi2","Nmeasurements","TrackMult"};
+ std::vector<TString> h2names = {"p/pt","p/px","p/Abspx","xy","pxpy","p1/p2","pt1/pt2","p1/p2s","pt1/pt2s"};
+ std::vector<TString> tagged  = {"","mu"};
+ std::vector<TString> Tsource  = {"","Decay","Hadronic inelastic","Lepton pair","Positron annihilation","charm","beauty"};
+ for (UInt_t is=0;is<Tsource.size();is++) {
+  for (UInt_t it=0;it<tagged.size();it++) {
+   for (UInt_t i1=0;i1<h1names.size();i1++) {
+    a.h1D[i1][it][is] = (TH1D*)(gDirectory->GetList()->FindObject(h1names[i1]+tagged[it]+Tsource[is]));}
+   for (UInt_t i2=0;i2<h2names.size();i2++) {
+    a.h2D[i2][it][is] = (TH2D*)(gDirectory->GetList()->FindObject(h2names[i2]+tagged[it]+Tsource[is]));}
+  }
+ }
+ a.chi2UL = chi2UL;
+ a.zRPC1 = cuts["zRPC1"];
+ a.muTrackMatchX = cuts["muTrackMatchX"];
+ a.muTrackMatchY = cuts["muTrackMatchY"];
+}
+
 void MufluxReco::trackKinematics(Float_t chi2UL, Int_t nMax){
  Int_t N = xSHiP->GetEntries(true);
  TTree* sTree = xSHiP->GetTree();
@@ -510,59 +592,39 @@ void MufluxReco::trackKinematics(Float_t chi2UL, Int_t nMax){
  xSHiP->Restart();
  gROOT->cd();
  std::cout<< "fill trackKinematics: "<< N <<std::endl;
-
- TH1D* h_Trscalers =  (TH1D*)(gDirectory->GetList()->FindObject("Trscalers"));
-
- std::map<TString,TH1D*> h1D;
- std::map<TString,TH2D*> h2D;
- std::vector<TString> h1names = {"chi2","Nmeasurements","TrackMult"};
- std::vector<TString> h2names = {"p/pt","p/px","p/Abspx","xy","pxpy","p1/p2","pt1/pt2","p1/p2s","pt1/pt2s"};
- std::vector<TString> tagged  = {"","mu"};
- std::vector<TString> Tsource  = {"","Decay","Hadronic inelastic","Lepton pair","Positron annihilation","charm","beauty"};
-
- std::vector<TString>::iterator its = Tsource.begin();
- while( its!=Tsource.end()){
-  std::vector<TString>::iterator itt = tagged.begin();
-  while( itt!=tagged.end()){
-   std::vector<TString>::iterator it1 = h1names.begin();
-   while( it1!=h1names.end()){
-    TString hname = *it1+*itt+*its; 
-    h1D[hname] = (TH1D*)(gDirectory->GetList()->FindObject(hname));
-    it1++;}
-   std::vector<TString>::iterator it2 = h2names.begin();
-   while( it2!=h2names.end()){
-    TString hname = *it2+*itt+*its;
-    h2D[hname] = (TH2D*)(gDirectory->GetList()->FindObject(hname));
-    it2++;}
-   itt++;}
-  its++;}
-
+ MufluxKinematicsAnalysis a;
+ resolveKinematicsAnalysis(a,chi2UL);
  Int_t nx = 0;
  while (nx<nMax){
    sTree->GetEvent(nx);
-   h_Trscalers->Fill(1);
    nx+=1;
+   trackKinematicsEvent(a);
+ }
+}
+
+namespace {
+// histogram index of trackKinematics
+enum {kChi2, kNmeasurements, kTrackMult};
+enum {kPPt, kPPx, kPAbsPx, kXY, kPxPy, kP1P2, kPt1Pt2, kP1P2s, kPt1Pt2s};
+}
+
+void MufluxReco::trackKinematicsEvent(const MufluxKinematicsAnalysis& a){
+   a.scalers->Fill(1);
    Int_t Ntracks = FitTracks->GetEntries();
    Int_t Ngood = 0;
    Int_t Ngoodmu = 0;
-   if(Ntracks>0){ h_Trscalers->Fill(2);}
+   if(Ntracks>0){ a.scalers->Fill(2);}
    std::vector<int> muonTaggedTracks;
-   TString source = "";
-   if (MCdata){ Int_t channel = checkDiMuon();
-         if (channel == 1){ source = "Decay";}
-         if (channel == 2){ source = "Hadronic inelastic";}
-         if (channel == 3){ source = "Lepton pair";}
-         if (channel == 4){ source = "Positron annihilation";}
-         if (channel == 5){ source = "charm";}
-         if (channel == 6){ source = "beauty";}
+   Int_t source = 0;
+   if (MCdata){ Int_t channel = checkDiMuon(a.weightVsSource);
+         if (channel > 0 && channel < 7){ source = channel;}
    }
-   Bool_t fSource= kFALSE;
-   if ( strcmp("", source.Data())!=0 ){fSource=kTRUE;}
+   Bool_t fSource = source > 0;
    for (Int_t k=0;k<Ntracks;k++) {
      genfit::Track* aTrack = (genfit::Track*)FitTracks->At(k);
      auto fitStatus   = aTrack->getFitStatus();
 // track quality
-     h_Trscalers->Fill(3);
+     a.scalers->Fill(3);
      if (!fitStatus->isFitConverged()){continue;}
      TrackInfo* info = (TrackInfo*)TrackInfos->At(k);
      StringVecIntMap hitsPerStation = countMeasurements(info);
@@ -573,7 +635,7 @@ void MufluxReco::trackKinematics(Float_t chi2UL, Int_t nMax){
        bool failed = false;
        for ( it = detectors.begin(); it != detectors.end(); it++ ){
         for ( int m=0; m<hitsPerStation[it->first.Data()].size();m+=1){
-         float rnr = gRandom->Uniform();
+         float rnr = random()->Uniform();
          float eff = effFudgeFac[it->first.Data()];
          if (rnr < eff){detectors[it->first.Data()]+=1;}
         }
@@ -587,63 +649,63 @@ void MufluxReco::trackKinematics(Float_t chi2UL, Int_t nMax){
      if (hitsPerStation["x2"].size()<2){ continue;}
      if (hitsPerStation["x3"].size()<2){ continue;}
      if (hitsPerStation["x4"].size()<2){ continue;}
-     h_Trscalers->Fill(4);
+     a.scalers->Fill(4);
      auto chi2 = fitStatus->getChi2()/fitStatus->getNdf();
      auto fittedState = aTrack->getFittedState();
      Float_t P = fittedState.getMomMag();
      Float_t Px = fittedState.getMom().x();
      Float_t Py = fittedState.getMom().y();
      Float_t Pz = fittedState.getMom().z();
-     h1D["chi2"]->Fill(chi2);
-     h1D["Nmeasurements"]->Fill(fitStatus->getNdf());
+     a.h1D[kChi2][0][0]->Fill(chi2);
+     a.h1D[kNmeasurements][0][0]->Fill(fitStatus->getNdf());
      if (fSource){
-        h1D["chi2"+source]->Fill(chi2);
-        h1D["Nmeasurements"+source]->Fill(fitStatus->getNdf());}
-     if (chi2 > chi2UL){ continue;}
-     h_Trscalers->Fill(5);
+        a.h1D[kChi2][0][source]->Fill(chi2);
+        a.h1D[kNmeasurements][0][source]->Fill(fitStatus->getNdf());}
+     if (chi2 > a.chi2UL){ continue;}
+     a.scalers->Fill(5);
      auto pos = fittedState.getPos();
-     h2D["p/pt"]->Fill(P,TMath::Sqrt(Px*Px+Py*Py));
-     h2D["p/px"]->Fill(P,Px);
-     h2D["p/Abspx"]->Fill(P,TMath::Abs(Px));
-     h2D["xy"]->Fill(pos[0],pos[1]);
-     h2D["pxpy"]->Fill(Px/Pz,Py/Pz);
+     a.h2D[kPPt][0][0]->Fill(P,TMath::Sqrt(Px*Px+Py*Py));
+     a.h2D[kPPx][0][0]->Fill(P,Px);
+     a.h2D[kPAbsPx][0][0]->Fill(P,TMath::Abs(Px));
+     a.h2D[kXY][0][0]->Fill(pos[0],pos[1]);
+     a.h2D[kPxPy][0][0]->Fill(Px/Pz,Py/Pz);
      if (fSource){
-      h2D["p/pt"+source]->Fill(P,TMath::Sqrt(Px*Px+Py*Py));
-      h2D["p/px"+source]->Fill(P,Px);
-      h2D["p/Abspx"+source]->Fill(P,TMath::Abs(Px));
-      h2D["xy"+source]->Fill(pos[0],pos[1]);
-      h2D["pxpy"+source]->Fill(Px/Pz,Py/Pz);
+      a.h2D[kPPt][0][source]->Fill(P,TMath::Sqrt(Px*Px+Py*Py));
+      a.h2D[kPPx][0][source]->Fill(P,Px);
+      a.h2D[kPAbsPx][0][source]->Fill(P,TMath::Abs(Px));
+      a.h2D[kXY][0][source]->Fill(pos[0],pos[1]);
+      a.h2D[kPxPy][0][source]->Fill(Px/Pz,Py/Pz);
      }
     if (P>5){Ngood+=1;}
 // check for muon tag
      TVector3 posRPC; TVector3 momRPC;
-     Double_t rc = MufluxReco::extrapolateToPlane(aTrack,cuts["zRPC1"], posRPC, momRPC);
+     Double_t rc = MufluxReco::extrapolateToPlane(aTrack,a.zRPC1, posRPC, momRPC);
      Bool_t X = kFALSE;
      Bool_t Y = kFALSE;
      for (Int_t mu=0;mu<RPCTrackX->GetEntries();mu++) {
         RPCTrack *hit = (RPCTrack*)RPCTrackX->At(mu);
-        X = hit->m()*cuts["zRPC1"]+hit->b();
-        if (TMath::Abs(posRPC[0]-X)<cuts["muTrackMatchX"]){X=kTRUE;}
+        X = hit->m()*a.zRPC1+hit->b();
+        if (TMath::Abs(posRPC[0]-X)<a.muTrackMatchX){X=kTRUE;}
      }
      for (Int_t mu=0;mu<RPCTrackY->GetEntries();mu++) {
         RPCTrack *hit = (RPCTrack*)RPCTrackY->At(mu);
-        Y = hit->m()*cuts["zRPC1"]+hit->b();
-        if (TMath::Abs(posRPC[1]-X)<cuts["muTrackMatchY"]){Y=kTRUE;}
+        Y = hit->m()*a.zRPC1+hit->b();
+        if (TMath::Abs(posRPC[1]-X)<a.muTrackMatchY){Y=kTRUE;}
      }
       if (X && Y) { // within ~3sigma  X,Y from mutrack
-        h1D["chi2mu"]->Fill(chi2);
-        h1D["Nmeasurementsmu"]->Fill(fitStatus->getNdf());
-        h2D["p/ptmu"]->Fill(P,TMath::Sqrt(Px*Px+Py*Py));
-        h2D["p/pxmu"]->Fill(P,Px);
-        h2D["p/Abspxmu"]->Fill(P,TMath::Abs(Px));
-        h2D["xymu"]->Fill(pos[0],pos[1]);
-        h2D["pxpymu"]->Fill(Px/Pz,Py/Pz);
+        a.h1D[kChi2][1][0]->Fill(chi2);
+        a.h1D[kNmeasurements][1][0]->Fill(fitStatus->getNdf());
+        a.h2D[kPPt][1][0]->Fill(P,TMath::Sqrt(Px*Px+Py*Py));
+        a.h2D[kPPx][1][0]->Fill(P,Px);
+        a.h2D[kPAbsPx][1][0]->Fill(P,TMath::Abs(Px));
+        a.h2D[kXY][1][0]->Fill(pos[0],pos[1]);
+        a.h2D[kPxPy][1][0]->Fill(Px/Pz,Py/Pz);
         if (fSource){
-         h2D["p/ptmu"+source]->Fill(P,TMath::Sqrt(Px*Px+Py*Py));
-         h2D["p/pxmu"+source]->Fill(P,Px);
-         h2D["p/Abspxmu"+source]->Fill(P,TMath::Abs(Px));
-         h2D["xymu"+source]->Fill(pos[0],pos[1]);
-         h2D["pxpymu"+source]->Fill(Px/Pz,Py/Pz);
+         a.h2D[kPPt][1][source]->Fill(P,TMath::Sqrt(Px*Px+Py*Py));
+         a.h2D[kPPx][1][source]->Fill(P,Px);
+         a.h2D[kPAbsPx][1][source]->Fill(P,TMath::Abs(Px));
+         a.h2D[kXY][1][source]->Fill(pos[0],pos[1]);
+         a.h2D[kPxPy][1][source]->Fill(Px/Pz,Py/Pz);
         }
         if (P>5){
          Ngoodmu+=1;
@@ -651,11 +713,11 @@ void MufluxReco::trackKinematics(Float_t chi2UL, Int_t nMax){
         }
       }
      }
-     h1D["TrackMult"]->Fill(Ngood);
-     h1D["TrackMultmu"]->Fill(Ngoodmu);
+     a.h1D[kTrackMult][0][0]->Fill(Ngood);
+     a.h1D[kTrackMult][1][0]->Fill(Ngoodmu);
      if (fSource){
-      h1D["TrackMult"+source]->Fill(Ngood);
-      h1D["TrackMultmu"+source]->Fill(Ngoodmu);
+      a.h1D[kTrackMult][0][source]->Fill(Ngood);
+      a.h1D[kTrackMult][1][source]->Fill(Ngoodmu);
      }
      if (muonTaggedTracks.size()==2){
       genfit::Track* aTrack = (genfit::Track*)FitTracks->At(muonTaggedTracks[0]);
@@ -671,111 +733,280 @@ void MufluxReco::trackKinematics(Float_t chi2UL, Int_t nMax){
       Float_t Py = fittedState.getMom().y();
       Float_t Pz = fittedState.getMom().z();
       if (fittedStateb.getCharge()*fittedState.getCharge()<0){
-       h2D["p1/p2"]->Fill(P,Pb);
-       h2D["pt1/pt2"]->Fill(TMath::Sqrt(Px*Px+Py*Py),TMath::Sqrt(Pbx*Pbx+Pby*Pby));
+       a.h2D[kP1P2][0][0]->Fill(P,Pb);
+       a.h2D[kPt1Pt2][0][0]->Fill(TMath::Sqrt(Px*Px+Py*Py),TMath::Sqrt(Pbx*Pbx+Pby*Pby));
        if (fSource){
-         h2D["p1/p2"+source]->Fill(P,Pb);
-         h2D["pt1/pt2"+source]->Fill(TMath::Sqrt(Px*Px+Py*Py),TMath::Sqrt(Pbx*Pbx+Pby*Pby));
+         a.h2D[kP1P2][0][source]->Fill(P,Pb);
+         a.h2D[kPt1Pt2][0][source]->Fill(TMath::Sqrt(Px*Px+Py*Py),TMath::Sqrt(Pbx*Pbx+Pby*Pby));
        }
       }else{
-       h2D["p1/p2s"]->Fill(P,Pb);
-       h2D["pt1/pt2s"]->Fill(TMath::Sqrt(Px*Px+Py*Py),TMath::Sqrt(Pbx*Pbx+Pby*Pby));
+       a.h2D[kP1P2s][0][0]->Fill(P,Pb);
+       a.h2D[kPt1Pt2s][0][0]->Fill(TMath::Sqrt(Px*Px+Py*Py),TMath::Sqrt(Pbx*Pbx+Pby*Pby));
        if (fSource){
-         h2D["p1/p2s"+source]->Fill(P,Pb);
-         h2D["pt1/pt2s"+source]->Fill(TMath::Sqrt(Px*Px+Py*Py),TMath::Sqrt(Pbx*Pbx+Pby*Pby));
+         a.h2D[kP1P2s][0][source]->Fill(P,Pb);
+         a.h2D[kPt1Pt2s][0][source]->Fill(TMath::Sqrt(Px*Px+Py*Py),TMath::Sqrt(Pbx*Pbx+Pby*Pby));
        }
      }
    }
- }
 }
 
-void MufluxReco::sortHits(TClonesArray* hits, nestedList* l, Bool_t flag){
-  nestedList spectrHitsSorted = *l;
- //spectrHitsSorted = {'_x':{1:{0:[],1:[],2:[],3:[]},2: {0:[],1:[],2:[],3:[]},3: {0:[],1:[],2:[],3:[]},4: {0:[],1:[],2:[],3:[]}},\
- //                    '_u':{1:{0:[],1:[],2:[],3:[]},2: {0:[],1:[],2:[],3:[]},3: {0:[],1:[],2:[],3:[]},4: {0:[],1:[],2:[],3:[]}},\
- //                    '_v':{1:{0:[],1:[],2:[],3:[]},2: {0:[],1:[],2:[],3:[]},3: {0:[],1:[],2:[],3:[]},4: {0:[],1:[],2:[],3:[]}}}
- for (Int_t k=0;k<hits->GetEntries();k++) {
-   MufluxSpectrometerHit* hit = (MufluxSpectrometerHit*)hits->At(k);
-   if ( !hit->isValid() && MCdata){continue;}
+Bool_t MufluxReco::selectHit(MufluxSpectrometerHit* hit, Bool_t flag, MufluxStationInfo& info){
+   if ( !hit->isValid() && MCdata){return kFALSE;}
    if (flag && !MCdata){
-    if (!hit->hasTimeOverThreshold() || !hit->hasDelay() || !hit->hasTrigger() ){ continue;} // no reliable TDC measuerement
+    if (!hit->hasTimeOverThreshold() || !hit->hasDelay() || !hit->hasTrigger() ){ return kFALSE;} // no reliable TDC measuerement
   // remove noise hits
     auto result = std::find( noisyChannels.begin(), noisyChannels.end(), hit->GetDetectorID() );
-    if ( result !=  noisyChannels.end()){ continue;}
+    if ( result !=  noisyChannels.end()){ return kFALSE;}
    }
-   if (hit->GetTimeOverThreshold() < cuts["tot"]) { continue;}
-   auto info = hit->StationInfo();
-   // info[0],info[1],info[2],info[3],viewDict[info[4]],info[5],info[6],info[7]
-   // statnb,   vnb,    pnb,    lnb,    view,         channelID,tdcId,nRT
-   if (info[2] > 1 || info[3] >1){
+   if (hit->GetTimeOverThreshold() < cuts["tot"]) { return kFALSE;}
+   info = hit->GetStationInfo();
+   if (info.plane > 1 || info.layer >1){
     std::cout<< "sortHits: unphysical detector ID "<<hit->GetDetectorID()<<std::endl;
     hit->Dump();
-   }else{
-     if (MCdata){
-      float rnr = gRandom->Uniform();
+    return kFALSE;
+   }
+   if (MCdata){
+      float rnr = random()->Uniform();
       TString station;
-      if (info[4]==0){station = 'x';station += info[0];}
-      if (info[4]==1){station = 'u';}
-      if (info[4]==2){station = 'v';}
+      if (info.iview==0){station = 'x';station += info.station;}
+      if (info.iview==1){station = 'u';}
+      if (info.iview==2){station = 'v';}
       float eff = effFudgeFac[station.Data()];
-      if (rnr > eff){continue;}
-     }
-    spectrHitsSorted[info[4]][info[0]][info[2]*2+info[3]].push_back(hit);
-  }
+      if (rnr > eff){return kFALSE;}
+   }
+   return kTRUE;
+}
+
+void MufluxReco::sortHits(TClonesArray* hits, nestedList* l, Bool_t flag){
+  nestedList spectrHitsSorted = *l;
+ //spectrHitsSorted = {'_x':{1:{0:[],1:[],2:[],3:[]},2: {0:[],1:[],2:[],3:[]},3: {0:[],1:[],2:[],3:[]},4: {0:[],1:[],2:[],3:[]}},\
+ //                    '_u':{1:{0:[],1:[],2:[],3:[]},2: {0:[],1:[],2:[],3:[]},3: {0:[],1:[],2:[],3:[]},4: {0:[],1:[],2:[],3:[]}},\
+ //                    '_v':{1:{0:[],1:[],2:[],3:[]},2: {0:[],1:[],2:[],3:[]},3: {0:[],1:[],2:[],3:[]},4: {0:[],1:[],2:[],3:[]}}}
+ for (Int_t k=0;k<hits->GetEntries();k++) {
+   MufluxSpectrometerHit* hit = (MufluxSpectrometerHit*)hits->At(k);
+   MufluxStationInfo info;
+   if (!selectHit(hit,flag,info)){continue;}
+   spectrHitsSorted[info.iview][info.station][info.plane*2+info.layer].push_back(hit);
  }
  *l = spectrHitsSorted;
 }
 
 void MufluxReco::fillHitMaps(Int_t nMax)
 {
- Float_t deadThreshold = 1.E-4; // ~1% typical occupancy
  Int_t N = xSHiP->GetEntries(true);
+ TTree* sTree = xSHiP->GetTree();
  if (nMax<0){nMax=N;}
  xSHiP->Restart();
  gROOT->cd();
  std::cout<< "fillHitMaps: "<< N  <<std::endl;
- TTreeReaderArray <MufluxSpectrometerHit> Digi_MufluxSpectrometerHits(*xSHiP, "Digi_MufluxSpectrometerHits");
- TTreeReaderValue<FairEventHeader>* rvShipEventHeader= NULL;
- if (MCdata){ rvShipEventHeader = new TTreeReaderValue<FairEventHeader>(*xSHiP, "ShipEventHeader");}
+ // histograms are resolved once, per hit only array lookups
+ MufluxHistoRegistry histos;
+ histos.Resolve(cuts["RTsegmentation"]);
  Int_t nx = 0;
- while (xSHiP->Next()){
-  nx+=1;
-  if (nx>nMax){break;}
-  // std::cout<< "next event. #hits "<< Digi_MufluxSpectrometerHits.GetSize()  <<std::endl;
-  for (Int_t k=0;k<Digi_MufluxSpectrometerHits.GetSize();k++) {
-     MufluxSpectrometerHit* hit = &(Digi_MufluxSpectrometerHits[k]);
-     auto info = hit->StationInfo();
-     Int_t s=info[0]; Int_t v=info[1]; Int_t p=info[2]; Int_t l=info[3]; Int_t channelNr=info[5]; 
-     Int_t tdcId=info[6]; Int_t nRT=info[7]/cuts["RTsegmentation"];
-     TString view = "_x"; 
-     if (info[4]==1){view="_u";}
-     if (info[4]==2){view="_v";}
-     TString tot = "";
-     if (!hit->hasTimeOverThreshold()){ tot = "_noToT";}
-     TString histo; histo.Form("%d",1000*s+100*p+10*l);histo+=view;
-     TH1D* h = (TH1D*)(gDirectory->GetList()->FindObject(histo));
+ while (nx<nMax){
+   sTree->GetEvent(nx);
+   nx+=1;
+   fillHitMapsEvent(histos,nx);
+ }
+}
+
+void MufluxReco::fillHitMapsEvent(const MufluxHistoRegistry& histos, Long64_t nx)
+{
+  Float_t RTsegmentation = cuts["RTsegmentation"];
+  for (Int_t k=0;k<cDigi_MufluxSpectrometerHits->GetEntriesFast();k++) {
+     MufluxSpectrometerHit* hit = (MufluxSpectrometerHit*)cDigi_MufluxSpectrometerHits->UncheckedAt(k);
+     auto info = hit->GetStationInfo();
+     Int_t s=info.station; Int_t p=info.plane; Int_t l=info.layer; Int_t channelNr=info.channel; 
+     Int_t nRT=info.nRT/RTsegmentation;
+     Bool_t noToT = !hit->hasTimeOverThreshold();
+     TH1D* h = histos.HitMap(s,p,l,info.iview);
      if (!h){
-       std::cout<< "fillHitMaps: ERROR histo not known "<< histo <<" event "<< nx <<std::endl;
+       std::cout<< "fillHitMaps: ERROR histo not known "<< MufluxHistoRegistry::HitMapName(s,p,l,info.iview) <<" event "<< nx <<std::endl;
        continue;
      }
      h->Fill(channelNr);
      auto check = std::find( noisyChannels.begin(), noisyChannels.end(), hit->GetDetectorID() );
      if (check!=noisyChannels.end()){ continue;}
      Float_t t0 = 0;
-     if (MCdata){ rvShipEventHeader->Get()->GetEventTime(); }
-     TString TDChisto = "TDC"; TDChisto+=nRT; TDChisto+=tot;
-     h = (TH1D*)(gDirectory->GetList()->FindObject(TDChisto));
+     h = histos.TDC(nRT,noToT);
      if (!h){
-       std::cout<< "fillHitMaps: ERROR histo not known "<< TDChisto  <<" event "<< nx <<std::endl; 
+       std::cout<< "fillHitMaps: ERROR histo not known "<< MufluxHistoRegistry::TDCName(nRT,noToT)  <<" event "<< nx <<std::endl; 
        continue;
      }
      h->Fill( hit->GetDigi()-t0);
-     TString channel = "TDC";channel+=hit->GetDetectorID();
-     h = (TH1D*)(gDirectory->GetList()->FindObject(channel));
+     h = histos.TDCChannel(hit->GetDetectorID());
+     if (!h){
+       std::cout<< "fillHitMaps: ERROR histo not known TDC"<< hit->GetDetectorID()  <<" event "<< nx <<std::endl; 
+       continue;
+     }
      h->Fill( hit->GetDigi()-t0);
    }
+}
+
+TRandom* MufluxReco::random(){
+ return fRandom ? fRandom : gRandom;
+}
+
+namespace {
+typedef std::vector<std::pair<TH1*,TH1*>> HistoClones; // histogram in gDirectory and clone of a thread
+// replace h by an empty clone without directory
+template <class T> void cloneHisto(T*& h, HistoClones& clones){
+  if (!h){return;}
+  T* c = (T*)h->Clone();
+  c->SetDirectory(0);
+  c->Reset();
+  clones.push_back(std::make_pair((TH1*)h,(TH1*)c));
+  h = c;
+}
+void cloneHistos(MufluxRPCAnalysis& a, HistoClones& clones){
+  for (Int_t s=0;s<6;s++){
+   for (Int_t v=0;v<2;v++){
+     cloneHisto(a.resX[s][v],clones); cloneHisto(a.resY[s][v],clones);
+     cloneHisto(a.extTrack[s][v],clones); cloneHisto(a.fired[s][v],clones);
+   }
+   cloneHisto(a.firedOr[s],clones);
+  }
+  for (Int_t k=0;k<20;k++){ cloneHisto(a.nMatched[k],clones);}
+  cloneHisto(a.p,clones); cloneHisto(a.resX1p,clones); cloneHisto(a.xy2,clones); cloneHisto(a.matchedHits,clones);
+}
+void cloneHistos(MufluxKinematicsAnalysis& a, HistoClones& clones){
+  cloneHisto(a.scalers,clones);
+  cloneHisto(a.weightVsSource,clones);
+  for (Int_t it=0;it<2;it++){
+   for (Int_t is=0;is<7;is++){
+    for (Int_t i1=0;i1<3;i1++){ cloneHisto(a.h1D[i1][it][is],clones);}
+    for (Int_t i2=0;i2<9;i2++){ cloneHisto(a.h2D[i2][it][is],clones);}
+   }
   }
 }
+void cloneHistos(MufluxHistoRegistry& histos, HistoClones& clones){
+  histos.CloneHistograms(clones);
+}
+// ranges [first,last) of the tree clusters of all files up to entry nMax, entries counted as in a TChain
+std::vector<std::pair<Long64_t,Long64_t>> clusterRanges(const std::vector<TString>& files, const char* treeName, Long64_t nMax){
+  std::vector<std::pair<Long64_t,Long64_t>> ranges;
+  Long64_t offset = 0;
+  for (auto& name : files){
+    if (offset>=nMax){break;}
+    std::unique_ptr<TFile> f(TFile::Open(name));
+    TTree* t = f ? (TTree*)f->Get(treeName) : 0;
+    if (!t){
+      std::cout<< "runAnalyses: no tree "<< treeName <<" in "<< name <<std::endl;
+      continue;
+    }
+    Long64_t N = t->GetEntries();
+    TTree::TClusterIterator clusters = t->GetClusterIterator(0);
+    Long64_t first;
+    while ((first = clusters()) < N && offset+first < nMax){
+      ranges.push_back(std::make_pair(offset+first, std::min(offset+clusters.GetNextEntry(), nMax)));
+    }
+    offset += N;
+  }
+  return ranges;
+}
+// analysis chain of one thread: own input, own MufluxReco with the settings of the caller, own histograms
+struct MufluxRecoWorker {
+  TChain* chain;
+  TTreeReader* reader;
+  MufluxReco* reco;
+  TRandom3* random;
+  MufluxHistoRegistry hitMaps;
+  MufluxRPCAnalysis rpc;
+  MufluxKinematicsAnalysis kinematics;
+  HistoClones clones;
+};
+}
+
+void MufluxReco::runAnalyses(TString analyses, Int_t nThreads, Int_t nMax, Float_t chi2UL){
+ Bool_t doHitMaps = analyses.Contains("fillHitMaps");
+ Bool_t doRPC = analyses.Contains("RPCextrap");
+ Bool_t doKinematics = analyses.Contains("trackKinematics");
+ if (!doHitMaps && !doRPC && !doKinematics){
+   std::cout<< "runAnalyses: nothing to do for "<< analyses <<", known are fillHitMaps,RPCextrap,trackKinematics"<<std::endl;
+   return;
+ }
+ if (nThreads<1){nThreads=1;}
+ TTree* sTree = xSHiP->GetTree();
+ Long64_t N = xSHiP->GetEntries(true);
+ if (nMax<0 || nMax>N){nMax=N;}
+ std::vector<TString> files;
+ if (sTree->InheritsFrom(TChain::Class())){
+   TIter next(((TChain*)sTree)->GetListOfFiles());
+   while (TObject* f = next()){ files.push_back(f->GetTitle());}
+ } else if (sTree->GetCurrentFile()){
+   files.push_back(sTree->GetCurrentFile()->GetName());
+ }
+ auto ranges = clusterRanges(files, sTree->GetName(), nMax);
+ std::cout<< "runAnalyses: "<< analyses <<" for "<< nMax <<" events, "<< ranges.size() <<" clusters, "<< nThreads <<" threads"<<std::endl;
+ gROOT->cd();
+ MufluxHistoRegistry hitMaps;
+ MufluxRPCAnalysis rpc;
+ MufluxKinematicsAnalysis kinematics;
+ if (doHitMaps){hitMaps.Resolve(cuts["RTsegmentation"]);}
+ if (doRPC){resolveRPCAnalysis(rpc);}
+ if (doKinematics){resolveKinematicsAnalysis(kinematics,chi2UL);}
+ if (nThreads>1){ROOT::EnableThreadSafety();}
+ std::vector<MufluxRecoWorker*> workers;
+ for (Int_t i=0;i<nThreads;i++){
+   MufluxRecoWorker* w = new MufluxRecoWorker();
+   w->chain = new TChain(sTree->GetName());
+   for (auto& name : files){ w->chain->Add(name);}
+   w->reader = new TTreeReader(w->chain);
+   w->reco = new MufluxReco();
+   w->reco->xSHiP = w->reader;
+   w->reco->setBranches();
+   w->reco->noisyChannels = noisyChannels;
+   w->reco->deadChannels = deadChannels;
+   w->reco->cuts = cuts;
+   w->reco->RPCPositions = RPCPositions;
+   w->reco->strawX = strawX;
+   w->reco->strawZ = strawZ;
+   w->reco->strawKnown = strawKnown;
+   w->reco->effFudgeFac = effFudgeFac;
+   w->random = new TRandom3(fSeed);
+   w->reco->fRandom = w->random;
+   w->hitMaps = hitMaps;
+   w->rpc = rpc;
+   w->kinematics = kinematics;
+   cloneHistos(w->hitMaps,w->clones);
+   cloneHistos(w->rpc,w->clones);
+   cloneHistos(w->kinematics,w->clones);
+   workers.push_back(w);
+ }
+ // cluster ranges are given round robin, each thread fills its histograms always in the same order
+ auto run = [&](Int_t i){
+   MufluxRecoWorker* w = workers[i];
+   for (size_t r=i;r<ranges.size();r+=nThreads){
+     for (Long64_t entry=ranges[r].first;entry<ranges[r].second;entry++){
+       w->chain->GetEntry(entry);
+       w->random->SetSeed(fSeed+entry);
+       if (doHitMaps){w->reco->fillHitMapsEvent(w->hitMaps,entry);}
+       if (doRPC){w->reco->RPCextrapEvent(w->rpc);}
+       if (doKinematics){w->reco->trackKinematicsEvent(w->kinematics);}
+     }
+   }
+ };
+ if (nThreads==1){
+   run(0);
+ } else {
+   std::vector<std::thread> threads;
+   for (Int_t i=0;i<nThreads;i++){ threads.push_back(std::thread(run,i));}
+   for (auto& t : threads){ t.join();}
+ }
+ // merge in thread order
+ for (auto w : workers){
+   for (auto& c : w->clones){
+     c.first->Add(c.second);
+     delete c.second;
+   }
+   delete w->reco;
+   delete w->reader;
+   delete w->chain;
+   delete w->random;
+   delete w;
+ }
+}
+
 // -----   Destructor   ----------------------------------------------------
 MufluxReco::~MufluxReco() { }
 // -------------------------------------------------------------------------
@@ -11,6 +11,7 @@
 #include "Track.h"
 #include "TVector3.h"
 #include "TrackInfo.h"
+#include "MufluxRPCMatcher.h"
 
 #include <iostream>
 #include <map>
@@ -20,6 +21,47 @@ enum class view {x, u, v, y}; // to avoid using std::string to index
 typedef std::map<std::string,float> StringFloatMap;
 typedef std::map<std::string,std::vector<int>> StringVecIntMap;
 typedef std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<MufluxSpectrometerHit*>>>> nestedList;
+/** hit of a drift tube cluster with x and z of the straw center, [hit,x,z,channel] in drifttubeMonitoring.py **/
+struct DTClusterHit {
+  MufluxSpectrometerHit* hit;
+  Double_t x;
+  Double_t z;
+  Int_t channel;
+};
+typedef std::vector<DTClusterHit> DTCluster;
+typedef std::map<int, std::map<int, std::vector<DTCluster>>> DTClusterList; // [station][view]
+
+class TH1;
+class TH1D;
+class TH2D;
+class TH3D;
+class TRandom;
+class MufluxHistoRegistry;
+/** histograms and cuts of RPCextrap, resolved once per pass **/
+struct MufluxRPCAnalysis {
+  TH2D* resX[6][2];        // RPCResX_<10*s+v>
+  TH2D* resY[6][2];        // RPCResY_<10*s+v>
+  TH1D* extTrack[6][2];    // RPCextTrack_<10*s+v>
+  TH1D* fired[6][2];       // RPCfired_<10*s+v>
+  TH1D* firedOr[6];        // RPCfired_or_<s>
+  TH1D* nMatched[20];      // RPC<k_p
+  TH1D* p;
+  TH2D* resX1p;
+  TH2D* xy2;
+  TH3D* matchedHits;
+  Float_t maxDistance, zRPC1, xLRPC1, xRRPC1, yBRPC1, yTRPC1;
+  Float_t zLinear; // tracks are straight lines from here, lastDTStation_z+10 as in extrapolateToPlane
+  Bool_t linear;   // cuts["RPClinearExtrapolation"]>0: straight lines also in front of zLinear, no genfit
+  Bool_t skipResiduals; // cuts["RPCskipResiduals"]>0: no residual histograms where the tracks are straight lines
+};
+/** histograms and cuts of trackKinematics, histograms indexed by name, muon tag and source **/
+struct MufluxKinematicsAnalysis {
+  TH1D* scalers;
+  TH1D* h1D[3][2][7];
+  TH2D* h2D[9][2][7];
+  TH2D* weightVsSource;
+  Float_t chi2UL, zRPC1, muTrackMatchX, muTrackMatchY;
+};
 
 class MufluxReco {
 public:
@@ -33,22 +75,43 @@ public:
 
    /** methods **/
    Bool_t checkCharm();
-   Int_t checkDiMuon();
+   Int_t checkDiMuon(TH2D* h_weightVsSource=nullptr);
    void fillHitMaps(Int_t nMax=-1);
    void RPCextrap(Int_t nMax=-1);
    void trackKinematics(Float_t chi2UL,Int_t nMax=-1);
+   /** fillHitMaps, RPCextrap and trackKinematics (comma separated in analyses) in one pass over the input
+       with nThreads threads. Each thread reads its own chain, events in ranges of the tree clusters, and
+       fills clones of the histograms which are added to the histograms in gDirectory at the end.
+       The random generator of the MC efficiency fudge factors is reseeded with seed+entry for each event,
+       the result does not depend on the number of threads. **/
+   void runAnalyses(TString analyses, Int_t nThreads=1, Int_t nMax=-1, Float_t chi2UL=3.);
+   void setSeed(UInt_t seed){fSeed=seed;}
    Bool_t findSimpleEvent(Int_t nmin, Int_t nmax);
    void setNoisyChannels(std::vector<int> x){noisyChannels = x;}
    void setDeadChannels(std::vector<int> x){deadChannels = x;}
    void setCuts(std::string s,float f){cuts[s]=f;}
    void setRPCPositions(Int_t c,float x,float y,float z){RPCPositions[c]=TVector3(x,y,z);}
    void sortHits(TClonesArray *t, nestedList *l, Bool_t flag=kTRUE);
+   void setStrawPositions(Int_t detID, TVector3 bot, TVector3 top);
+   void findDTClusters(TClonesArray *t, DTClusterList *clusters, Bool_t removeBigClusters=kTRUE);
+   void splitStereoClusters(DTClusterList *clusters);
    Double_t extrapolateToPlane(genfit::Track* fT,Float_t z, TVector3& pos, TVector3& mom);
    StringVecIntMap countMeasurements(TrackInfo* trInfo);
    std::vector<std::vector<int>> GroupIntegers(std::vector<int>& input_array, size_t span);
    void setEffFudgeFactor(std::string s,float f){effFudgeFac[s]=f;}
 
 private:
+   Bool_t selectHit(MufluxSpectrometerHit* hit, Bool_t flag, MufluxStationInfo& info);
+   void setBranches();
+   TRandom* random();
+   void resolveRPCAnalysis(MufluxRPCAnalysis& a);
+   void resolveKinematicsAnalysis(MufluxKinematicsAnalysis& a, Float_t chi2UL);
+   // one event, read before
+   void fillHitMapsEvent(const MufluxHistoRegistry& histos, Long64_t nx);
+   void RPCextrapEvent(const MufluxRPCAnalysis& a);
+   // straight line of a track after the last drift tube station, as used by extrapolateToPlane
+   void rpcTrackLine(genfit::Track* aTrack, RPCTrackLine& line);
+   void trackKinematicsEvent(const MufluxKinematicsAnalysis& a);
   protected:
     Bool_t MCdata;
     TTreeReader* xSHiP;
@@ -56,6 +119,12 @@ private:
     std::vector<int> deadChannels;
     StringFloatMap cuts;
     std::map<int,TVector3> RPCPositions;
+    std::vector<Double_t> strawX; // straw centers by MufluxHistoRegistry::ChannelIndex
+    std::vector<Double_t> strawZ;
+    std::vector<Int_t> strawKnown;
+    MufluxRPCMatcher rpcMatcher; //! RPC hits of the event by station and view
+    TRandom*        fRandom;   //! generator of the efficiency fudge factors, gRandom if null
+    UInt_t          fSeed;
     TClonesArray    *MCTrack;
     TClonesArray    *FitTracks;
     TClonesArray    *TrackInfos;
@@ -73,7 +142,7 @@ private:
     TBranch        *b_Digi_MuonTaggerHits;   //!
     TBranch        *b_Digi_MufluxSpectrometerHits;   //!
     TBranch        *b_MufluxSpectrometerPoints;   //!
-   ClassDef(MufluxReco,5);
+   ClassDef(MufluxReco,8);
 };
 
 #endif
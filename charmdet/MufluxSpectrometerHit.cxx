@@ -9,6 +9,7 @@
 #include "TGeoManager.h" 
 #include "TGeoShape.h" 
 #include "TGeoTube.h" 
+#include "TClonesArray.h" 
  
  
 #include <iostream> 
@@ -85,13 +86,13 @@ void MufluxSpectrometerHit::MufluxSpectrometerEndPoints(TVector3 &vbot, TVector3
      vbot.SetXYZ(Gbot[0],Gbot[1],Gbot[2]); 
 } 
 
-std::vector<int> MufluxSpectrometerHit::StationInfo(){
-     std::vector<int> info;
-     Int_t statnb = fDetectorID/10000000;
-     Int_t vnb =  (fDetectorID - statnb*10000000)/1000000; 
-     Int_t pnb =  (fDetectorID- statnb*10000000 - vnb*1000000)/100000; 
-     Int_t lnb =  (fDetectorID - statnb*10000000 - vnb*1000000 - pnb*100000)/10000; 
-     TString stat = "volDriftTube";stat+=+statnb;stat+="_";stat+=statnb; 
+namespace {
+MufluxStationInfo DecodeStationInfo(Int_t detID)
+{
+     Int_t statnb = detID/10000000;
+     Int_t vnb =  (detID - statnb*10000000)/1000000; 
+     Int_t pnb =  (detID- statnb*10000000 - vnb*1000000)/100000; 
+     Int_t lnb =  (detID - statnb*10000000 - vnb*1000000 - pnb*100000)/10000; 
      Int_t iview = 0;
      switch (vnb) {
       case 0:
@@ -106,7 +107,7 @@ std::vector<int> MufluxSpectrometerHit::StationInfo(){
        break;
      }
      Int_t tdcId = 0;
-     Int_t channelID = fDetectorID%1000;
+     Int_t channelID = detID%1000;
      if (statnb==1 && iview==0){ tdcId = 0;}
      else if (statnb==1 && iview== 1){ tdcId = 0;}
      else if (statnb==2 && iview== 2 && pnb==0){ tdcId = 0;}
@@ -118,15 +119,6 @@ std::vector<int> MufluxSpectrometerHit::StationInfo(){
      else if (statnb==4 && channelID<13 && pnb==1){ tdcId = 2;}
      else if (statnb==4 && channelID<37 && !(channelID<13)){ tdcId = 2;}
      else if (statnb==4 && channelID>36){ tdcId = 1;}
-     Int_t moduleId = 1;
-     if (statnb > 2){ moduleId = int( (channelID-1)/12) + 1 ;}
-     info.push_back(statnb);
-     info.push_back(vnb);
-     info.push_back(pnb);
-     info.push_back(lnb);
-     info.push_back(iview);
-     info.push_back(channelID);
-     info.push_back(tdcId);
 // make numbering along gasline
      Int_t layer = pnb*2+lnb;
      Int_t nRT   = (channelID-1)*4 + layer;
@@ -134,10 +126,72 @@ std::vector<int> MufluxSpectrometerHit::StationInfo(){
      else if (iview == 1){nRT += 48;}
      else if (iview == 2){nRT += 2*48;}
      else if (statnb == 2){nRT += 3*48;}
-     info.push_back(nRT);
+     return MufluxStationInfo{statnb, vnb, pnb, lnb, iview, channelID, tdcId, nRT};
+}
 
-// don't know of any nice way to return multiple variables, use python to sort out the mess. 
-     return info;
+// Table of all drift tubes, station 1-4, view number, plane and layer 0-1, straw 0-63.
+// The thousands digit of the detector ID does not enter the decoding.
+const Int_t kTableStraws = 64;
+Int_t StationInfoIndex(Int_t detID)
+{
+     if (detID < 10000000 || detID >= 50000000){ return -1;}
+     Int_t statnb  = detID/10000000;
+     Int_t vnb     = (detID/1000000)%10;
+     Int_t pnb     = (detID/100000)%10;
+     Int_t lnb     = (detID/10000)%10;
+     Int_t channel = detID%1000;
+     if (vnb > 1 || pnb > 1 || lnb > 1 || channel >= kTableStraws){ return -1;}
+     return ((((statnb-1)*2 + vnb)*2 + pnb)*2 + lnb)*kTableStraws + channel;
+}
+const std::vector<MufluxStationInfo> &StationInfoTable()
+{
+     static const std::vector<MufluxStationInfo> table = [] {
+       std::vector<MufluxStationInfo> t(4*2*2*2*kTableStraws);
+       for (Int_t s=1;s<5;s++){ for (Int_t v=0;v<2;v++){ for (Int_t p=0;p<2;p++){ for (Int_t l=0;l<2;l++){
+        for (Int_t straw=0;straw<kTableStraws;straw++){
+          Int_t detID = s*10000000 + v*1000000 + p*100000 + l*10000 + 2000 + straw;
+          t[StationInfoIndex(detID)] = DecodeStationInfo(detID);
+       }}}}}
+       return t;
+     }();
+     return table;
+}
+}
+
+MufluxStationInfo MufluxSpectrometerHit::GetStationInfo(Int_t detID)
+{
+     Int_t index = StationInfoIndex(detID);
+     if (index < 0){ return DecodeStationInfo(detID);}
+     return StationInfoTable()[index];
+}
+
+Int_t MufluxSpectrometerHit::GetStationInfo(const TClonesArray *hits, MufluxStationInfoColumns &columns)
+{
+     Int_t n = hits->GetEntriesFast();
+     for (auto c : {&columns.detectorID, &columns.station, &columns.view, &columns.plane, &columns.layer,
+                    &columns.iview, &columns.channel, &columns.tdcId, &columns.nRT}) { c->resize(n);}
+     const std::vector<MufluxStationInfo> &table = StationInfoTable();
+     for (Int_t k=0;k<n;k++){
+       Int_t detID = static_cast<const MufluxSpectrometerHit*>(hits->UncheckedAt(k))->GetDetectorID();
+       Int_t index = StationInfoIndex(detID);
+       MufluxStationInfo info = index < 0 ? DecodeStationInfo(detID) : table[index];
+       columns.detectorID[k] = detID;
+       columns.station[k] = info.station;
+       columns.view[k]    = info.view;
+       columns.plane[k]   = info.plane;
+       columns.layer[k]   = info.layer;
+       columns.iview[k]   = info.iview;
+       columns.channel[k] = info.channel;
+       columns.tdcId[k]   = info.tdcId;
+       columns.nRT[k]     = info.nRT;
+     }
+     return n;
+}
+
+// kept for python, fields in the order of MufluxStationInfo
+std::vector<int> MufluxSpectrometerHit::StationInfo(){
+     MufluxStationInfo info = GetStationInfo();
+     return {info.station, info.view, info.plane, info.layer, info.iview, info.channel, info.tdcId, info.nRT};
 }
 // ------------------------------------------------------------------------- 
 
@@ -6,6 +6,37 @@
 #include "ShipOnlineDataFormat.h"
 #include "TVector3.h"
 
+#include <vector>
+
+class TClonesArray;
+
+/** Decoded detector ID of a drift tube, the fields of MufluxSpectrometerHit::StationInfo() **/
+struct MufluxStationInfo {
+   Int_t station; // 1-4
+   Int_t view;    // view number of the detector ID
+   Int_t plane;
+   Int_t layer;
+   Int_t iview;   // 0 x, 1 u, 2 v
+   Int_t channel; // straw
+   Int_t tdcId;
+   Int_t nRT;     // numbering along the gas line
+};
+
+/** StationInfo of all hits of a Digi_MufluxSpectrometerHits array, one column per field.
+ *  In python the columns are numpy arrays without copy, e.g.
+ *  numpy.frombuffer(columns.station.data(), dtype=numpy.int32, count=columns.station.size()) **/
+struct MufluxStationInfoColumns {
+   std::vector<Int_t> detectorID;
+   std::vector<Int_t> station;
+   std::vector<Int_t> view;
+   std::vector<Int_t> plane;
+   std::vector<Int_t> layer;
+   std::vector<Int_t> iview;
+   std::vector<Int_t> channel;
+   std::vector<Int_t> tdcId;
+   std::vector<Int_t> nRT;
+};
+
 class MufluxSpectrometerHit : public ShipHit {
 public:
    /** Default constructor **/
@@ -41,7 +72,14 @@ public:
    bool hasTrigger() const { return !((flags & DriftTubes::NoTrigger) == DriftTubes::NoTrigger); }
    bool hasTimeOverThreshold() const { return !((flags & DriftTubes::NoWidth) == DriftTubes::NoWidth); }
    Float_t GetTimeOverThreshold() const { return time_over_threshold; }
+   uint16_t GetFlags() const { return flags; }
+   uint16_t GetChannel() const { return channel; }
    std::vector<int> StationInfo();
+   MufluxStationInfo GetStationInfo() const { return GetStationInfo(fDetectorID); }
+   /** Decoded detector ID from a table, computed for IDs outside of the table **/
+   static MufluxStationInfo GetStationInfo(Int_t detID);
+   /** Decode the detector IDs of all hits of hits into columns, returns the number of hits **/
+   static Int_t GetStationInfo(const TClonesArray *hits, MufluxStationInfoColumns &columns);
 private:
    /** Copy constructor **/
    MufluxSpectrometerHit(const MufluxSpectrometerHit &point);
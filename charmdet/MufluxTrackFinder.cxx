@@ -0,0 +1,470 @@
+#include "MufluxTrackFinder.h"
+
+#include "TMath.h"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+namespace {
+const Double_t kZCenter = 350.75; // z_center of MufluxPatRec.execute
+const Int_t kMaxHits = 100;
+const Double_t kWindowY = 3.0;       // y view hits around the seed line
+const Double_t kWindowStereo = 10.0; // stereo view hits around the seed line
+const Double_t kMaxStereoY = 70.;
+const Double_t kMaxDeltaY = 50.; // y12 and y34 segments at the magnet center
+const Double_t kMomentumScale = 1.03;
+
+// detID // 10000, station, view, plane and layer
+inline Int_t Layer(Int_t detID)
+{
+   return detID / 10000;
+}
+
+inline Bool_t Contains(const std::vector<Int_t> &layers, Int_t layer)
+{
+   return std::find(layers.begin(), layers.end(), layer) != layers.end();
+}
+
+inline Bool_t TestBit(const std::vector<ULong64_t> &bits, Int_t i)
+{
+   return (bits[i >> 6] >> (i & 63)) & 1;
+}
+
+inline void SetBit(std::vector<ULong64_t> &bits, Int_t i)
+{
+   bits[i >> 6] |= ULong64_t(1) << (i & 63);
+}
+
+// comparison of numpy, NaN after all numbers
+inline Bool_t NumpyLess(Int_t a, Int_t b)
+{
+   return a < b;
+}
+
+inline Bool_t NumpyLess(Double_t a, Double_t b)
+{
+   return a < b || (b != b && a == a);
+}
+
+// heapsort of numpy (aheapsort), fallback of NumpyArgsort for deep recursion
+template <typename T>
+void NumpyHeapArgsort(const std::vector<T> &v, Int_t *tosort, Int_t n)
+{
+   Int_t *a = tosort - 1; // indices from 1
+   Int_t i, j, l, tmp;
+   for (l = n >> 1; l > 0; --l) {
+      tmp = a[l];
+      for (i = l, j = l << 1; j <= n;) {
+         if (j < n && NumpyLess(v[a[j]], v[a[j + 1]])) {
+            j += 1;
+         }
+         if (NumpyLess(v[tmp], v[a[j]])) {
+            a[i] = a[j];
+            i = j;
+            j += j;
+         } else {
+            break;
+         }
+      }
+      a[i] = tmp;
+   }
+   for (; n > 1;) {
+      tmp = a[n];
+      a[n] = a[1];
+      n -= 1;
+      for (i = 1, j = 2; j <= n;) {
+         if (j < n && NumpyLess(v[a[j]], v[a[j + 1]])) {
+            j++;
+         }
+         if (NumpyLess(v[tmp], v[a[j]])) {
+            a[i] = a[j];
+            i = j;
+            j += j;
+         } else {
+            break;
+         }
+      }
+      a[i] = tmp;
+   }
+}
+
+// order of np.argsort(values), the default introsort of numpy (aquicksort): median of three quicksort, insertion
+// sort below 17 elements, heapsort if too deep. Equal values are not kept in order above 16 elements, the python
+// version depends on this order. Numpy versions which sort with SIMD instructions (x86-simd-sort, numpy >= 1.25
+// on AVX-512 machines) order equal values differently and are not reproduced.
+template <typename T>
+std::vector<Int_t> NumpyArgsort(const std::vector<T> &v)
+{
+   const Int_t num = v.size();
+   std::vector<Int_t> order(num);
+   std::iota(order.begin(), order.end(), 0);
+   if (num < 2) {
+      return order;
+   }
+   const Int_t kSmallQuicksort = 15;
+   Int_t *pl = order.data();
+   Int_t *pr = pl + num - 1;
+   std::vector<Int_t *> stack;
+   std::vector<Int_t> depth;
+   Int_t cdepth = 0;
+   for (Int_t m = num; m >>= 1;) {
+      cdepth++;
+   }
+   cdepth *= 2;
+   for (;;) {
+      if (cdepth < 0) {
+         NumpyHeapArgsort(v, pl, pr - pl + 1);
+      } else {
+         while (pr - pl > kSmallQuicksort) {
+            Int_t *pm = pl + ((pr - pl) >> 1);
+            if (NumpyLess(v[*pm], v[*pl])) {
+               std::swap(*pm, *pl);
+            }
+            if (NumpyLess(v[*pr], v[*pm])) {
+               std::swap(*pr, *pm);
+            }
+            if (NumpyLess(v[*pm], v[*pl])) {
+               std::swap(*pm, *pl);
+            }
+            const T vp = v[*pm];
+            Int_t *pi = pl;
+            Int_t *pj = pr - 1;
+            std::swap(*pm, *pj);
+            for (;;) {
+               do {
+                  ++pi;
+               } while (NumpyLess(v[*pi], vp));
+               do {
+                  --pj;
+               } while (NumpyLess(vp, v[*pj]));
+               if (pi >= pj) {
+                  break;
+               }
+               std::swap(*pi, *pj);
+            }
+            std::swap(*pi, *(pr - 1));
+            // the larger partition on the stack
+            if (pi - pl < pr - pi) {
+               stack.push_back(pi + 1);
+               stack.push_back(pr);
+               pr = pi - 1;
+            } else {
+               stack.push_back(pl);
+               stack.push_back(pi - 1);
+               pl = pi + 1;
+            }
+            depth.push_back(--cdepth);
+         }
+         for (Int_t *pi = pl + 1; pi <= pr; ++pi) {
+            const Int_t vi = *pi;
+            const T vp = v[vi];
+            Int_t *pj = pi;
+            Int_t *pk = pi - 1;
+            while (pj > pl && NumpyLess(vp, v[*pk])) {
+               *pj-- = *pk--;
+            }
+            *pj = vi;
+         }
+      }
+      if (stack.empty()) {
+         break;
+      }
+      pr = stack.back();
+      stack.pop_back();
+      pl = stack.back();
+      stack.pop_back();
+      cdepth = depth.back();
+      depth.pop_back();
+   }
+   return order;
+}
+
+// order of np.argsort(values)[::-1] in MufluxPatRec.reduce_clones
+std::vector<Int_t> ReverseArgsort(const std::vector<Int_t> &values)
+{
+   std::vector<Int_t> order = NumpyArgsort(values);
+   std::reverse(order.begin(), order.end());
+   return order;
+}
+}
+
+void MufluxPatRecHits::Clear()
+{
+   detID.clear();
+   digiHit.clear();
+   xtop.clear();
+   ytop.clear();
+   xbot.clear();
+   ybot.clear();
+   z.clear();
+}
+
+void MufluxPatRecHits::Add(Int_t aDetID, Int_t aDigiHit, Double_t aXtop, Double_t aYtop, Double_t aXbot,
+                           Double_t aYbot, Double_t aZ)
+{
+   detID.push_back(aDetID);
+   digiHit.push_back(aDigiHit);
+   xtop.push_back(aXtop);
+   ytop.push_back(aYtop);
+   xbot.push_back(aXbot);
+   ybot.push_back(aYbot);
+   z.push_back(aZ);
+}
+
+MufluxTrackFinder::MufluxTrackFinder() : TObject(), fMinHits(3), fMaxSharedHits(2) {}
+
+MufluxTrackFinder::~MufluxTrackFinder() {}
+
+Int_t MufluxTrackFinder::Execute(const MufluxPatRecHits &hits)
+{
+   fShortY12.clear();
+   fShort34.clear();
+   fShortStereo12.clear();
+   fStereoOrigin.clear();
+   fTracks.clear();
+   const Int_t nHits = hits.Size();
+   if (nHits > kMaxHits) {
+      std::cout << "MufluxTrackFinder::Execute: too many hits in the event, " << nHits << std::endl;
+      return 0;
+   }
+   // hits_split
+   fY12.clear();
+   fStereo12.clear();
+   fY34.clear();
+   for (Int_t i = 0; i < nHits; i++) {
+      const Int_t s = hits.detID[i] / 10000000;
+      const Int_t v = (hits.detID[i] - s * 10000000) / 1000000;
+      if ((s == 1 && v == 0) || (s == 2 && v == 1)) {
+         fY12.push_back(i);
+      }
+      if ((s == 1 && v == 1) || (s == 2 && v == 0)) {
+         fStereo12.push_back(i);
+      }
+      if (s == 3 || s == 4) {
+         fY34.push_back(i);
+      }
+   }
+   PatRecYViews(hits, fY12, fShortY12);
+   PatRecStereoViews(hits, fStereo12);
+   PatRecYViews(hits, fY34, fShort34);
+   CombineTracks(hits);
+   return fTracks.size();
+}
+
+void MufluxTrackFinder::PatRecYViews(const MufluxPatRecHits &hits, const std::vector<Int_t> &selection,
+                                     std::vector<MufluxPatRecSegment> &shortTracks)
+{
+   std::vector<MufluxPatRecSegment> longTracks;
+   std::vector<Int_t> layers;
+   for (Int_t i1 : selection) {
+      for (Int_t i2 : selection) {
+         if (hits.z[i1] >= hits.z[i2] || hits.detID[i1] == hits.detID[i2]) {
+            continue;
+         }
+         const Double_t x1 = hits.xtop[i1], x2 = hits.xtop[i2];
+         const Double_t z1 = hits.z[i1], z2 = hits.z[i2];
+         const Double_t k = (x2 - x1) / (z2 - z1);
+         const Double_t b = x1 - k * z1;
+         if (TMath::Abs(k) > 1) {
+            continue;
+         }
+         MufluxPatRecSegment track;
+         track.hits = {i1, i2};
+         track.u = {x1, x2};
+         track.z = {z1, z2};
+         layers.assign({Layer(hits.detID[i1]), Layer(hits.detID[i2])});
+         for (Int_t i3 : selection) {
+            if (hits.detID[i3] == hits.detID[i1] || hits.detID[i3] == hits.detID[i2]) {
+               continue;
+            }
+            const Int_t layer3 = Layer(hits.detID[i3]);
+            if (Contains(layers, layer3)) {
+               continue;
+            }
+            if (TMath::Abs(k * hits.z[i3] + b - hits.xtop[i3]) <= kWindowY) {
+               track.hits.push_back(i3);
+               track.z.push_back(hits.z[i3]);
+               track.u.push_back(hits.xtop[i3]);
+               layers.push_back(layer3);
+            }
+         }
+         if (Int_t(track.hits.size()) >= fMinHits) {
+            longTracks.push_back(std::move(track));
+         }
+      }
+   }
+   ReduceClones(hits, longTracks, shortTracks);
+   for (auto &track : shortTracks) {
+      Fit(track);
+   }
+}
+
+void MufluxTrackFinder::ReduceClones(const MufluxPatRecHits &hits, std::vector<MufluxPatRecSegment> &longTracks,
+                                     std::vector<MufluxPatRecSegment> &shortTracks)
+{
+   shortTracks.clear();
+   Int_t maxDigiHit = 0;
+   std::vector<Int_t> nHits;
+   for (auto &track : longTracks) {
+      nHits.push_back(track.hits.size());
+      for (Int_t i : track.hits) {
+         maxDigiHit = TMath::Max(maxDigiHit, hits.digiHit[i]);
+      }
+   }
+   fUsed.assign(maxDigiHit / 64 + 1, 0);
+   for (Int_t iTrack : ReverseArgsort(nHits)) {
+      MufluxPatRecSegment &track = longTracks[iTrack];
+      Int_t nShared = 0;
+      for (Int_t i : track.hits) {
+         nShared += TestBit(fUsed, hits.digiHit[i]);
+      }
+      if (Int_t(track.hits.size()) >= fMinHits && nShared <= fMaxSharedHits) {
+         for (Int_t i : track.hits) {
+            SetBit(fUsed, hits.digiHit[i]);
+         }
+         shortTracks.push_back(std::move(track));
+      }
+   }
+}
+
+void MufluxTrackFinder::PatRecStereoViews(const MufluxPatRecHits &hits, const std::vector<Int_t> &selection)
+{
+   std::vector<Int_t> layers;
+   fProjection.assign(hits.Size(), 0);
+   for (UInt_t iY = 0; iY < fShortY12.size(); iY++) {
+      const MufluxPatRecSegment &trackY = fShortY12[iY];
+      // get_zy_projection: y of the wire at the x of the y segment
+      for (Int_t i : selection) {
+         const Double_t x = trackY.k * hits.z[i] + trackY.b;
+         const Double_t k = (hits.ytop[i] - hits.ybot[i]) / (hits.xtop[i] - hits.xbot[i] + 1E-6);
+         fProjection[i] = k * x + hits.ytop[i] - k * hits.xtop[i];
+      }
+      // the stereo segment with most hits, the first one of them
+      MufluxPatRecSegment best;
+      for (Int_t i1 : selection) {
+         for (Int_t i2 : selection) {
+            if (hits.z[i1] >= hits.z[i2] || hits.detID[i1] == hits.detID[i2]) {
+               continue;
+            }
+            const Double_t y1 = fProjection[i1], y2 = fProjection[i2];
+            if (TMath::Abs(y1) > kMaxStereoY || TMath::Abs(y2) > kMaxStereoY) {
+               continue;
+            }
+            const Double_t z1 = hits.z[i1], z2 = hits.z[i2];
+            const Double_t k = (y2 - y1) / (z2 - z1);
+            const Double_t b = y1 - k * z1;
+            MufluxPatRecSegment track;
+            track.hits = {i1, i2};
+            track.u = {y1, y2};
+            track.z = {z1, z2};
+            layers.assign({Layer(hits.detID[i1]), Layer(hits.detID[i2])});
+            for (Int_t i3 : selection) {
+               if (hits.digiHit[i3] == hits.digiHit[i1] || hits.digiHit[i3] == hits.digiHit[i2]) {
+                  continue;
+               }
+               const Double_t y3 = fProjection[i3];
+               if (TMath::Abs(y3) > kMaxStereoY) {
+                  continue;
+               }
+               const Int_t layer3 = Layer(hits.detID[i3]);
+               if (Contains(layers, layer3)) {
+                  continue;
+               }
+               if (TMath::Abs(k * hits.z[i3] + b - y3) <= kWindowStereo) {
+                  track.hits.push_back(i3);
+                  track.z.push_back(hits.z[i3]);
+                  track.u.push_back(y3);
+                  layers.push_back(layer3);
+               }
+            }
+            if (Int_t(track.hits.size()) >= fMinHits && track.hits.size() > best.hits.size()) {
+               best = std::move(track);
+            }
+         }
+      }
+      if (!best.hits.empty()) {
+         Fit(best);
+         fShortStereo12.push_back(std::move(best));
+         fStereoOrigin.push_back(iY);
+      }
+   }
+}
+
+void MufluxTrackFinder::CombineTracks(const MufluxPatRecHits &hits)
+{
+   // all pairs of 1-2 and 3-4 segments, by the distance of their y views at the magnet center
+   std::vector<Int_t> i12, i34;
+   std::vector<Double_t> deltaY, momentum;
+   for (UInt_t a = 0; a < fShortStereo12.size(); a++) {
+      const MufluxPatRecSegment &track12 = fShortY12[fStereoOrigin[a]];
+      const Double_t y12 = track12.k * kZCenter + track12.b;
+      const Double_t alpha12 = TMath::ATan(track12.k);
+      for (UInt_t b = 0; b < fShort34.size(); b++) {
+         const MufluxPatRecSegment &track34 = fShort34[b];
+         i12.push_back(a);
+         i34.push_back(b);
+         deltaY.push_back(TMath::Abs(y12 - (track34.k * kZCenter + track34.b)));
+         momentum.push_back(kMomentumScale / (alpha12 - TMath::ATan(track34.k)));
+      }
+   }
+   for (Int_t i : NumpyArgsort(deltaY)) {
+      if (deltaY[i] >= kMaxDeltaY) {
+         continue;
+      }
+      const MufluxPatRecSegment &trackY = fShortY12[fStereoOrigin[i12[i]]];
+      const MufluxPatRecSegment &trackStereo = fShortStereo12[i12[i]];
+      const MufluxPatRecSegment &track34 = fShort34[i34[i]];
+      if (Int_t(trackY.hits.size()) < fMinHits || Int_t(trackStereo.hits.size()) < fMinHits ||
+          Int_t(track34.hits.size()) < fMinHits) {
+         continue;
+      }
+      MufluxPatRecTrack track;
+      track.y12 = trackY.hits;
+      track.stereo12 = trackStereo.hits;
+      track.y34 = track34.hits;
+      SortByZ(hits, track.y12);
+      SortByZ(hits, track.stereo12);
+      SortByZ(hits, track.y34);
+      track.p = TMath::Abs(momentum[i]);
+      track.xInMagnet = trackY.k * kZCenter + trackY.b;
+      track.yInMagnet = trackStereo.k * kZCenter + trackStereo.b;
+      fTracks.push_back(std::move(track));
+   }
+}
+
+void MufluxTrackFinder::Fit(MufluxPatRecSegment &segment)
+{
+   // least squares line, np.polyfit(z, u, deg=1)
+   const Int_t n = segment.z.size();
+   Double_t zMean = 0, uMean = 0;
+   for (Int_t i = 0; i < n; i++) {
+      zMean += segment.z[i];
+      uMean += segment.u[i];
+   }
+   zMean /= n;
+   uMean /= n;
+   Double_t szz = 0, szu = 0;
+   for (Int_t i = 0; i < n; i++) {
+      szz += (segment.z[i] - zMean) * (segment.z[i] - zMean);
+      szu += (segment.z[i] - zMean) * (segment.u[i] - uMean);
+   }
+   segment.k = szz > 0 ? szu / szz : 0;
+   segment.b = uMean - segment.k * zMean;
+}
+
+void MufluxTrackFinder::SortByZ(const MufluxPatRecHits &hits, std::vector<Int_t> &indices) const
+{
+   // as sort_hits, np.argsort of the z of the hits in the order of the track
+   std::vector<Double_t> z;
+   for (Int_t i : indices) {
+      z.push_back(hits.z[i]);
+   }
+   std::vector<Int_t> sorted;
+   for (Int_t k : NumpyArgsort(z)) {
+      sorted.push_back(indices[k]);
+   }
+   indices.swap(sorted);
+}
+
+ClassImp(MufluxTrackFinder)
@@ -0,0 +1,95 @@
+#ifndef MUFLUXTRACKFINDER_H
+#define MUFLUXTRACKFINDER_H 1
+
+#include "TObject.h"
+
+#include <vector>
+
+/** Drift tube hits of an event, one column per quantity, the SmearedHits of MufluxDigiReco **/
+struct MufluxPatRecHits {
+   std::vector<Int_t> detID;
+   std::vector<Int_t> digiHit;
+   std::vector<Double_t> xtop;
+   std::vector<Double_t> ytop;
+   std::vector<Double_t> xbot;
+   std::vector<Double_t> ybot;
+   std::vector<Double_t> z;
+
+   Int_t Size() const { return detID.size(); }
+   void Clear();
+   void Add(Int_t detID, Int_t digiHit, Double_t xtop, Double_t ytop, Double_t xbot, Double_t ybot, Double_t z);
+};
+
+/** Straight track segment, hits are indices into MufluxPatRecHits. In the y views u is x at the top
+ *  of the wire, in the stereo views the y of the wire at the x of the y view segment. **/
+struct MufluxPatRecSegment {
+   std::vector<Int_t> hits;
+   std::vector<Double_t> z;
+   std::vector<Double_t> u;
+   Double_t k; // u = k z + b
+   Double_t b;
+};
+
+/** Track of stations 1-4, hit indices sorted by z **/
+struct MufluxPatRecTrack {
+   std::vector<Int_t> y12;
+   std::vector<Int_t> stereo12;
+   std::vector<Int_t> y34;
+   Double_t p;
+   Double_t xInMagnet;
+   Double_t yInMagnet;
+};
+
+/* Pattern recognition of python/MufluxPatRec.py on column hits with integer hit IDs:
+   y view segments of stations 1-2 and 3-4 from all pairs of hits and the hits within a window of the
+   line, clone reduction by shared hits, the best stereo segment for every 1-2 y segment, and the
+   combination of the segments before and after the magnet by their distance at the magnet center.
+   The selection of the python version is kept, including the order of the clone reduction, so that
+   MufluxDigiReco.findTracks can use either. */
+class MufluxTrackFinder : public TObject {
+public:
+   MufluxTrackFinder();
+   virtual ~MufluxTrackFinder();
+
+   void SetMinHits(Int_t n) { fMinHits = n; }
+   void SetMaxSharedHits(Int_t n) { fMaxSharedHits = n; }
+
+   /** Tracks of an event, returns their number. Events with more than 100 hits are skipped. */
+   Int_t Execute(const MufluxPatRecHits &hits);
+
+   Int_t GetNTracks() const { return fTracks.size(); }
+   const MufluxPatRecTrack &GetTrack(Int_t i) const { return fTracks[i]; }
+   /** Segments after clone reduction, short_tracks_y12 and short_tracks_34 of the python version */
+   const std::vector<MufluxPatRecSegment> &GetShortTracksY12() const { return fShortY12; }
+   const std::vector<MufluxPatRecSegment> &GetShortTracks34() const { return fShort34; }
+   /** Stereo segment of the 1-2 y segment fShortY12[GetStereoOrigin(i)] */
+   const std::vector<MufluxPatRecSegment> &GetShortTracksStereo12() const { return fShortStereo12; }
+   Int_t GetStereoOrigin(Int_t i) const { return fStereoOrigin[i]; }
+
+private:
+   void PatRecYViews(const MufluxPatRecHits &hits, const std::vector<Int_t> &selection,
+                     std::vector<MufluxPatRecSegment> &shortTracks);
+   void PatRecStereoViews(const MufluxPatRecHits &hits, const std::vector<Int_t> &selection);
+   void ReduceClones(const MufluxPatRecHits &hits, std::vector<MufluxPatRecSegment> &longTracks,
+                     std::vector<MufluxPatRecSegment> &shortTracks);
+   void CombineTracks(const MufluxPatRecHits &hits);
+   static void Fit(MufluxPatRecSegment &segment);
+   void SortByZ(const MufluxPatRecHits &hits, std::vector<Int_t> &indices) const;
+
+   Int_t fMinHits;
+   Int_t fMaxSharedHits;
+
+   std::vector<MufluxPatRecSegment> fShortY12;      //!
+   std::vector<MufluxPatRecSegment> fShort34;       //!
+   std::vector<MufluxPatRecSegment> fShortStereo12; //!
+   std::vector<Int_t> fStereoOrigin;                //!
+   std::vector<MufluxPatRecTrack> fTracks;          //!
+   // work space
+   std::vector<Int_t> fY12, fStereo12, fY34;        //! hit indices per view group
+   std::vector<Double_t> fProjection;               //! stereo hit y at the y segment
+   std::vector<ULong64_t> fUsed;                    //! bitset of the digiHits of accepted segments
+
+   ClassDef(MufluxTrackFinder, 1)
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "MuonTaggerStripTable.h"
+#include "MuonTaggerHit.h"
+
+#include <iostream>
+
+namespace {
+const Int_t kPlanes = MuonTaggerStripTable::kStations * MuonTaggerStripTable::kDirections;
+}
+
+MuonTaggerStripTable::MuonTaggerStripTable()
+   : TObject(), fEnds(6 * kPlanes * kStrips, 0), fKnown(kPlanes * kStrips, 0)
+{
+}
+
+MuonTaggerStripTable::~MuonTaggerStripTable() {}
+
+void MuonTaggerStripTable::SetStrip(Int_t detID, const TVector3 &bot, const TVector3 &top)
+{
+   Int_t index = StripIndex(detID);
+   if (index < 0) {
+      std::cout << "MuonTaggerStripTable::SetStrip: invalid detector ID " << detID << std::endl;
+      return;
+   }
+   Double_t *ends = &fEnds[6 * index];
+   for (Int_t i = 0; i < 3; i++) {
+      ends[i] = bot[i];
+      ends[3 + i] = top[i];
+   }
+   fKnown[index] = 1;
+}
+
+Int_t MuonTaggerStripTable::FillFromGeometry()
+{
+   Int_t n = 0;
+   for (Int_t s = 1; s <= kStations; s++) {
+      for (Int_t d = 0; d < kDirections; d++) {
+         const Int_t nStrips = d == 0 ? kHStrips : kStrips;
+         for (Int_t strip = 1; strip <= nStrips; strip++) {
+            const Int_t detID = s * 10000 + d * 1000 + strip;
+            MuonTaggerHit hit(detID, 0);
+            TVector3 bot, top;
+            hit.EndPoints(bot, top);
+            SetStrip(detID, bot, top);
+            n++;
+         }
+      }
+   }
+   return n;
+}
+
+Bool_t MuonTaggerStripTable::GetEndPoints(Int_t detID, TVector3 &bot, TVector3 &top) const
+{
+   Int_t index = StripIndex(detID);
+   if (index < 0 || !fKnown[index]) {
+      return kFALSE;
+   }
+   const Double_t *ends = &fEnds[6 * index];
+   bot.SetXYZ(ends[0], ends[1], ends[2]);
+   top.SetXYZ(ends[3], ends[4], ends[5]);
+   return kTRUE;
+}
+
+ClassImp(MuonTaggerStripTable)
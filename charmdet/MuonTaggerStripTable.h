@@ -0,0 +1,45 @@
+#ifndef MUONTAGGERSTRIPTABLE_H
+#define MUONTAGGERSTRIPTABLE_H 1
+
+#include "TObject.h"
+#include "TVector3.h"
+
+#include <vector>
+
+/* Lookup table of the RPC strip end points by station, direction and strip, filled once from the
+   geometry (MuonTaggerHit::EndPoints) or with SetStrip, e.g. with alignment corrections.
+   Replaces the geometry navigation of MuonTaggerHit::EndPoints per hit in MufluxDigiReco. */
+class MuonTaggerStripTable : public TObject {
+public:
+   enum { kStations = 5, kDirections = 2, kStrips = 184, kHStrips = 116 };
+
+   MuonTaggerStripTable();
+   virtual ~MuonTaggerStripTable();
+
+   /** Dense index of a strip from station, direction and strip number of the detector ID, -1 if not a strip */
+   static Int_t StripIndex(Int_t detID)
+   {
+      Int_t s = detID / 10000;
+      Int_t d = (detID / 1000) % 10;
+      Int_t strip = detID % 1000;
+      if (detID < 0 || s < 1 || s > kStations || d >= kDirections || strip < 1 ||
+          strip > (d == 0 ? Int_t(kHStrips) : Int_t(kStrips))) {
+         return -1;
+      }
+      return ((s - 1) * kDirections + d) * kStrips + strip - 1;
+   }
+
+   void SetStrip(Int_t detID, const TVector3 &bot, const TVector3 &top);
+   /** End points of all strips from the geometry, needs gGeoManager. Returns the number of strips. */
+   Int_t FillFromGeometry();
+   /** False if the detector ID is not a strip or its end points are not set */
+   Bool_t GetEndPoints(Int_t detID, TVector3 &bot, TVector3 &top) const;
+
+private:
+   std::vector<Double_t> fEnds; // bot x,y,z and top x,y,z by StripIndex
+   std::vector<Int_t> fKnown;   // 1 if the end points are set
+
+   ClassDef(MuonTaggerStripTable, 1)
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "RTRelation.h"
+
+#include "TF1.h"
+#include "TFile.h"
+#include "TGraph.h"
+#include "TH1.h"
+#include "TMath.h"
+#include "TString.h"
+
+#include <iostream>
+#include <memory>
+
+namespace {
+// drift times of the wire and of the tube wall, and the parabola parameters of MufluxDigiReco.RT
+const Double_t kTMin[RTRelation::kStations] = {587, 587, 610, 610};
+const Double_t kTMax[RTRelation::kStations] = {1860, 1860, 2300, 2100};
+const Double_t kP1[RTRelation::kStations] = {688., 688., 923., 819.};
+const Double_t kP2[RTRelation::kStations] = {7.01, 7.01, 4.41, 0.995};
+
+// nBins+1 samples of rt over [tMin,tMax]
+template <typename F>
+std::vector<Float_t> Sample(Int_t nBins, Double_t tMin, Double_t tMax, F rt)
+{
+   std::vector<Float_t> table(nBins + 1);
+   for (Int_t i = 0; i <= nBins; i++) {
+      table[i] = rt(tMin + (tMax - tMin) * i / nBins);
+   }
+   return table;
+}
+} // namespace
+
+RTRelation::RTRelation(Int_t nBins) : TObject(), fNBins(nBins > 0 ? nBins : 1)
+{
+   for (Int_t s = 0; s < kStations; s++) {
+      fModel[s] = kNone;
+      fTMin[s] = fTMax[s] = fScale[s] = fP1[s] = fP2[s] = fR[s] = 0;
+   }
+}
+
+RTRelation::~RTRelation() {}
+
+Double_t RTRelation::Parabola(Int_t s, Double_t t) const
+{
+   Double_t t0_corr = TMath::Max(0., t - fTMin[s]);
+   Double_t tmp1 = TMath::Sqrt(fP1[s] * fP1[s] + 4. * fP2[s] * t0_corr);
+   return (2 * tmp1 - 2 * fP1[s] + fP1[s] * TMath::Log(-fP1[s] + 2 * tmp1) - fP1[s] * TMath::Log(fP1[s])) /
+          (8 * fP2[s]);
+}
+
+void RTRelation::SetParabola(Int_t station, Double_t tMin, Double_t tMax, Double_t p1, Double_t p2)
+{
+   if (station < 1 || station > kStations || !(tMax > tMin)) {
+      std::cout << "RTRelation::SetParabola: invalid station " << station << " or time range " << tMin << " "
+                << tMax << std::endl;
+      return;
+   }
+   Int_t s = station - 1;
+   fModel[s] = kParabola;
+   fTMin[s] = tMin;
+   fTMax[s] = tMax;
+   fScale[s] = fNBins / (tMax - tMin);
+   fP1[s] = p1;
+   fP2[s] = p2;
+   fR[s] = 0;
+   fTable[s] = Sample(fNBins, tMin, tMax, [this, s](Double_t t) { return Parabola(s, t); });
+}
+
+void RTRelation::SetParabolas()
+{
+   for (Int_t s = 0; s < kStations; s++) {
+      SetParabola(s + 1, kTMin[s], kTMax[s], kP1[s], kP2[s]);
+   }
+}
+
+Bool_t RTRelation::SetCalibration(Int_t station, const TObject *rt, Double_t tMin, Double_t tMax, Double_t R)
+{
+   if (station < 1 || station > kStations || !rt || !(tMax > tMin)) {
+      std::cout << "RTRelation::SetCalibration: invalid station " << station << " or time range " << tMin << " "
+                << tMax << std::endl;
+      return kFALSE;
+   }
+   Int_t s = station - 1;
+   if (rt->InheritsFrom(TGraph::Class())) {
+      TGraph *graph = (TGraph *)rt;
+      fTable[s] = Sample(fNBins, tMin, tMax, [graph](Double_t t) { return graph->Eval(t); });
+   } else if (rt->InheritsFrom(TF1::Class())) {
+      TF1 *function = (TF1 *)rt;
+      fTable[s] = Sample(fNBins, tMin, tMax, [function](Double_t t) { return function->Eval(t); });
+   } else if (rt->InheritsFrom(TH1::Class())) {
+      TH1 *histo = (TH1 *)rt;
+      fTable[s] = Sample(fNBins, tMin, tMax, [histo](Double_t t) { return histo->Interpolate(t); });
+   } else {
+      std::cout << "RTRelation::SetCalibration: " << rt->GetName() << " is no TGraph, TF1 or TH1" << std::endl;
+      return kFALSE;
+   }
+   fModel[s] = kCalibration;
+   fTMin[s] = tMin;
+   fTMax[s] = tMax;
+   fScale[s] = fNBins / (tMax - tMin);
+   fP1[s] = fP2[s] = 0;
+   fR[s] = R;
+   return kTRUE;
+}
+
+Int_t RTRelation::LoadFile(const char *filename, Double_t R, const char *format)
+{
+   std::unique_ptr<TFile> f(TFile::Open(filename));
+   if (!f || f->IsZombie()) {
+      std::cout << "RTRelation::LoadFile: cannot open " << filename << std::endl;
+      return 0;
+   }
+   Int_t nLoaded = 0;
+   for (Int_t s = 0; s < kStations; s++) {
+      TString name = TString::Format(format, s + 1);
+      TObject *rt = f->Get(name);
+      if (!rt) {
+         rt = f->Get("RT/" + name);
+      }
+      if (rt && SetCalibration(s + 1, rt, kTMin[s], kTMax[s], R)) {
+         nLoaded++;
+      }
+   }
+   return nLoaded;
+}
+
+void RTRelation::Evaluate(Int_t station, const Float_t *t, Float_t *r, Int_t n) const
+{
+   for (Int_t i = 0; i < n; i++) {
+      r[i] = Eval(station, t[i]);
+   }
+}
+
+void RTRelation::Evaluate(const Int_t *station, const Float_t *t, Float_t *r, Int_t n) const
+{
+   for (Int_t i = 0; i < n; i++) {
+      r[i] = Eval(station[i], t[i]);
+   }
+}
+
+ClassImp(RTRelation)
@@ -0,0 +1,76 @@
+#ifndef RTRELATION_H
+#define RTRELATION_H 1
+
+#include "TObject.h"
+
+#include <vector>
+
+/* Drift time to drift radius of the drift tubes, one relation per station 1-4.
+   The relation, the parabola of MufluxDigiReco or a calibrated TGraph/TF1/TH1, is sampled
+   at load time into a uniform table over [tMin,tMax] and evaluated with linear interpolation.
+     t < tMin   r = 0
+     t > tMax   r = R, the parabola is evaluated exactly
+   The tables are persistent, a relation can be written and read without the calibration objects. */
+class RTRelation : public TObject {
+public:
+   enum Model { kNone, kParabola, kCalibration };
+   enum { kStations = 4 };
+
+   RTRelation(Int_t nBins = 4096);
+   virtual ~RTRelation();
+
+   /** Parabola with parameters p1, p2, drift time of the wire tMin, table up to tMax */
+   void SetParabola(Int_t station, Double_t tMin, Double_t tMax, Double_t p1, Double_t p2);
+   /** Parabolas of all stations with the parameters of MufluxDigiReco */
+   void SetParabolas();
+   /** Sample a TGraph, TF1 or TH1 over [tMin,tMax], R is the tube radius beyond tMax */
+   Bool_t SetCalibration(Int_t station, const TObject *rt, Double_t tMin, Double_t tMax, Double_t R);
+   /** Calibrations of all stations from a file, names from format with the station number, also searched in
+    *  the directory RT of the file. tMin and tMax of MufluxDigiReco. Returns the number of stations loaded. */
+   Int_t LoadFile(const char *filename, Double_t R, const char *format = "rtTDC%d000_x");
+
+   Model GetModel(Int_t station) const
+   {
+      return (station < 1 || station > kStations) ? kNone : Model(fModel[station - 1]);
+   }
+   Int_t GetNBins() const { return fNBins; }
+
+   /** Drift radius [cm] of a drift time [ns], 0 for stations without relation */
+   Float_t Eval(Int_t station, Float_t t) const
+   {
+      if (GetModel(station) == kNone) {
+         return 0;
+      }
+      const Int_t s = station - 1;
+      if (!(t >= fTMin[s])) {
+         return 0;
+      }
+      if (t > fTMax[s]) {
+         return fModel[s] == kParabola ? Parabola(s, t) : fR[s];
+      }
+      const Float_t x = (t - fTMin[s]) * fScale[s];
+      const Int_t i = x < fNBins ? Int_t(x) : fNBins - 1;
+      const Float_t *table = fTable[s].data();
+      return table[i] + (x - i) * (table[i + 1] - table[i]);
+   }
+   /** Drift radii of n drift times of one station, or with the station of each time */
+   void Evaluate(Int_t station, const Float_t *t, Float_t *r, Int_t n) const;
+   void Evaluate(const Int_t *station, const Float_t *t, Float_t *r, Int_t n) const;
+
+private:
+   Double_t Parabola(Int_t s, Double_t t) const;
+
+   Int_t fNBins;
+   Int_t fModel[kStations];
+   Double_t fTMin[kStations];
+   Double_t fTMax[kStations];
+   Double_t fScale[kStations]; // bins per ns
+   Double_t fP1[kStations];
+   Double_t fP2[kStations];
+   Double_t fR[kStations];
+   std::vector<Float_t> fTable[kStations];
+
+   ClassDef(RTRelation, 1)
+};
+
+#endif
@@ -21,6 +21,7 @@ public:
    uint16_t GetChannel() const { return channel % 0x1000; }
    bool hasTimeOverThreshold() const { return !((flags & DriftTubes::NoWidth) == DriftTubes::NoWidth); }
    Float_t GetTimeOverThreshold() const { return time_over_threshold; }
+   uint16_t GetFlags() const { return flags; }
 
 private:
    ScintillatorHit(const ScintillatorHit &other);
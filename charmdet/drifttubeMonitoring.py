@@ -45,6 +45,8 @@ cuts['muTrackMatchX']= 5.
 cuts['muTrackMatchY']= 10.
 cuts['muTaggerCluster_grouping'] = 3
 cuts["RPCmaxDistance"] = 10.
+cuts["RPClinearExtrapolation"] = 0 # 1: tracks to all RPC stations as straight lines, no genfit
+cuts["RPCskipResiduals"] = 0 # 1: no RPC residual histograms for straight tracks, the matched hits come from a binary search
 
 vbot = ROOT.TVector3()
 vtop = ROOT.TVector3()
@@ -1209,9 +1211,19 @@ def plotEvent(n=-1):
 
 viewDict = {0:'_x',1:'_u',2:'_v'}
 def stationInfo(hit):
- info = hit.StationInfo()
- return info[0],info[1],info[2],info[3],viewDict[info[4]],info[5],info[6],info[7]/cuts['RTsegmentation']
- #      statnb,   vnb,    pnb,    lnb,     view,         channelID,tdcId,  nRT
+ info = hit.GetStationInfo()
+ return info.station,info.view,info.plane,info.layer,viewDict[info.iview],info.channel,info.tdcId,info.nRT/cuts['RTsegmentation']
+ #      statnb,      vnb,      pnb,       lnb,       view,                 channelID,   tdcId,      nRT
+
+stationInfoCols = ROOT.MufluxStationInfoColumns()
+def stationInfoColumns(hits):
+ # StationInfo of all hits of a Digi_MufluxSpectrometerHits array as numpy arrays, valid until the next call
+ import numpy
+ n = ROOT.MufluxSpectrometerHit.GetStationInfo(hits,stationInfoCols)
+ cols = {}
+ for x in ['detectorID','station','view','plane','layer','iview','channel','tdcId','nRT']:
+   cols[x] = numpy.frombuffer(getattr(stationInfoCols,x).data(),dtype=numpy.int32,count=n) if n>0 else numpy.zeros(0,dtype=numpy.int32)
+ return cols
 
 tdcIds ={'1000_x':[0],'1001_x':[0],'1010_x':[0],'1011_x':[0],
          '1100_u':[0],'1101_u':[0],'1110_u':[0],'1111_u':[0],
@@ -2281,7 +2293,60 @@ def printClustersPerStation(clusters,s,view):
      print k,':',s,view,2*p+l,x[2],x[3]
    k+=1
 
-def findDTClusters(removeBigClusters=True):
+nativeDTClusters = True
+def findDTClusters(removeBigClusters=True,fillHistos=True):
+   if not nativeDTClusters: return findDTClustersPython(removeBigClusters,fillHistos)
+   DTClusters = ROOT.DTClusterList()
+   muflux_Reco.findDTClusters(sTree.Digi_MufluxSpectrometerHits,DTClusters,removeBigClusters)
+   if fillHistos:
+    for s in range(1,5):
+     for view in viewsI[s]:
+      rc = h['clsN'].Fill(DTClusters[s][view].size())
+   muflux_Reco.splitStereoClusters(DTClusters)
+   clusters = {}
+   for s in range(1,5):
+    clusters[s]={}
+    for view in viewsI[s]:
+     clusters[s][view]=[]
+     for cl in DTClusters[s][view]:
+      clusters[s][view].append([[x.hit,x.x,x.z,x.channel] for x in cl])
+   if Debug:
+    for s in range(1,5):
+     for view in viewsI[s]:
+      printClustersPerStation(clusters,s,view)
+   return clusters
+
+def benchmarkDTClusters(nEvents=1000,nStart=0):
+ # native against python clustering: different clusters and time per event
+ # both draw the MC efficiency fudge factors from gRandom, reseeded per event so that they see the same numbers,
+ # cluster sizes are only histogrammed by the native version
+ global nativeDTClusters
+ native = nativeDTClusters
+ times = {True:0,False:0}
+ nDiff = 0
+ N = min(sTree.GetEntries(),nStart+nEvents)
+ for n in range(nStart,N):
+   rc = sTree.GetEvent(n)
+   result = {}
+   for nativeDTClusters in [True,False]:
+     ROOT.gRandom.SetSeed(n+1)
+     timer.Start()
+     clusters = findDTClusters(removeBigClusters=True,fillHistos=nativeDTClusters)
+     timer.Stop()
+     times[nativeDTClusters]+=timer.RealTime()
+     result[nativeDTClusters] = {}
+     for s in clusters:
+      for view in clusters[s]:
+       result[nativeDTClusters][s*10+view] = sorted([sorted([x[0].GetDetectorID() for x in cl]) for cl in clusters[s][view]])
+   if result[True]!=result[False]:
+     nDiff+=1
+     if Debug: print "benchmarkDTClusters: different clusters in event",n,result
+ nativeDTClusters = native
+ nev = max(1,N-nStart)
+ print "events %i, with different clusters %i"%(N-nStart,nDiff)
+ print "python %8.3F ms/event  native %8.3F ms/event"%(times[False]/nev*1000.,times[True]/nev*1000.)
+
+def findDTClustersPython(removeBigClusters=True,fillHistos=True):
    spectrHitsSorted = ROOT.nestedList()
    muflux_Reco.sortHits(sTree.Digi_MufluxSpectrometerHits,spectrHitsSorted,True)
    if Debug: nicePrintout(spectrHitsSorted)
@@ -2383,7 +2448,7 @@ def findDTClusters(removeBigClusters=True):
          if len(clusters[s][view][ncl])==0:
            clusters[s][view].pop(ncl)
          else: ncl+=1
-     rc = h['clsN'].Fill(ncl)
+     if fillHistos: rc = h['clsN'].Fill(ncl)
 # eventually split too big clusters for stero layers:
    for s in [1,2]:
     for view in viewsI[s]:
@@ -3841,6 +3906,43 @@ def strawPosition():
   b = alignConstants['strawPositions'][detID]['bot']
   t = alignConstants['strawPositions'][detID]['top']
   strawPositionsBotTop[detID]=[ROOT.TVector3(b[0],b[1],b[2]),ROOT.TVector3(t[0],t[1],t[2])]
+ strawPositionsToReco()
+def strawPositionsToReco():
+ # straw positions for the clustering in MufluxReco
+ for detID in strawPositionsBotTop:
+  bot,top = strawPositionsBotTop[detID]
+  muflux_Reco.setStrawPositions(detID,bot,top)
+def alignmentStoreFromModules():
+ # DtAlignmentStore with the tubes of dt_modules, module numbers in the order of the sorted module names
+ # corrections, e.g. from Millepede, with store.SetCorrection(moduleNames.index(name),dx,dy,dz,phi,theta,psi)
+ store = ROOT.DtAlignmentStore()
+ moduleNames = sorted(dt_modules.keys())
+ for m in range(len(moduleNames)):
+  module = dt_modules[moduleNames[m]]
+  store.SetModuleCenter(m,module.get_center_position())
+  for tube in module.get_tubes():
+   top,bot = tube.wire_end_positions()
+   store.SetTube(tube._ID,m,bot,top)
+ return store,moduleNames
+def strawPositionsFromStore(store):
+ # corrected end points of the tubes in the store for the track fit and the clustering
+ vbot,vtop = ROOT.TVector3(),ROOT.TVector3()
+ for detID in strawPositionsBotTop:
+  if store.GetEndPoints(detID,vbot,vtop):
+   strawPositionsBotTop[detID]=[ROOT.TVector3(vbot),ROOT.TVector3(vtop)]
+ strawPositionsToReco()
+def milleRecords(outFile='mp2input.bin',nEvents=-1,compress=False,pMin=3.):
+ # Millepede input for the modules of dt_modules from the fitted tracks, written by DtMilleDriver
+ # labels 100*(m+1)+k, m module number of alignmentStoreFromModules, k=1-3 translation x,y,z, k=4 rotation about z
+ store,moduleNames = alignmentStoreFromModules()
+ writer = ROOT.MilleBufferedWriter(outFile,compress)
+ driver = ROOT.DtMilleDriver(writer,store)
+ driver.SetMinMomentum(pMin)
+ nRecords = driver.ProcessTree(sTree,nEvents)
+ writer.Close()
+ print "Millepede records written: %i, %5.1F MB to %s"%(nRecords,writer.GetNBytes()/1.E6,outFile)
+ for m in range(len(moduleNames)): print "module %2i %s"%(m,moduleNames[m])
+ return moduleNames
 
 RPCPositionsBotTop = {}
 def RPCPosition():
@@ -4461,6 +4563,7 @@ def importAlignmentConstants():
     for straw in xpos:
       hit = ROOT.MufluxSpectrometerHit(straw,0.)
       strawPositionsBotTop[hit.GetDetectorID()]=correctAlignment(hit)
+    strawPositionsToReco()
     print "importing alignment constants from code"
     return
    upkl    = Unpickler(sTree.GetCurrentFile())
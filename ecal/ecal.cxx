@@ -81,6 +81,7 @@ ecal::ecal()
     fCF(),
     fLightMapNames(),
     fLightMaps(),
+    fLightMapInterpolation(0),
     fNLayers(0),
     fModuleLenght(0.),
     fGeoScale(0.),
@@ -157,6 +158,7 @@ ecal::ecal(const char* name, Bool_t active, const char* fileGeo)
     fCF(),
     fLightMapNames(),
     fLightMaps(),
+    fLightMapInterpolation(0),
     fNLayers(0),
     fModuleLenght(0.),
     fGeoScale(0.),
@@ -227,6 +229,8 @@ ecal::ecal(const char* name, Bool_t active, const char* fileGeo)
   fEdging=fInf->GetVariableStrict("tileedging");
   fModuleSize=fInf->GetVariableStrict("modulesize");
   fSimpleGeo=(Int_t)fInf->GetVariableStrict("usesimplegeo");
+  // lightmapinterpolation=1 in the geo file switches to bilinear interpolation of the light maps
+  fLightMapInterpolation=(fInf->GetVariable("lightmapinterpolation")==1)?1:0;
   fDX=fInf->GetVariableStrict("xpos");
   fDY=fInf->GetVariableStrict("ypos");
 
@@ -489,7 +493,10 @@ Bool_t  ecal::ProcessHits(FairVolume* vol)
       py=(y-py)/fYCell[type];
       if (px>=0&&px<1&&py>=0&&py<1)
       {
-        fELoss*=fLightMaps[type]->Data(px-0.5, py-0.5);
+        if (fLightMapInterpolation)
+          fELoss*=fLightMaps[type]->Interpolate(px-0.5, py-0.5);
+        else
+          fELoss*=fLightMaps[type]->Data(px-0.5, py-0.5);
         FillLitePoint(0);
       }
     }
@@ -1263,15 +1270,12 @@ void ecal::ConstructTileSimple(Int_t type, Int_t material)
 // ----- Public method GetCellCoordInf ----------------------------------------
 Bool_t ecal::GetCellCoordInf(Int_t fVolID, Float_t &x, Float_t &y, Int_t& tenergy)
 {
-  static ecalInf* inf=NULL;
+  // Initialized once, also if called from several reconstruction threads
+  static ecalInf* inf=ecalInf::GetInstance(NULL);
   if (inf==NULL)
   {
-    inf=ecalInf::GetInstance(NULL);
-    if (inf==NULL)
-    {
-      cerr << "ecal::GetCellCoordInf(): Can't get geometry information." << endl;
-      return kFALSE;
-    }
+    cerr << "ecal::GetCellCoordInf(): Can't get geometry information." << endl;
+    return kFALSE;
   }
   Int_t volid=fVolID;
   Int_t cell=volid%100-1; volid=volid-cell-1; volid/=100;
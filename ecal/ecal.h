@@ -180,6 +180,8 @@ private:
   TString fLightMapNames[cMaxModuleType];		//!
   /** Light maps **/
   ecalLightMap* fLightMaps[cMaxModuleType];		//!
+  /** Use bilinear interpolation of light maps instead of the map cells **/
+  Int_t fLightMapInterpolation;		//!
   /** number of layers per cell **/
   Int_t   fNLayers;			//!
   /** Lenght of calorimeter module **/
@@ -11,37 +11,46 @@
 
 using std::cout;
 using std::endl;
-using std::map;
+using std::lower_bound;
 using std::list;
 
 //-----------------------------------------------------------------------------
 ecalCellMC::ecalCellMC(Int_t cellnumber, Float_t x1, Float_t y1, Float_t x2, Float_t y2, Char_t type, Float_t energy)
   : ecalCell(cellnumber, x1, y1, x2, y2, type, energy),
-    fTrackEnergy(),
-    fTrackTime()
+    fTrackContributions(NULL),
+    fNTrackContributions(0)
 {
 }
+//-----------------------------------------------------------------------------
+const ecalTrackContribution* ecalCellMC::FindTrack(Int_t num) const
+{
+  const ecalTrackContribution* p=lower_bound(GetTrackEnergyBegin(), GetTrackEnergyEnd(), num,
+    [](const ecalTrackContribution& c, Int_t track) {return c.fTrack<track;});
+  if (p==GetTrackEnergyEnd()||p->fTrack!=num) return NULL;
+  return p;
+}
+
 //-----------------------------------------------------------------------------
 Float_t ecalCellMC::GetTrackTime(Int_t num) const
 {
-  map<Int_t, Float_t>::const_iterator p=fTrackTime.find(num);
-  if (p==fTrackTime.end()) return 0; else return p->second;
+  const ecalTrackContribution* p=FindTrack(num);
+  if (p==NULL||p->fTime==-1111) return 0; else return p->fTime;
 }
 
 
 //-----------------------------------------------------------------------------
 Float_t ecalCellMC::GetTrackEnergy(Int_t num) const
 {
-  map<Int_t, Float_t>::const_iterator p=fTrackEnergy.find(num);
-  if (p==fTrackEnergy.end()) return 0; else return p->second;
+  const ecalTrackContribution* p=FindTrack(num);
+  if (p==NULL) return 0; else return p->fEnergy;
 }
 
 //-----------------------------------------------------------------------------
 void ecalCellMC::ResetEnergy()
 {
   ResetEnergyFast();
-  fTrackEnergy.clear();
-  fTrackTime.clear();
+  fTrackContributions=NULL;
+  fNTrackContributions=0;
 }
 
 //-----------------------------------------------------------------------------
@@ -55,26 +64,18 @@ Float_t ecalCellMC::GetTrackClusterEnergy(Int_t num)
   return energy;
 }
 
-// Don't use slow methods except in emergency!!! 
 //-----------------------------------------------------------------------------
 void ecalCellMC::GetTrackEnergySlow(Int_t n, Int_t& trackid, Double_t& energy_dep)
 {
-  map<Int_t, Float_t>::const_iterator p=fTrackEnergy.begin();
-  if (n>=fTrackEnergy.size()) {trackid=-1111; energy_dep=-1111; return; }
-  Int_t i=0;
-  for(i=0;i<n;i++) (++p);
-  trackid=p->first; energy_dep=p->second;
+  if (n>=fNTrackContributions) {trackid=-1111; energy_dep=-1111; return; }
+  trackid=fTrackContributions[n].fTrack; energy_dep=fTrackContributions[n].fEnergy;
 }
 
-// Don't use slow methods except in emergency!!! 
 //-----------------------------------------------------------------------------
 void ecalCellMC::GetTrackTimeSlow(Int_t n, Int_t& trackid, Float_t& time)
 {
-  map<Int_t, Float_t>::const_iterator p=fTrackTime.begin();
-  if (n>=fTrackTime.size()) {trackid=-1111; time=-1111; return; }
-  Int_t i=0;
-  for(i=0;i<n;i++) (++p);
-  trackid=p->first; time=p->second;
+  if (n>=fNTrackContributions) {trackid=-1111; time=-1111; return; }
+  trackid=fTrackContributions[n].fTrack; time=fTrackContributions[n].fTime;
 }
 
 ClassImp(ecalCellMC)
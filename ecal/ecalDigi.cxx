@@ -21,7 +21,7 @@ ecalDigi::ecalDigi()
     fADCMax(16384),
     fADCNoise(1.0e-3),
     fADCChannel(1.0e-3),
-    fStr(NULL), fChannelMap()
+    fStr(NULL), fRandom(NULL), fChannelMap()
 {
   fChannelMap.clear();
 }
@@ -33,7 +33,7 @@ ecalDigi::ecalDigi(const char* name, Int_t iVerbose)
     fADCMax(16384),
     fADCChannel(1.0e-3),
     fADCNoise(1.0e-3),
-    fStr(NULL), fChannelMap()
+    fStr(NULL), fRandom(NULL), fChannelMap()
 {
   fChannelMap.clear();
 }
@@ -95,22 +95,24 @@ void ecalDigi::Exec(Option_t* option)
   fStr->GetCells(cells);
   list<ecalCell*>::const_iterator p=cells.begin();
   Short_t adc;
+  TRandom* rnd=fRandom;
 
+  if (!rnd) rnd=gRandom;
   for(;p!=cells.end();++p)
   {
     cell=(*p);
     if (fChannelMap.empty())
-      adc=(Short_t)(gRandom->Gaus(cell->GetEnergy(), fADCNoise)/fADCChannel+fPedestal);
+      adc=(Short_t)(rnd->Gaus(cell->GetEnergy(), fADCNoise)/fADCChannel+fPedestal);
     else
     if (fChannelMap.find(cell->GetCellNumber())==fChannelMap.end())
     {
       Error("Exec", "Channel %d not found in map. Using default value!", cell->GetCellNumber());
       //TODO: Should we insert Fatal here?
-      adc=(Short_t)(gRandom->Gaus(cell->GetEnergy(), fADCNoise)/fADCChannel+fPedestal);
+      adc=(Short_t)(rnd->Gaus(cell->GetEnergy(), fADCNoise)/fADCChannel+fPedestal);
     }
     else
     {
-      adc=(Short_t)(gRandom->Gaus(cell->GetEnergy(), fADCNoise)/fChannelMap[cell->GetCellNumber()]+fPedestal);
+      adc=(Short_t)(rnd->Gaus(cell->GetEnergy(), fADCNoise)/fChannelMap[cell->GetCellNumber()]+fPedestal);
     }
     if (adc>fADCMax) adc=fADCMax;
     cell->SetEnergy(-1111);
@@ -9,6 +9,7 @@
 #include <map>
 
 class ecalStructure;
+class TRandom;
 
 class ecalDigi : public FairTask
 {
@@ -32,6 +33,8 @@ public:
   void SetADCMax(Short_t adcmax=16384) {fADCMax=adcmax;}
   void SetADCNoise(Float_t adcnoise=1.0e-3) {fADCNoise=adcnoise;}
   void SetADCChannel(Float_t adcchannel=1.0e-3) {fADCChannel=adcchannel;}
+  //Generator for the ADC noise. gRandom if not set
+  void SetRandom(TRandom* random) {fRandom=random;}
 
   //Map: channel number -> ADC channel in GeV 
   void SetChannelMap(std::map<Int_t, Float_t> map) {fChannelMap=map;}
@@ -53,6 +56,8 @@ private:
   Float_t fADCChannel;
   // Calorimeter structure
   ecalStructure* fStr;	//!
+  // Generator for the ADC noise
+  TRandom* fRandom;	//!
 
   // May be better use Float_t*?
   std::map<Int_t, Float_t> fChannelMap;	//! Map: channel number -> ADC channel in GeV
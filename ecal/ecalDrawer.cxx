@@ -364,7 +364,7 @@ void ecalDrawer::DrawCells()
   ShipMCTrack* tr;
   ShipMCTrack* tq;
   Float_t max;
-  std::map<Int_t, Float_t>::const_iterator p1;
+  const ecalTrackContribution* p1;
   ecalCellMC* c;
   Int_t rn=fClusters->GetEntriesFast();
   Int_t i;
@@ -403,16 +403,16 @@ void ecalDrawer::DrawCells()
     (*p)->fB=0;
     for(p1=c->GetTrackEnergyBegin();p1!=c->GetTrackEnergyEnd();++p1)
     {
-      tr=(ShipMCTrack*)fMCTracks->At(p1->first);
+      tr=(ShipMCTrack*)fMCTracks->At(p1->fTrack);
       if (tr==NULL) continue;
       if (tr->GetPdgCode()==22)
-	(*p)->fR+=p1->second;
+	(*p)->fR+=p1->fEnergy;
       else
       if (tr->GetMotherId()>=0)
       {
 	tq=(ShipMCTrack*)fMCTracks->At(tr->GetMotherId());
 	if (tr->GetMotherId()==22)
-	  (*p)->fR+=p1->second;
+	  (*p)->fR+=p1->fEnergy;
       }
     }
     if (find(clusters.begin(), clusters.end(), c)==clusters.end())
@@ -6,7 +6,7 @@
 class ecalLightMap : public TNamed
 {
 public:
- ecalLightMap() : TNamed(), fSSide(0.), fS(0), fSize(0), fData(NULL) {};
+ ecalLightMap() : TNamed(), fSSide(0.), fInvSSide(0.), fS(0), fSize(0), fData(NULL), fNodes(NULL) {};
   ecalLightMap(const char* fname, const char* title="Light collection efficiency map");
   Double_t Data(Double_t x, Double_t y)
     {Int_t n=GetNum(x,y); if (n<0) return n; return fData[n];}
@@ -15,26 +15,55 @@ public:
     Double_t lx=x+0.5; Double_t ly=y+0.5;
     if (lx<0) lx=0; if (ly<0) ly=0;
     if (lx>1) lx=1; if (ly>1) ly=1;
-    Int_t ix=(Int_t)(lx/fSSide);
-    Int_t iy=(Int_t)(ly/fSSide);
+    Int_t ix=(Int_t)(lx*fInvSSide);
+    Int_t iy=(Int_t)(ly*fInvSSide);
+    if (ix>=fS) ix=fS-1; if (iy>=fS) iy=fS-1;
     return iy*fS+ix;
   }
-  virtual ~ecalLightMap() {delete fData;}
+  /** Bilinear interpolation between the centers of the map cells.
+   ** x and y are in the same units as for Data **/
+  Double_t Interpolate(Double_t x, Double_t y)
+  {
+    Double_t lx=(x+0.5)*fInvSSide-0.5; Double_t ly=(y+0.5)*fInvSSide-0.5;
+    if (lx<0) lx=0; if (ly<0) ly=0;
+    if (lx>fS-1) lx=fS-1; if (ly>fS-1) ly=fS-1;
+    Int_t ix=(Int_t)lx; Int_t iy=(Int_t)ly;
+    Double_t dx=lx-ix; Double_t dy=ly-iy;
+    const Double_t* p=fNodes+iy*(fS+1)+ix;
+    Double_t v0=p[0]+dx*(p[1]-p[0]);
+    Double_t v1=p[fS+1]+dx*(p[fS+2]-p[fS+1]);
+    return v0+dy*(v1-v0);
+  }
+  virtual ~ecalLightMap() {delete [] fData; delete [] fNodes;}
 private:
   /** Read information from file **/
   void Init(const char* filename);
+  /** Read the processed map from the binary sidecar of the map file.
+   ** Returns kFALSE if the sidecar is missing, older than the map file,
+   ** of another version or byte order, or malformed **/
+  Bool_t ReadBinary(const char* filename);
+  /** Write the processed map to the binary sidecar of the map file,
+   ** through a temporary file renamed in place **/
+  void WriteBinary(const char* filename);
+  /** Fill the grid used by Interpolate **/
+  void InitNodes();
   /** Fix a light collection map **/
   void FillGaps();
   /** Set average efficiency of light collection to 1.0 **/
   void Normalize();
   /** Step of the light map **/
   Double_t fSSide;		//!
+  /** Inverse of the step of the light map **/
+  Double_t fInvSSide;		//!
   /** Size of side of the light map in steps**/
   Int_t fS;			//!
   /** Size of the light map **/
   Int_t fSize;			//!
   /** Light collection efficiency map **/
   Double_t* fData;		//!
+  /** Light collection efficiency map with an extra row and column
+   ** repeating the last ones, so Interpolate needs no boundary checks **/
+  Double_t* fNodes;		//!
 
   ecalLightMap(const ecalLightMap&);
   ecalLightMap& operator=(const ecalLightMap&);
@@ -10,10 +10,27 @@
 
 #include <iostream>
 #include <list>
-#include <map>
+#include <algorithm>
 
 using namespace std;
 
+/** Sum energies of entries with the same track. Entries of a track are summed
+ ** in the order they were added, as it was done with std::map before **/
+void ecalMatch::Merge(std::vector<ecalMatchEntry>& entries)
+{
+  sort(entries.begin(), entries.end());
+  UInt_t i;
+  UInt_t n=0;
+  for(i=0;i<entries.size();i++)
+  {
+    if (n>0&&entries[n-1].fTrack==entries[i].fTrack)
+      entries[n-1].fEnergy+=entries[i].fEnergy;
+    else
+      entries[n++]=entries[i];
+  }
+  entries.erase(entries.begin()+n, entries.end());
+}
+
 void ecalMatch::Exec(Option_t* option,TClonesArray* reconstructed,TClonesArray* mctracks)
 {
   fReconstucted=reconstructed;
@@ -22,18 +39,18 @@ void ecalMatch::Exec(Option_t* option,TClonesArray* reconstructed,TClonesArray*
 
   Int_t n=fReconstucted->GetEntries();
   Int_t i;
+  Int_t j;
   ecalReconstructed* rc;
   ecalCell* cell;
   ecalCellMC* mccell;
   list<ecalCell*> cells;
   list<ecalCell*>::const_iterator p;
-  map<Int_t, Float_t> e;
-  map<Int_t, Float_t> e2;
-  map<Int_t, Float_t>::const_iterator ep;
-  map<Int_t, Float_t>::reverse_iterator rp;
+  const ecalTrackContribution* ep;
   ShipMCTrack* tr;
   Int_t trn;
+  Int_t order;
   Float_t max;
+  Float_t energy;
 //  if (fVerbose>0) Info("Exec", "Event %d.", fEv);
   for(i=0;i<n;i++)
   {
@@ -49,32 +66,28 @@ void ecalMatch::Exec(Option_t* option,TClonesArray* reconstructed,TClonesArray*
     else
       cell->Get5x5Cluster(cells);
 
-    e.clear(); e2.clear();
+    fE.clear(); fE2.clear();
+    order=0;
     //Counting energy depositions for all particles
     for(p=cells.begin();p!=cells.end();++p)
     {
       mccell=(ecalCellMC*)(*p);
       for(ep=mccell->GetTrackEnergyBegin();ep!=mccell->GetTrackEnergyEnd();++ep)
-      {
-	if (e.find(ep->first)==e.end())
-	  e[ep->first]=ep->second;
-	else
-	  e[ep->first]+=ep->second;
-      }
+	fE.push_back(ecalMatchEntry(ep->fTrack, order++, ep->fEnergy));
     }
+    Merge(fE);
 
     //...and parent photons and electrons/positrons
-    for(ep=e.begin();ep!=e.end();++ep)
+    order=0;
+    for(j=0;j<(Int_t)fE.size();j++)
     {
-      if (e2.find(ep->first)==e.end())
-	e2[ep->first]=ep->second;
-      else
-	e2[ep->first]+=ep->second;
-      if (ep->first<0&&fVerbose==0) continue;
-      tr=(ShipMCTrack*)fMCTracks->At(ep->first);
+      energy=fE[j].fEnergy;
+      fE2.push_back(ecalMatchEntry(fE[j].fTrack, order++, energy));
+      if (fE[j].fTrack<0&&fVerbose==0) continue;
+      tr=(ShipMCTrack*)fMCTracks->At(fE[j].fTrack);
       if (tr==NULL)
       {
-	Info("Exec", "Event %d. Can't find MCTrack %d.", fEv, ep->first);
+	Info("Exec", "Event %d. Can't find MCTrack %d.", fEv, fE[j].fTrack);
 	continue;
       }
       for(;;)
@@ -85,23 +98,21 @@ void ecalMatch::Exec(Option_t* option,TClonesArray* reconstructed,TClonesArray*
 	tr=(ShipMCTrack*)fMCTracks->At(trn);
 	if (tr==NULL)
 	{
-	  Info("Exec", "Event %d. Can't find MCTrack %d.", fEv, ep->first);
+	  Info("Exec", "Event %d. Can't find MCTrack %d.", fEv, fE[j].fTrack);
 	  break;
 	}
 	if (tr->GetPdgCode()!=22&&TMath::Abs(tr->GetPdgCode())!=11) break;
-	if (e2.find(trn)==e2.end())
-	  e2[trn]=ep->second;
-	else
-	  e2[trn]+=ep->second;
+	fE2.push_back(ecalMatchEntry(trn, order++, energy));
       }
     }
+    Merge(fE2);
 
     //Maximum location
     max=-1e11; trn=-1111;
-    for(rp=e2.rbegin();rp!=e2.rend();++rp)
+    for(j=(Int_t)fE2.size()-1;j>=0;j--)
     {
-      if (rp->second>max)
-	{ max=rp->second; trn=rp->first;}
+      if (fE2[j].fEnergy>max)
+	{ max=fE2[j].fEnergy; trn=fE2[j].fTrack;}
     }
 
     if (trn>=0)
@@ -119,7 +130,7 @@ void ecalMatch::Exec(Option_t* option,TClonesArray* reconstructed,TClonesArray*
 /** Standard constructor **/
 ecalMatch::ecalMatch(const char* name, const Int_t verbose)
   : FairTask(name, verbose), fEv(0), fN(0), fRejected(0), fUse3x3(0), 
-    fReconstucted(NULL), fMCTracks(NULL), fStr(NULL) 
+    fReconstucted(NULL), fMCTracks(NULL), fStr(NULL), fE(), fE2()
 {
   ;
 }
@@ -127,7 +138,7 @@ ecalMatch::ecalMatch(const char* name, const Int_t verbose)
 /** Only to comply with frame work. **/
 ecalMatch::ecalMatch()
   : FairTask(), fEv(0), fN(0), fRejected(0), fUse3x3(0), 
-    fReconstucted(NULL), fMCTracks(NULL), fStr(NULL)
+    fReconstucted(NULL), fMCTracks(NULL), fStr(NULL), fE(), fE2()
 {
   ;
 }
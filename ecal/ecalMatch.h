@@ -5,9 +5,24 @@
 
 #include "FairTask.h"
 
+#include <vector>
+
 class TClonesArray;
 class ecalStructure;
 
+/** Energy of a MC track in a cluster. The order of addition is kept,
+ ** so energies are summed in the same order after sorting **/
+struct ecalMatchEntry
+{
+  ecalMatchEntry(Int_t track, Int_t order, Float_t energy)
+    : fTrack(track), fOrder(order), fEnergy(energy) {};
+  bool operator<(const ecalMatchEntry& r) const
+    {return fTrack<r.fTrack||(fTrack==r.fTrack&&fOrder<r.fOrder);}
+  Int_t fTrack;
+  Int_t fOrder;
+  Float_t fEnergy;
+};
+
 class ecalMatch : public FairTask
 {
 public:
@@ -30,6 +45,8 @@ public:
   /** Destructor **/
   ~ecalMatch();
 private:
+  /** Sort entries by track and sum energies of the same track **/
+  void Merge(std::vector<ecalMatchEntry>& entries);
   /** Current event **/
   Int_t fEv;
   /** Current reconstructed particle **/
@@ -45,6 +62,10 @@ private:
   TClonesArray* fMCTracks;		//!
   /** A calorimeter structure **/
   ecalStructure* fStr;			//!
+  /** Energy depositions of tracks in the cluster, reused between clusters **/
+  std::vector<ecalMatchEntry> fE;	//!
+  /** Same with energy of daughters added to parent photons and electrons **/
+  std::vector<ecalMatchEntry> fE2;	//!
 
   ClassDef(ecalMatch, 1)
 };
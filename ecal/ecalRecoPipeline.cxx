@@ -0,0 +1,255 @@
+#include "ecalRecoPipeline.h"
+
+#include "ecalStructure.h"
+#include "ecalStructureFiller.h"
+#include "ecalDigi.h"
+#include "ecalPrepare.h"
+#include "ecalMaximumLocator.h"
+#include "ecalClusterFinder.h"
+#include "ecalClusterCalibration.h"
+#include "ecalReco.h"
+#include "ecalMatch.h"
+#include "ecalPoint.h"
+
+#include "ShipMCTrack.h"
+
+#include "TClonesArray.h"
+#include "TFormula.h"
+#include "TRandom3.h"
+#include "TROOT.h"
+
+#include <thread>
+
+using namespace std;
+
+/** Only to comply with frame work. **/
+ecalRecoPipeline::ecalRecoPipeline()
+  : TObject(),
+    fFileGeo(""),
+    fSeed(13),
+    fNEvents(0),
+    fWorkers(),
+    fEvents()
+{
+  ;
+}
+
+/** Standard constructor **/
+ecalRecoPipeline::ecalRecoPipeline(const char* fileGeo, Int_t nworkers, ecalClusterCalibration* calib, Int_t verbose)
+  : TObject(),
+    fFileGeo(fileGeo),
+    fSeed(13),
+    fNEvents(0),
+    fWorkers(),
+    fEvents()
+{
+  Int_t i;
+
+  if (nworkers<1) nworkers=1;
+  if (nworkers>1) ROOT::EnableThreadSafety();
+  for(i=0;i<nworkers;i++)
+    fWorkers.push_back(CreateWorker(calib, verbose));
+  if (verbose>0)
+    Info("ecalRecoPipeline", "%d reconstruction chains created.", nworkers);
+}
+
+/** Create a reconstruction chain with its own calorimeter structure.
+ ** The settings are the ones used in shipDigiReco **/
+ecalRecoWorker* ecalRecoPipeline::CreateWorker(ecalClusterCalibration* calib, Int_t verbose)
+{
+  ecalRecoWorker* worker=new ecalRecoWorker();
+  TClonesArray* maximums;
+  Int_t i;
+
+  worker->fFiller=new ecalStructureFiller("ecalFiller", verbose, fFileGeo);
+  worker->fFiller->SetUseMCPoints(kTRUE);
+  worker->fFiller->StoreTrackInformation();
+  worker->fDigi=new ecalDigi("ecalDigi", 0);
+  worker->fPrepare=new ecalPrepare("ecalPrepare", 0);
+  worker->fMaximumLocator=new ecalMaximumLocator("maximumFinder", verbose);
+  worker->fClusterFinder=new ecalClusterFinder("clusterFinder", verbose);
+  worker->fReco=new ecalReco("ecalReco", 0);
+  worker->fMatch=new ecalMatch("ecalMatch", 0);
+
+  /** TFormula evaluation is not guaranteed to be thread safe, so each worker has its copy **/
+  worker->fCalib=new ecalClusterCalibration("ecalClusterCalibration", 0);
+  if (calib)
+  for(i=0;i<10;i++)
+  {
+    if (calib->StraightCalibration(i))
+      worker->fCalib->SetStraightCalibration(i, (TFormula*)calib->StraightCalibration(i)->Clone());
+    if (calib->Calibration(i))
+      worker->fCalib->SetCalibration(i, (TFormula*)calib->Calibration(i)->Clone());
+  }
+
+  worker->fRandom=new TRandom3(fSeed);
+  worker->fDigi->SetRandom(worker->fRandom);
+
+  worker->fStr=worker->fFiller->InitPython(NULL);
+  worker->fDigi->InitPython(worker->fStr);
+  worker->fPrepare->InitPython(worker->fStr);
+  maximums=worker->fMaximumLocator->InitPython(worker->fStr);
+  worker->fClusters=worker->fClusterFinder->InitPython(worker->fStr, maximums, worker->fCalib);
+  worker->fReconstructed=worker->fReco->InitPython(worker->fClusters, worker->fStr, worker->fCalib);
+  worker->fMatch->InitPython(worker->fStr, worker->fReconstructed, NULL);
+
+  return worker;
+}
+
+void ecalRecoPipeline::DeleteWorker(ecalRecoWorker* worker)
+{
+  Int_t i;
+
+  /** Output arrays are owned by the tasks **/
+  delete worker->fMatch;
+  delete worker->fReco;
+  delete worker->fClusterFinder;
+  delete worker->fMaximumLocator;
+  delete worker->fPrepare;
+  delete worker->fDigi;
+  delete worker->fFiller;
+  for(i=0;i<10;i++)
+  {
+    delete worker->fCalib->StraightCalibration(i);
+    delete worker->fCalib->Calibration(i);
+  }
+  delete worker->fCalib;
+  delete worker->fStr;
+  delete worker->fRandom;
+  delete worker;
+}
+
+/** Copy ECAL points and MC tracks of the given entry into the batch **/
+void ecalRecoPipeline::AddEvent(Long64_t entry, TClonesArray* litePoints, TClonesArray* mctracks)
+{
+  ecalRecoEvent* event;
+  ecalPoint* pt;
+  Int_t i;
+  Int_t n;
+
+  if (fNEvents==(Int_t)fEvents.size())
+  {
+    event=new ecalRecoEvent();
+    event->fPoints=new TClonesArray("ecalPoint", 1000);
+    event->fMCTracks=new TClonesArray("ShipMCTrack", 1000);
+    event->fClusters=new TClonesArray("ecalCluster", 100);
+    event->fReconstructed=new TClonesArray("ecalReconstructed", 100);
+    fEvents.push_back(event);
+  }
+  event=fEvents[fNEvents++];
+  event->fEntry=entry;
+
+  event->fPoints->Clear();
+  n=litePoints->GetEntriesFast();
+  for(i=0;i<n;i++)
+  {
+    pt=(ecalPoint*)litePoints->At(i);
+    new((*event->fPoints)[i]) ecalPoint(pt->GetTrackID(), pt->GetDetectorID(), pt->GetTime(), pt->GetEnergyLoss(), pt->GetEventID());
+  }
+  event->fMCTracks->Clear();
+  n=mctracks->GetEntriesFast();
+  for(i=0;i<n;i++)
+    new((*event->fMCTracks)[i]) ShipMCTrack(*(ShipMCTrack*)mctracks->At(i));
+}
+
+/** Reconstruct all events of the batch with the worker threads **/
+void ecalRecoPipeline::Process()
+{
+  std::atomic<Int_t> next(0);
+  vector<thread> threads;
+  UInt_t i;
+
+  if (fWorkers.size()==1||fNEvents<2)
+  {
+    Run(fWorkers[0], &next);
+    return;
+  }
+  for(i=0;i<fWorkers.size()&&(Int_t)i<fNEvents;i++)
+    threads.push_back(thread(&ecalRecoPipeline::Run, this, fWorkers[i], &next));
+  for(i=0;i<threads.size();i++)
+    threads[i].join();
+}
+
+/** Take events from the batch until it is empty **/
+void ecalRecoPipeline::Run(ecalRecoWorker* worker, std::atomic<Int_t>* next)
+{
+  Int_t i;
+
+  for(i=(*next)++;i<fNEvents;i=(*next)++)
+    Reconstruct(worker, fEvents[i]);
+}
+
+/** Reconstruct one event with the chain of the worker **/
+void ecalRecoPipeline::Reconstruct(ecalRecoWorker* worker, ecalRecoEvent* event)
+{
+  worker->fRandom->SetSeed(fSeed+event->fEntry);
+  worker->fFiller->Exec("start", event->fPoints);
+  worker->fDigi->Exec("start");
+  worker->fPrepare->Exec("start");
+  worker->fMaximumLocator->Exec("start");
+  worker->fClusterFinder->Exec("start");
+  worker->fReco->Exec("start");
+  worker->fMatch->Exec("start", worker->fReconstructed, event->fMCTracks);
+
+  /** Objects are moved, the arrays of the worker are empty afterwards **/
+  event->fClusters->Delete();
+  event->fClusters->AbsorbObjects(worker->fClusters);
+  event->fReconstructed->Delete();
+  event->fReconstructed->AbsorbObjects(worker->fReconstructed);
+}
+
+/** Is entry part of the current batch? **/
+Bool_t ecalRecoPipeline::HasEvent(Long64_t entry) const
+{
+  Int_t i;
+
+  for(i=0;i<fNEvents;i++)
+    if (fEvents[i]->fEntry==entry) return kTRUE;
+  return kFALSE;
+}
+
+/** Move clusters and reconstructed objects of the entry to the given arrays **/
+Bool_t ecalRecoPipeline::FillEvent(Long64_t entry, TClonesArray* clusters, TClonesArray* reconstructed)
+{
+  Int_t i;
+
+  for(i=0;i<fNEvents;i++)
+    if (fEvents[i]->fEntry==entry) break;
+  if (i==fNEvents)
+  {
+    Error("FillEvent", "Entry %lld is not in the current batch.", entry);
+    return kFALSE;
+  }
+  clusters->Delete();
+  clusters->AbsorbObjects(fEvents[i]->fClusters);
+  reconstructed->Delete();
+  reconstructed->AbsorbObjects(fEvents[i]->fReconstructed);
+  return kTRUE;
+}
+
+/** Start a new batch **/
+void ecalRecoPipeline::Clear(Option_t* option)
+{
+  fNEvents=0;
+}
+
+/** Destructor **/
+ecalRecoPipeline::~ecalRecoPipeline()
+{
+  UInt_t i;
+
+  for(i=0;i<fWorkers.size();i++)
+    DeleteWorker(fWorkers[i]);
+  for(i=0;i<fEvents.size();i++)
+  {
+    delete fEvents[i]->fPoints;
+    delete fEvents[i]->fMCTracks;
+    fEvents[i]->fClusters->Delete();
+    delete fEvents[i]->fClusters;
+    fEvents[i]->fReconstructed->Delete();
+    delete fEvents[i]->fReconstructed;
+    delete fEvents[i];
+  }
+}
+
+ClassImp(ecalRecoPipeline)
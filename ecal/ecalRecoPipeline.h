@@ -0,0 +1,114 @@
+/* Parallel reconstruction for the calorimeter.
+ * The chain ecalStructureFiller -> ecalDigi -> ecalPrepare -> ecalMaximumLocator ->
+ * ecalClusterFinder -> ecalReco -> ecalMatch is instantiated once per worker, each
+ * worker with its own ecalStructure. Events of a batch are distributed over worker
+ * threads and the results are given back in event order. */
+
+#ifndef ECALRECOPIPELINE_H
+#define ECALRECOPIPELINE_H
+
+#include "TObject.h"
+#include "TString.h"
+
+#include <vector>
+#include <atomic>
+
+class TClonesArray;
+class TRandom;
+class ecalStructure;
+class ecalStructureFiller;
+class ecalDigi;
+class ecalPrepare;
+class ecalMaximumLocator;
+class ecalClusterFinder;
+class ecalClusterCalibration;
+class ecalReco;
+class ecalMatch;
+
+/** Calorimeter reconstruction chain of one worker thread **/
+struct ecalRecoWorker
+{
+  ecalStructureFiller* fFiller;
+  ecalDigi* fDigi;
+  ecalPrepare* fPrepare;
+  ecalMaximumLocator* fMaximumLocator;
+  ecalClusterFinder* fClusterFinder;
+  ecalClusterCalibration* fCalib;
+  ecalReco* fReco;
+  ecalMatch* fMatch;
+  ecalStructure* fStr;
+  TRandom* fRandom;
+  TClonesArray* fClusters;
+  TClonesArray* fReconstructed;
+};
+
+/** Input and output of one event of a batch **/
+struct ecalRecoEvent
+{
+  Long64_t fEntry;
+  TClonesArray* fPoints;
+  TClonesArray* fMCTracks;
+  TClonesArray* fClusters;
+  TClonesArray* fReconstructed;
+};
+
+class ecalRecoPipeline : public TObject
+{
+public:
+  /** Only to comply with frame work. **/
+  ecalRecoPipeline();
+  /** Standard constructor.
+   *@param fileGeo   ECAL geometry file, as for ecalStructureFiller
+   *@param nworkers  number of worker threads, each with its own reconstruction chain
+   *@param calib     cluster calibration, the formulas are copied for each worker
+   *@param verbose   verbosity of the tasks of the chain **/
+  ecalRecoPipeline(const char* fileGeo, Int_t nworkers, ecalClusterCalibration* calib, Int_t verbose=0);
+  /** Destructor **/
+  virtual ~ecalRecoPipeline();
+
+  /** Seed for the ADC noise. The generator of a worker is reseeded with
+   ** seed+entry for each event, so the result does not depend on the
+   ** distribution of events over threads **/
+  void SetSeed(UInt_t seed=13) {fSeed=seed;}
+  UInt_t GetSeed() const {return fSeed;}
+  Int_t GetNWorkers() const {return fWorkers.size();}
+  Int_t GetNEvents() const {return fNEvents;}
+
+  /** Copy ECAL points and MC tracks of the given entry into the batch **/
+  void AddEvent(Long64_t entry, TClonesArray* litePoints, TClonesArray* mctracks);
+  /** Reconstruct all events of the batch with the worker threads **/
+  void Process();
+  /** Is entry part of the current batch? **/
+  Bool_t HasEvent(Long64_t entry) const;
+  /** Move clusters and reconstructed objects of the entry to the given arrays.
+   ** Returns kFALSE if the entry is not part of the batch.
+   ** Transient pointers of the clusters to the maximums are not valid here **/
+  Bool_t FillEvent(Long64_t entry, TClonesArray* clusters, TClonesArray* reconstructed);
+  /** Start a new batch **/
+  virtual void Clear(Option_t* option="");
+private:
+  /** Reconstruct one event with the chain of the worker **/
+  void Reconstruct(ecalRecoWorker* worker, ecalRecoEvent* event);
+  /** Take events from the batch until it is empty **/
+  void Run(ecalRecoWorker* worker, std::atomic<Int_t>* next);
+  ecalRecoWorker* CreateWorker(ecalClusterCalibration* calib, Int_t verbose);
+  void DeleteWorker(ecalRecoWorker* worker);
+
+  /** Geometry file **/
+  TString fFileGeo;
+  /** Seed for the ADC noise **/
+  UInt_t fSeed;
+  /** Number of events in the current batch **/
+  Int_t fNEvents;
+  /** Reconstruction chains, one per thread **/
+  std::vector<ecalRecoWorker*> fWorkers;	//!
+  /** Events of the batch. Kept between batches to reuse the arrays **/
+  std::vector<ecalRecoEvent*> fEvents;		//!
+
+  ecalRecoPipeline(const ecalRecoPipeline&);
+  ecalRecoPipeline& operator=(const ecalRecoPipeline&);
+
+  ClassDef(ecalRecoPipeline, 1)
+};
+
+#endif
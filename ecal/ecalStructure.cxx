@@ -21,8 +21,7 @@ using namespace std;
 ecalCell* ecalStructure::GetCell(Int_t volId, Int_t& ten, Bool_t& isPS)
 {
   UInt_t i;
-  static Int_t volidmax = 0;
-  volidmax=10000000;
+  const Int_t volidmax=10000000;
 
   if ((Int_t)fHash.size()<volidmax)
   {
@@ -76,7 +75,8 @@ ecalStructure::ecalStructure(ecalInf* ecalinf)
     fEcalInf(ecalinf),
     fStructure(),
     fCells(),
-    fHash()
+    fHash(),
+    fTrackContributions()
 {
   fX1=fEcalInf->GetXPos()-\
     fEcalInf->GetModuleSize()*fEcalInf->GetXSize()/2.0;
@@ -321,6 +321,41 @@ void ecalStructure::ResetModules()
   {
     for(;p!=fCells.end();++p)
     ((ecalCellMC*)(*p))->ResetEnergy();
+    fTrackContributions.clear();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ecalStructure::SortTrackContributions()
+{
+  // Stable sort keeps the order of MC points, so energies of a track
+  // in a cell are summed in the same order as before
+  stable_sort(fTrackContributions.begin(), fTrackContributions.end(),
+    [](const ecalTrackContribution& a, const ecalTrackContribution& b)
+    {return a.fCell<b.fCell||(a.fCell==b.fCell&&a.fTrack<b.fTrack);});
+
+  // Merge contributions of the same track: sum of energies and earliest time
+  Int_t n=0;
+  for(UInt_t i=0;i<fTrackContributions.size();i++)
+  {
+    const ecalTrackContribution& c=fTrackContributions[i];
+    if (n>0&&fTrackContributions[n-1].fCell==c.fCell&&fTrackContributions[n-1].fTrack==c.fTrack)
+    {
+      ecalTrackContribution& m=fTrackContributions[n-1];
+      m.fEnergy+=c.fEnergy;
+      if (c.fTime!=-1111&&(m.fTime==-1111||m.fTime>c.fTime)) m.fTime=c.fTime;
+    }
+    else
+      fTrackContributions[n++]=c;
+  }
+  fTrackContributions.resize(n);
+
+  Int_t first=0;
+  for(Int_t i=1;i<=n;i++)
+  {
+    if (i<n&&fTrackContributions[i].fCell==fTrackContributions[first].fCell) continue;
+    fTrackContributions[first].fCellMC->SetTrackContributions(&fTrackContributions[first], i-first);
+    first=i;
   }
 }
 
@@ -11,6 +11,7 @@
 #include "ecalInf.h"
 #include "ecalModule.h"
 #include "ecalCell.h"
+#include "ecalCellMC.h"
 
 #include "TMath.h"
 #include "TNamed.h"
@@ -46,6 +47,13 @@ public:
   //Create neighbors lists
   void CreateNLists(ecalCell* cell);
   void ResetModules();
+
+  /** MC track information of the event. Contributions are collected in a flat
+   ** table, SortTrackContributions merges them per (cell, track) and hands
+   ** every ecalCellMC its part of the table. **/
+  inline void AddTrackContribution(ecalCellMC* cell, Int_t track, Float_t energy, Float_t time=-1111);
+  void SortTrackContributions();
+  inline const std::vector<ecalTrackContribution>& GetTrackContributions() const {return fTrackContributions;}
   
   ecalModule* CreateModule(char type, Int_t number, Float_t x1, Float_t y1, Float_t x2, Float_t y2);
   //Some usefull procedures for hit processing
@@ -85,6 +93,8 @@ private:
   std::list<ecalCell*> fCells;
   /** MCPoint id -> ECAL cell**/
   std::vector<__ecalCellWrapper*> fHash;
+  /** Contributions of MC tracks to cells in this event **/
+  std::vector<ecalTrackContribution> fTrackContributions;	//!
 
   ecalStructure(const ecalStructure&);
   ecalStructure& operator=(const ecalStructure&);
@@ -173,6 +183,13 @@ inline Float_t ecalStructure::GetEnergy(Float_t x, Float_t y, Bool_t isPS) const
   return -1111;
 }
 
+inline void ecalStructure::AddTrackContribution(ecalCellMC* cell, Int_t track, Float_t energy, Float_t time)
+{
+  ecalTrackContribution c;
+  c.fCell=cell->GetCellNumber(); c.fCellMC=cell; c.fTrack=track; c.fEnergy=energy; c.fTime=time;
+  fTrackContributions.push_back(c);
+}
+
 //Converts (x,y) to hit Id
 inline Int_t ecalStructure::GetHitId(Float_t x, Float_t y) const
 {
@@ -125,16 +125,19 @@ void ecalStructureFiller::LoopForMCPoints()
     }
   }
   if (fStoreTrackInfo)
-  for(UInt_t j=0; j<n; j++)
   {
-    pt=(ecalPoint*)fListECALpts->At(j);
-    ecalCellMC* cellmc=(ecalCellMC*)fStr->GetCell(pt->GetDetectorID(), ten, isPS);
-    if (ten==0) {
-      if (isPS)
-        ; // cell->AddTrackPSEnergy(pt->GetTrackID(),pt->GetEnergyLoss()); //preshower removed
-      else
-        cellmc->AddTrackEnergy(pt->GetTrackID(),pt->GetEnergyLoss(), pt->GetTime());
+    for(UInt_t j=0; j<n; j++)
+    {
+      pt=(ecalPoint*)fListECALpts->At(j);
+      ecalCellMC* cellmc=(ecalCellMC*)fStr->GetCell(pt->GetDetectorID(), ten, isPS);
+      if (ten==0) {
+        if (isPS)
+          ; // cell->AddTrackPSEnergy(pt->GetTrackID(),pt->GetEnergyLoss()); //preshower removed
+        else
+          fStr->AddTrackContribution(cellmc, pt->GetTrackID(), pt->GetEnergyLoss(), pt->GetTime());
+      }
     }
+    fStr->SortTrackContributions();
   }
 }
 
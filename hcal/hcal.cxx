@@ -82,6 +82,7 @@ hcal::hcal()
     fCF(0),
     fLightMapName(""),
     fLightMap(NULL),
+    fLightMapInterpolation(0),
     fNLayers(0),
     fModuleLength(0.),
     fVolIdMax(0),
@@ -152,6 +153,7 @@ hcal::hcal(const char* name, Bool_t active, const char* fileGeo)
     fCF(0),
     fLightMapName(""),
     fLightMap(NULL),
+    fLightMapInterpolation(0),
     fNLayers(0),
     fModuleLength(0.),
     fVolIdMax(0),
@@ -213,6 +215,8 @@ hcal::hcal(const char* name, Bool_t active, const char* fileGeo)
   fEdging=fInf->GetVariableStrict("tileedging");
   fModuleSize=fInf->GetVariableStrict("modulesize");
   fSimpleGeo=(Int_t)fInf->GetVariableStrict("usesimplegeo");
+  // lightmapinterpolation=1 in the geo file switches to bilinear interpolation of the light maps
+  fLightMapInterpolation=(fInf->GetVariable("lightmapinterpolation")==1)?1:0;
   fFastMC=(Int_t)fInf->GetVariableStrict("fastmc");
   fDX=fInf->GetVariableStrict("xpos");
   fDY=fInf->GetVariableStrict("ypos");
@@ -445,7 +449,10 @@ Bool_t  hcal::ProcessHits(FairVolume* vol)
       py=(y-py)/fYCell;
       if (px>=0&&px<1&&py>=0&&py<1)
       {
-        fELoss*=fLightMap->Data(px-0.5, py-0.5);
+        if (fLightMapInterpolation)
+          fELoss*=fLightMap->Interpolate(px-0.5, py-0.5);
+        else
+          fELoss*=fLightMap->Data(px-0.5, py-0.5);
         FillLitePoint(0);
       }
     }
@@ -181,6 +181,8 @@ private:
   TString fLightMapName;		//!
   /** Light maps **/
   hcalLightMap* fLightMap;		//!
+  /** Use bilinear interpolation of light maps instead of the map cells **/
+  Int_t fLightMapInterpolation;		//!
   /** number of layers per module **/
   Int_t   fNLayers;			//!
   /** number of layers in first section **/
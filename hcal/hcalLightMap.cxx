@@ -1,27 +1,37 @@
 #include "hcalLightMap.h"
 
 #include "TSystem.h"
+#include "TString.h"
 
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <list>
 #include <stdlib.h>
+#include <string.h>
 
 using namespace std;
 
 hcalLightMap::hcalLightMap(const char* fname, const char* title) 
   : TNamed(fname, title),
-    fSSide(-1111.), fS(-1111), fSize(0), fData(NULL)
+    fSSide(-1111.), fInvSSide(-1111.), fS(-1111), fSize(0), fData(NULL), fNodes(NULL)
 {
   Init(fname);
 }
 
+/** Binary sidecar of a light map: magic, version, byte order mark, size of
+ ** side in steps, step and the map after FillGaps and Normalize. Numbers are
+ ** in the byte order of the writing machine, the mark rejects other ones **/
+static const char cLightMapMagic[8]={'S','H','I','P','L','M','A','P'};
+static const Int_t cLightMapVersion=2;
+static const UInt_t cLightMapByteOrder=0x01020304;
+
 /** Read information from file **/
 void hcalLightMap::Init(const char* filename)
 {
   TString fn=filename;
   gSystem->ExpandPathName(fn);
+  if (ReadBinary(fn)) return;
   ifstream f(fn);
   list<Double_t> lst;
   string buf;
@@ -71,7 +81,7 @@ void hcalLightMap::Init(const char* filename)
 
   xsize=(*p); ++p; ysize=(*p); ++p; sqside=(*p); ++p;
   fS=(Int_t)((xsize+0.00001)/sqside);
-  fSize=fS*fS; fSSide=sqside/xsize;
+  fSize=fS*fS; fSSide=sqside/xsize; fInvSSide=1.0/fSSide;
   fData=new Double_t[fSize];
   for(i=0;i<fSize;i++)
     fData[i]=-1111;
@@ -93,6 +103,93 @@ void hcalLightMap::Init(const char* filename)
   lst.clear();
   FillGaps();
   Normalize();
+  InitNodes();
+  WriteBinary(fn);
+}
+
+/** Read the processed map from the binary sidecar of the map file **/
+Bool_t hcalLightMap::ReadBinary(const char* filename)
+{
+  TString bn=filename; bn+=".bin";
+  FileStat_t st;
+  FileStat_t bst;
+  if (gSystem->GetPathInfo(bn, bst)!=0) return kFALSE;
+  if (gSystem->GetPathInfo(filename, st)==0&&st.fMtime>bst.fMtime) return kFALSE;
+  ifstream f(bn, ios::binary);
+  if (!f) return kFALSE;
+
+  char magic[8];
+  Int_t version;
+  UInt_t byteOrder;
+  Int_t s;
+  Double_t sside;
+  f.read(magic, sizeof(magic));
+  f.read((char*)&version, sizeof(version));
+  f.read((char*)&byteOrder, sizeof(byteOrder));
+  f.read((char*)&s, sizeof(s));
+  f.read((char*)&sside, sizeof(sside));
+  if (!f||memcmp(magic, cLightMapMagic, sizeof(magic))!=0||version!=cLightMapVersion||byteOrder!=cLightMapByteOrder)
+  {
+    Info("ReadBinary","Ignoring light map %s of another version or byte order.", bn.Data());
+    return kFALSE;
+  }
+  // the map has to fill the rest of the file exactly
+  Long64_t header=sizeof(magic)+sizeof(version)+sizeof(byteOrder)+sizeof(s)+sizeof(sside);
+  if (s<=0||sside<=0||bst.fSize!=header+(Long64_t)s*s*(Long64_t)sizeof(Double_t))
+  {
+    Info("ReadBinary","Ignoring malformed light map %s.", bn.Data());
+    return kFALSE;
+  }
+  Double_t* data=new Double_t[s*s];
+  f.read((char*)data, s*s*sizeof(Double_t));
+  if (!f)
+  {
+    Info("ReadBinary","Ignoring truncated light map %s.", bn.Data());
+    delete [] data;
+    return kFALSE;
+  }
+  fS=s; fSize=s*s; fSSide=sside; fInvSSide=1.0/fSSide;
+  fData=data;
+  InitNodes();
+  return kTRUE;
+}
+
+/** Write the processed map to the binary sidecar of the map file.
+ ** The sidecar is written to a temporary file renamed at the end, so a
+ ** reader never sees a partly written map **/
+void hcalLightMap::WriteBinary(const char* filename)
+{
+  TString bn=filename; bn+=".bin";
+  TString tmp=bn; tmp+=Form(".%d.tmp", gSystem->GetPid());
+  ofstream f(tmp, ios::binary|ios::trunc);
+  // Map directory may be read only, the text map is used then
+  if (!f) return;
+  f.write(cLightMapMagic, sizeof(cLightMapMagic));
+  f.write((const char*)&cLightMapVersion, sizeof(cLightMapVersion));
+  f.write((const char*)&cLightMapByteOrder, sizeof(cLightMapByteOrder));
+  f.write((const char*)&fS, sizeof(fS));
+  f.write((const char*)&fSSide, sizeof(fSSide));
+  f.write((const char*)fData, fSize*sizeof(Double_t));
+  f.close();
+  if (!f||gSystem->Rename(tmp, bn)!=0)
+  {
+    Info("WriteBinary","Can't write light map %s.", bn.Data());
+    gSystem->Unlink(tmp);
+  }
+}
+
+/** Fill the grid used by Interpolate **/
+void hcalLightMap::InitNodes()
+{
+  Int_t i;
+  Int_t j;
+  Int_t n=fS+1;
+
+  delete [] fNodes;
+  fNodes=new Double_t[n*n];
+  for(j=0;j<n;j++)
+  for(i=0;i<n;i++)
+    fNodes[j*n+i]=fData[(j<fS?j:fS-1)*fS+(i<fS?i:fS-1)];
 }
 
 /** Fix a light collection map **/
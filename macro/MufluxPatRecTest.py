@@ -0,0 +1,103 @@
+#!/usr/bin/env python
+# comparison of the pattern recognition of python/MufluxPatRec.py with MufluxTrackFinder (C++)
+# both run on the same random events: straight tracks through the drift tube stations, with a kink in the magnet,
+# missing hits and noise hits. The tracks have to be identical: digiHits of y12, stereo12 and 34 in order,
+# momentum and position in the magnet. Several tracks per event give clone candidates with the same number of hits,
+# whose order is the one of equal values in np.argsort (not stable above 16 elements), which MufluxTrackFinder
+# reproduces for numpy without SIMD sorting (numpy < 1.25 or no AVX-512). Exits with 1 if a difference is found
+import ROOT,sys,getopt,random
+import MufluxPatRec
+
+nEvents = 1000
+seed = 5
+maxTracks = 4
+
+try:
+        opts, args = getopt.getopt(sys.argv[1:], "n:s:t:",["nEvents=","seed=","maxTracks="])
+except getopt.GetoptError:
+        print ' enter --nEvents=  --seed= --maxTracks='
+        sys.exit()
+for o, a in opts:
+        if o in ("-n", "--nEvents",):
+            nEvents = int(a)
+        if o in ("-s", "--seed",):
+            seed = int(a)
+        if o in ("-t", "--maxTracks",):
+            maxTracks = int(a)
+
+z_center = 350.75
+def zLayer(s,v,p,l):
+  return (s-1)*150 + v*20 + p*5 + l*2.5 + (200 if s>2 else 0)
+
+def makeEvent():
+  " SmearedHits of random tracks, in random order"
+  hits = []
+  key = 0
+  tracks = []
+  for t in range(random.randint(1,maxTracks)):
+    tracks.append( (random.uniform(-20,20),random.uniform(-0.05,0.05),random.uniform(-20,20),random.uniform(-0.03,0.03),random.uniform(-0.05,0.05)) )
+  for s in range(1,5):
+    for v in ([0,1] if s<3 else [0]):
+      stereo = (s==1 and v==1) or (s==2 and v==0)
+      for p in range(2):
+        for l in range(2):
+          z = zLayer(s,v,p,l)
+          for x0,tx,y0,ty,tx34 in tracks:
+            if random.random()<0.1: continue
+            x = x0+tx*z if s<3 else x0+tx*z_center+tx34*(z-z_center)
+            y = y0+ty*z
+            detID = s*10000000+v*1000000+p*100000+l*10000+2000+random.randint(1,48)
+            if stereo:
+              # wire through (x,y), tilted
+              a = 0.06*(1 if s==1 else -1)
+              hits.append( {'digiHit':key,'xtop':x+a*(60-y),'ytop':60.,'xbot':x+a*(-60-y),'ybot':-60.,'z':z,'detID':detID} )
+            else:
+              hits.append( {'digiHit':key,'xtop':x+random.gauss(0,0.3),'ytop':60.,'xbot':x,'ybot':-60.,'z':z,'detID':detID} )
+            key+=1
+          if random.random()<0.3:
+            x = random.uniform(-40,40)
+            detID = s*10000000+v*1000000+p*100000+l*10000+2000+random.randint(1,48)
+            hits.append( {'digiHit':key,'xtop':x,'ytop':60.,'xbot':x+(3 if stereo else 0),'ybot':-60.,'z':z,'detID':detID} )
+            key+=1
+  random.shuffle(hits)
+  return hits
+
+def same(a,b):
+  return abs(a-b) < 1E-6*max(1.,abs(a))
+
+random.seed(seed)
+finder = ROOT.MufluxTrackFinder()
+patRecHits = ROOT.MufluxPatRecHits()
+nTracks = 0
+nDiff = 0
+for n in range(nEvents):
+  SmearedHits = makeEvent()
+  track_hits = MufluxPatRec.execute(SmearedHits, [], 0, False)
+  reference = []
+  for i_track in sorted(track_hits.keys()):
+    atrack = track_hits[i_track]
+    reference.append( ([x['digiHit'] for x in atrack['y12']],[x['digiHit'] for x in atrack['stereo12']],[x['digiHit'] for x in atrack['34']],
+                       atrack['p'],atrack['x_in_magnet'],atrack['y_in_magnet']) )
+  patRecHits.Clear()
+  for ahit in SmearedHits:
+    patRecHits.Add(ahit['detID'],ahit['digiHit'],ahit['xtop'],ahit['ytop'],ahit['xbot'],ahit['ybot'],ahit['z'])
+  native = []
+  for i_track in range(finder.Execute(patRecHits)):
+    atrack = finder.GetTrack(i_track)
+    native.append( ([SmearedHits[i]['digiHit'] for i in atrack.y12],[SmearedHits[i]['digiHit'] for i in atrack.stereo12],[SmearedHits[i]['digiHit'] for i in atrack.y34],
+                    atrack.p,atrack.xInMagnet,atrack.yInMagnet) )
+  nTracks += len(reference)
+  different = len(native) != len(reference)
+  for k in range(min(len(reference),len(native))):
+    r,c = reference[k],native[k]
+    if r[:3] != c[:3] or not (same(r[3],c[3]) and same(r[4],c[4]) and same(r[5],c[5])):
+      different = True
+      print 'event ',n,': first different track ',k
+      break
+  if different:
+    nDiff += 1
+    print 'event ',n,': ',len(reference),' python tracks, ',len(native),' native tracks'
+
+print 'compared ',nEvents,' events with ',nTracks,' tracks'
+print 'events with different tracks: ',nDiff
+if nDiff > 0: sys.exit(1)
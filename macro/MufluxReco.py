@@ -14,6 +14,7 @@ dy  = None
 saveDisk  = False # remove input file
 pidProton = False # if true, take truth, if False fake with pion mass
 realPR = ''
+nativePR = False # with realPR, the C++ MufluxTrackFinder instead of MufluxPatRec.py
 withT0 = False
 
 import resource
@@ -39,7 +40,7 @@ shipRoot_conf.configure()
 
 try:
         opts, args = getopt.getopt(sys.argv[1:], "o:D:FHPu:n:f:g:c:hqv:sl:A:Y:i:t:",\
-           ["ecalDebugDraw","inputFile=","geoFile=","nEvents=","noStrawSmearing","noVertexing","saveDisk","realPR","withT0", "withNTaggerHits=", "withDist2Wire"])
+           ["ecalDebugDraw","inputFile=","geoFile=","nEvents=","noStrawSmearing","noVertexing","saveDisk","realPR","nativePR","withT0", "withNTaggerHits=", "withDist2Wire"])
 except getopt.GetoptError:
         # print help information and exit:
         print ' enter --inputFile=  --geoFile= --nEvents=  --firstEvent=,'
@@ -71,6 +72,8 @@ for o, a in opts:
             saveDisk = True
         if o in ("--realPR",):
             realPR = "_PR"
+        if o in ("--nativePR",):
+            nativePR = True
 
 
 # need to figure out which geometry was used
@@ -345,6 +348,7 @@ fgeo.FAIRGeom
 builtin.debug    = debug
 builtin.withT0 = withT0
 builtin.realPR = realPR
+builtin.nativePR = nativePR
 
 builtin.ShipGeo = ShipGeo
 builtin.modules = modules
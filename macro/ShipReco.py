@@ -14,6 +14,8 @@ pidProton = False # if true, take truth, if False fake with pion mass
 realPR = ''
 realPROptions=["FH", "AR", "TemplateMatching"]
 withT0 = False
+nativeSplitcalClustering = False
+ecalWorkers = 0 # >1: ECAL reconstruction with this number of threads
 
 import resource
 def mem_monitor():
@@ -37,12 +39,14 @@ shipRoot_conf.configure()
 
 try:
         opts, args = getopt.getopt(sys.argv[1:], "o:D:FHPu:n:f:g:c:hqv:sl:A:Y:i:",\
-           ["ecalDebugDraw","inputFile=","geoFile=","nEvents=","noStrawSmearing","noVertexing","saveDisk","realPR=","withT0"])
+           ["ecalDebugDraw","inputFile=","geoFile=","nEvents=","noStrawSmearing","noVertexing","saveDisk","realPR=","withT0","nativeSplitcalClustering","ecalWorkers="])
 except getopt.GetoptError:
         # print help information and exit:
         print ' enter --inputFile=  --geoFile= --nEvents=  --firstEvent=,'
         print ' noStrawSmearing: no smearing of distance to wire, default on'
         print ' outputfile will have same name with _rec added'  
+        print ' --nativeSplitcalClustering: use the C++ splitcalClusterFinder instead of the python splitcal clustering'
+        print ' --ecalWorkers= number of threads for the ECAL reconstruction, default serial'
         print ' --realPR= defines track pattern recognition. Possible options: ',realPROptions, "if no option given, fake PR is used."
         print ' Options description:'
         print '      FH                        : Hough transform.'
@@ -56,6 +60,10 @@ for o, a in opts:
             withNoStrawSmearing = True
         if o in ("--withT0",):
             withT0 = True
+        if o in ("--nativeSplitcalClustering",):
+            nativeSplitcalClustering = True
+        if o in ("--ecalWorkers",):
+            ecalWorkers = int(a)
         if o in ("-f", "--inputFile",):
             inputFile = a
         if o in ("-g", "--geoFile",):
@@ -142,6 +150,8 @@ builtin.debug    = debug
 builtin.fieldMaker = fieldMaker
 builtin.pidProton = pidProton
 builtin.withT0 = withT0
+builtin.nativeSplitcalClustering = nativeSplitcalClustering
+builtin.ecalWorkers = ecalWorkers
 builtin.realPR = realPR
 builtin.vertexing = vertexing
 builtin.ecalGeoFile = ecalGeoFile
@@ -0,0 +1,73 @@
+#!/usr/bin/env python
+# convert a raw muon flux spill file to a flat tree of hit columns (MufluxColumnarWriter),
+# without writing the TClonesArrays of hit objects unless --keepObjects is given.
+# --spill=cycle (and --triggers=first:last) convert only part of the file, seeking with the index sidecar.
+# --t0File= per channel drift tube t0s ("TDC channel t0[ns]" per line), reloaded at each spill if modified.
+# analysis reads only the columns it needs, e.g.
+#   df = ROOT.RDataFrame('hits','spill_columns.root')
+#   h  = df.Define('t','dt_time[dt_tot>10]').Histo1D('t')
+import ROOT,sys,getopt
+
+inputFile   = 'spill.raw'
+outFile     = 'spill_columns.root'
+objectsFile = 'spill_objects.root'
+keepObjects = False
+useMmap     = False
+charm       = False
+nThreads    = 0
+nEvents     = -1
+spill       = -1
+triggers    = None
+t0File      = None
+
+try:
+        opts, args = getopt.getopt(sys.argv[1:], "f:o:n:",["inputFile=","outputFile=","nEvents=","keepObjects=","mmap","charm","threads=","spill=","triggers=","t0File="])
+except getopt.GetoptError:
+        print ' enter --inputFile= --outputFile= --nEvents= --keepObjects=file (also write hit objects) --mmap --charm --threads= --spill= --triggers=first:last --t0File='
+        sys.exit()
+for o, a in opts:
+        if o in ("-f", "--inputFile",):
+            inputFile = a
+        if o in ("-o", "--outputFile",):
+            outFile = a
+        if o in ("-n", "--nEvents",):
+            nEvents = int(a)
+        if o in ("--keepObjects",):
+            keepObjects = True
+            objectsFile = a
+        if o in ("--mmap",):
+            useMmap = True
+        if o in ("--charm",):
+            charm = True
+        if o in ("--threads",):
+            nThreads = int(a)
+        if o in ("--spill",):
+            spill = int(a)
+        if o in ("--triggers",):
+            triggers = [int(x) for x in a.split(':')]
+        if o in ("--t0File",):
+            t0File = a
+
+source = ROOT.ShipTdcSource(inputFile)
+source.SetUseMmap(useMmap)
+source.SetNThreads(nThreads)
+if spill>=0:
+   if triggers: source.SelectTriggers(spill,triggers[0],triggers[1])
+   else:        source.SelectSpill(spill)
+unpackers = [ROOT.DriftTubeUnpack(charm),ROOT.RPCUnpack(),ROOT.ScalerUnpack()]
+if t0File: unpackers[0].SetT0File(t0File)
+writer = ROOT.MufluxColumnarWriter(outFile)
+for unpacker in unpackers:
+   # the drift tube and RPC hits go from the decoding to the columns, hit objects are only made with --keepObjects
+   unpacker.SetPersistence(keepObjects)
+   source.AddUnpacker(unpacker)
+writer.AddUnpacker(unpackers[0])
+writer.AddUnpacker(unpackers[1])
+run = ROOT.FairRunOnline(source)
+# FairRunOnline needs an output file, it only gets the event headers if the objects are not kept
+run.SetOutputFile(objectsFile if keepObjects else outFile.replace('.root','_header.root'))
+run.AddTask(writer)
+run.Init()
+ROOT.FairLogger.GetLogger().SetLogScreenLevel("WARNING")
+run.Run(nEvents,0)
+print 'columns written to ',outFile
@@ -0,0 +1,177 @@
+#!/usr/bin/env python
+# leading/trailing edge matching of the drift tube frames (partition 0x0C00) of a raw spill file,
+# DriftTubes::EdgeMatcher compared to the std::set/std::sort/per channel map version it replaced.
+# both are run over all frames, results are checked to be identical.
+import ROOT,os,sys,getopt
+
+inputFile = 'spill.raw'
+nRepeat   = 10
+
+try:
+        opts, args = getopt.getopt(sys.argv[1:], "f:n:",["inputFile=","nRepeat="])
+except getopt.GetoptError:
+        print ' enter --inputFile= --nRepeat= (default 10 passes over the frames)'
+        sys.exit()
+for o, a in opts:
+        if o in ("-f", "--inputFile",):
+            inputFile = a
+        if o in ("-n", "--nRepeat",):
+            nRepeat = int(a)
+
+ROOT.gInterpreter.AddIncludePath(os.environ['FAIRSHIP']+'/online')
+ROOT.gInterpreter.Declare('''
+#include "DriftTubeMatching.h"
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace DriftTubeMatchingBenchmark {
+std::vector<std::vector<RawDataHit>> frames;
+size_t nMatches = 0;
+
+void AddFrame(const char *data, uint16_t size)
+{
+   auto df = reinterpret_cast<const DataFrame *>(data);
+   if (df->header.partitionId == 0x0C00) {
+      auto nhits = (size - sizeof(DataFrameHeader)) / sizeof(RawDataHit);
+      frames.emplace_back(df->hits, df->hits + nhits);
+   }
+}
+
+// Frames of the drift tubes, also as sub-frames of event builder frames
+size_t ReadFrames(const char *filename)
+{
+   std::ifstream in(filename, std::ios::binary);
+   std::vector<char> buffer(UINT16_MAX);
+   DataFrameHeader header;
+   while (in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+      if (header.size < sizeof(header)) {
+         break;
+      }
+      std::copy_n(reinterpret_cast<char *>(&header), sizeof(header), buffer.data());
+      in.read(buffer.data() + sizeof(header), header.size - sizeof(header));
+      if (header.partitionId != 0x8000) {
+         AddFrame(buffer.data(), header.size);
+         continue;
+      }
+      for (size_t offset = sizeof(header); offset < header.size;) {
+         auto sub = reinterpret_cast<const DataFrameHeader *>(buffer.data() + offset);
+         if (sub->size < sizeof(header)) {
+            break;
+         }
+         AddFrame(buffer.data() + offset, sub->size);
+         offset += sub->size;
+      }
+   }
+   return frames.size();
+}
+
+std::vector<DriftTubes::EdgeMatch> ReferenceMatch(const std::vector<RawDataHit> &hits)
+{
+   std::vector<DriftTubes::EdgeMatch> matches;
+   std::set<uint16_t> channels;
+   std::vector<RawDataHit> leading, trailing;
+   for (auto &&hit : hits) {
+      channels.emplace(hit.channelId % 0x1000);
+      (hit.channelId < 0x1000 ? leading : trailing).emplace_back(hit);
+   }
+   auto compare_hit_time = [](const RawDataHit &a, const RawDataHit &b) { return a.hitTime < b.hitTime; };
+   std::sort(leading.begin(), leading.end(), compare_hit_time);
+   std::sort(trailing.begin(), trailing.end(), compare_hit_time);
+   std::unordered_map<uint16_t, std::vector<uint16_t>> channel_leading, channel_trailing;
+   for (auto &&hit : leading) {
+      channel_leading[hit.channelId % 0x1000].emplace_back(hit.hitTime);
+   }
+   for (auto &&hit : trailing) {
+      channel_trailing[hit.channelId % 0x1000].emplace_back(hit.hitTime);
+   }
+   for (auto &&channel : channels) {
+      bool first = true;
+      auto l = channel_leading[channel];
+      auto t = channel_trailing[channel];
+      for (int i = 0, j = 0; i < int(l.size()); i++) {
+         if (j < int(t.size()) && l[i] < t[j] && (i + 1 >= int(l.size()) || t[j] < l[i + 1])) {
+            matches.push_back({channel, l[i], float(0.098 * (t[j] - l[i])), first, true});
+            first = false;
+            j++;
+         } else if (j < int(t.size()) && l[i] > t[j] && (j + 1) < int(t.size())) {
+            i--;
+            j++;
+         } else {
+            matches.push_back({channel, l[i], 167.2f, first, false});
+            first = false;
+         }
+      }
+   }
+   return matches;
+}
+
+bool Same(const std::vector<DriftTubes::EdgeMatch> &a, const std::vector<DriftTubes::EdgeMatch> &b)
+{
+   if (a.size() != b.size()) {
+      return false;
+   }
+   for (size_t i = 0; i < a.size(); i++) {
+      if (a[i].channel != b[i].channel || a[i].time != b[i].time ||
+          a[i].time_over_threshold != b[i].time_over_threshold || a[i].first != b[i].first ||
+          a[i].matched != b[i].matched) {
+         return false;
+      }
+   }
+   return true;
+}
+
+// Returns the number of frames with different results
+int Check()
+{
+   DriftTubes::EdgeMatcher matcher;
+   int n = 0;
+   for (auto &&frame : frames) {
+      n += !Same(matcher.Match(frame.data(), frame.size()), ReferenceMatch(frame));
+   }
+   return n;
+}
+
+// Seconds for nRepeat passes, the number of matches is summed so nothing is optimised away
+double TimeReference(int nRepeat)
+{
+   auto start = std::chrono::steady_clock::now();
+   for (int k = 0; k < nRepeat; k++) {
+      for (auto &&frame : frames) {
+         nMatches += ReferenceMatch(frame).size();
+      }
+   }
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double TimeMatcher(int nRepeat)
+{
+   DriftTubes::EdgeMatcher matcher;
+   auto start = std::chrono::steady_clock::now();
+   for (int k = 0; k < nRepeat; k++) {
+      for (auto &&frame : frames) {
+         nMatches += matcher.Match(frame.data(), frame.size()).size();
+      }
+   }
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+}
+''')
+bench = ROOT.DriftTubeMatchingBenchmark
+
+nFrames = bench.ReadFrames(inputFile)
+if nFrames == 0:
+  print 'no drift tube frames found in ',inputFile
+  sys.exit()
+nHits = sum(f.size() for f in bench.frames)
+nDiff = bench.Check()
+tRef = bench.TimeReference(nRepeat)
+tNew = bench.TimeMatcher(nRepeat)
+print 'drift tube frames       : ',nFrames,' (',nHits,' hits)'
+print 'frames with differences : ',nDiff
+print 'reference     [us/frame]: %8.2F'%(tRef/(nFrames*nRepeat)*1.E6)
+print 'EdgeMatcher   [us/frame]: %8.2F'%(tNew/(nFrames*nRepeat)*1.E6)
+if tNew>0:
+  print 'speedup                 : %8.2F'%(tRef/tNew)
@@ -0,0 +1,125 @@
+#!/usr/bin/env python
+# histogram lookups of MufluxReco::fillHitMaps on a full run: names built per hit and resolved with
+# gDirectory->GetList()->FindObject (as before the registry) compared to MufluxHistoRegistry,
+# and the time of fillHitMaps itself, serial and with MufluxReco::runAnalyses in nThreads threads.
+# Histograms are booked as in drifttubeMonitoring.py.
+import ROOT,os,sys,getopt
+
+inputFile = 'ntuple-SPILLDATA_8000_0515759009_20180721_165312_RT.root'
+nEvents   = -1
+RTsegmentation = 12
+nThreads  = 4
+
+try:
+        opts, args = getopt.getopt(sys.argv[1:], "f:n:t:",["inputFile=","nEvents=","nThreads="])
+except getopt.GetoptError:
+        print ' enter --inputFile= (reconstructed run, e.g. a merged spill file) --nEvents= (default all) --nThreads= (default 4)'
+        sys.exit()
+for o, a in opts:
+        if o in ("-f", "--inputFile",):
+            inputFile = a
+        if o in ("-n", "--nEvents",):
+            nEvents = int(a)
+        if o in ("-t", "--nThreads",):
+            nThreads = int(a)
+
+ROOT.gROOT.cd()
+views = ['_x','_u','_v']
+for s in range(1,5):
+ for p in range(2):
+  for l in range(2):
+   for view in views:
+    if (s==1 and view=='_v') or (s==2 and view=='_u') or (s>2 and view != '_x'): continue
+    ROOT.TH1D(str(1000*s+100*p+10*l)+view,'hit map',50,-0.5,49.5)
+   for v in range(2):
+    if s>2 and v>0: continue
+    for straw in range(1,(12 if s<3 else 48)+1):
+     detID = s*10000000+v*1000000+p*100000+l*10000+2000+straw
+     ROOT.TH1D('TDC'+str(detID),'TDC '+str(detID),1500,-500.,2500.)
+for nRT in range(576/RTsegmentation):
+ ROOT.TH1D('TDC'+str(nRT),'TDC',1500,-500.,2500.)
+ ROOT.TH1D('TDC'+str(nRT)+'_noToT','TDC',1500,-500.,2500.)
+print 'booked histograms        : ',ROOT.gDirectory.GetList().GetSize()
+
+for d in ['charmdet','shipdata','online']: ROOT.gInterpreter.AddIncludePath(os.environ['FAIRSHIP']+'/'+d)
+ROOT.gInterpreter.Declare('''
+#include "MufluxHistoRegistry.h"
+#include "MufluxSpectrometerHit.h"
+#include "TDirectory.h"
+#include "TH1D.h"
+#include "TTree.h"
+#include "TClonesArray.h"
+#include <chrono>
+
+namespace MufluxHistoBenchmark {
+Long64_t nHits = 0;
+
+// Seconds for the three lookups and fills of each hit of nEvents, by name or with the registry
+double Time(TTree *tree, Long64_t nEvents, Int_t RTsegmentation, bool registry)
+{
+   TClonesArray *hits = nullptr;
+   tree->SetBranchAddress("Digi_MufluxSpectrometerHits", &hits);
+   MufluxHistoRegistry histos;
+   histos.Resolve(RTsegmentation);
+   nHits = 0;
+   double seconds = 0;
+   for (Long64_t n = 0; n < nEvents; n++) {
+      tree->GetEntry(n);
+      auto start = std::chrono::steady_clock::now();
+      for (Int_t k = 0; k < hits->GetEntriesFast(); k++) {
+         MufluxSpectrometerHit *hit = (MufluxSpectrometerHit *)hits->At(k);
+         auto info = hit->StationInfo();
+         Int_t nRT = info[7] / RTsegmentation;
+         Bool_t noToT = !hit->hasTimeOverThreshold();
+         TH1D *h1, *h2, *h3;
+         if (registry) {
+            h1 = histos.HitMap(info[0], info[2], info[3], info[4]);
+            h2 = histos.TDC(nRT, noToT);
+            h3 = histos.TDCChannel(hit->GetDetectorID());
+         } else {
+            TString view = "_x";
+            if (info[4] == 1) {view = "_u";}
+            if (info[4] == 2) {view = "_v";}
+            TString histo; histo.Form("%d", 1000 * info[0] + 100 * info[2] + 10 * info[3]); histo += view;
+            h1 = (TH1D *)(gDirectory->GetList()->FindObject(histo));
+            TString TDChisto = "TDC"; TDChisto += nRT; if (noToT) {TDChisto += "_noToT";}
+            h2 = (TH1D *)(gDirectory->GetList()->FindObject(TDChisto));
+            TString channel = "TDC"; channel += hit->GetDetectorID();
+            h3 = (TH1D *)(gDirectory->GetList()->FindObject(channel));
+         }
+         if (h1) {h1->Fill(info[5]);}
+         if (h2) {h2->Fill(hit->GetDigi());}
+         if (h3) {h3->Fill(hit->GetDigi());}
+         nHits++;
+      }
+      seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }
+   tree->ResetBranchAddresses();
+   return seconds;
+}
+}
+''')
+
+f = ROOT.TFile.Open(inputFile)
+sTree = f.Get('cbmsim')
+ROOT.gROOT.cd()
+N = sTree.GetEntries()
+if nEvents<0 or nEvents>N: nEvents = N
+tName = ROOT.MufluxHistoBenchmark.Time(sTree,nEvents,RTsegmentation,False)
+tReg  = ROOT.MufluxHistoBenchmark.Time(sTree,nEvents,RTsegmentation,True)
+nHits = ROOT.MufluxHistoBenchmark.nHits
+print 'events, hits             : ',nEvents,nHits
+print 'FindObject  [ns/hit]     : %8.1F'%(tName/max(1,nHits)*1.E9)
+print 'registry    [ns/hit]     : %8.1F'%(tReg/max(1,nHits)*1.E9)
+if tReg>0:
+  print 'speedup                  : %8.2F'%(tName/tReg)
+
+xSHiP = ROOT.TTreeReader(sTree)
+muflux_Reco = ROOT.MufluxReco(xSHiP)
+muflux_Reco.setCuts('RTsegmentation',RTsegmentation)
+start = ROOT.TStopwatch()
+muflux_Reco.fillHitMaps(nEvents)
+print 'fillHitMaps [s]          : %8.2F'%(start.RealTime())
+start = ROOT.TStopwatch()
+muflux_Reco.runAnalyses('fillHitMaps',nThreads,nEvents)
+print 'runAnalyses [s]          : %8.2F  threads %i'%(start.RealTime(),nThreads)
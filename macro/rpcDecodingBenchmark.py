@@ -0,0 +1,132 @@
+#!/usr/bin/env python
+# decoding of the RPC frames (partition 0x0B00) of a raw spill file, RPC::Decoder (64 bit pattern,
+# byte and detector ID tables) compared to the bit by bit RPC::DecodeRecordReference.
+# both are run over all records, results are checked to be identical.
+import ROOT,os,sys,getopt
+
+inputFile = 'spill.raw'
+nRepeat   = 10
+
+try:
+        opts, args = getopt.getopt(sys.argv[1:], "f:n:",["inputFile=","nRepeat="])
+except getopt.GetoptError:
+        print ' enter --inputFile= --nRepeat= (default 10 passes over the records)'
+        sys.exit()
+for o, a in opts:
+        if o in ("-f", "--inputFile",):
+            inputFile = a
+        if o in ("-n", "--nRepeat",):
+            nRepeat = int(a)
+
+ROOT.gInterpreter.AddIncludePath(os.environ['FAIRSHIP']+'/online')
+ROOT.gInterpreter.Declare('''
+#include "ShipOnlineDataFormat.h"
+#include "RPCDecoding.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <vector>
+
+namespace RPCDecodingBenchmark {
+std::vector<unsigned char> records;
+size_t nHits = 0;
+
+void AddFrame(const char *data, uint16_t size)
+{
+   auto df = reinterpret_cast<const DataFrame *>(data);
+   if (df->header.partitionId == 0x0B00 && df->header.frameTime != SoS && df->header.frameTime != EoS) {
+      auto hits = reinterpret_cast<const unsigned char *>(df->hits);
+      auto nrecords = (size - sizeof(DataFrameHeader)) / sizeof(RPC::RawHit);
+      records.insert(records.end(), hits, hits + nrecords * sizeof(RPC::RawHit));
+   }
+}
+
+// Records of the RPCs, also from sub-frames of event builder frames
+size_t ReadFrames(const char *filename)
+{
+   std::ifstream in(filename, std::ios::binary);
+   std::vector<char> buffer(UINT16_MAX);
+   DataFrameHeader header;
+   while (in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+      if (header.size < sizeof(header)) {
+         break;
+      }
+      std::copy_n(reinterpret_cast<char *>(&header), sizeof(header), buffer.data());
+      in.read(buffer.data() + sizeof(header), header.size - sizeof(header));
+      if (header.partitionId != 0x8000) {
+         AddFrame(buffer.data(), header.size);
+         continue;
+      }
+      for (size_t offset = sizeof(header); offset < header.size;) {
+         auto sub = reinterpret_cast<const DataFrameHeader *>(buffer.data() + offset);
+         if (sub->size < sizeof(header)) {
+            break;
+         }
+         AddFrame(buffer.data() + offset, sub->size);
+         offset += sub->size;
+      }
+   }
+   return records.size() / sizeof(RPC::RawHit);
+}
+
+// Returns the number of records with different results
+int Check()
+{
+   RPC::Decoder decoder;
+   std::vector<int> ids, reference_ids;
+   int n = 0;
+   for (size_t i = 0; i < records.size(); i += sizeof(RPC::RawHit)) {
+      ids.clear();
+      reference_ids.clear();
+      int skipped = decoder.DecodeRecord(&records[i], [&ids](int id) { ids.push_back(id); });
+      int reference_skipped =
+         RPC::DecodeRecordReference(&records[i], [&reference_ids](int id) { reference_ids.push_back(id); });
+      n += skipped != reference_skipped || ids != reference_ids;
+   }
+   return n;
+}
+
+// Seconds for nRepeat passes, the detector IDs are summed so nothing is optimised away
+double TimeReference(int nRepeat)
+{
+   long sum = 0;
+   auto start = std::chrono::steady_clock::now();
+   for (int k = 0; k < nRepeat; k++) {
+      for (size_t i = 0; i < records.size(); i += sizeof(RPC::RawHit)) {
+         RPC::DecodeRecordReference(&records[i], [&sum](int id) { sum += id; });
+      }
+   }
+   nHits += sum;
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double TimeDecoder(int nRepeat)
+{
+   RPC::Decoder decoder;
+   long sum = 0;
+   auto start = std::chrono::steady_clock::now();
+   for (int k = 0; k < nRepeat; k++) {
+      for (size_t i = 0; i < records.size(); i += sizeof(RPC::RawHit)) {
+         decoder.DecodeRecord(&records[i], [&sum](int id) { sum += id; });
+      }
+   }
+   nHits += sum;
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+}
+''')
+bench = ROOT.RPCDecodingBenchmark
+
+nRecords = bench.ReadFrames(inputFile)
+if nRecords == 0:
+  print 'no RPC records found in ',inputFile
+  sys.exit()
+nDiff = bench.Check()
+tRef = bench.TimeReference(nRepeat)
+tNew = bench.TimeDecoder(nRepeat)
+print 'RPC records              : ',nRecords
+print 'records with differences : ',nDiff
+print 'bit by bit  [ns/record]  : %8.2F'%(tRef/(nRecords*nRepeat)*1.E9)
+print 'RPC::Decoder [ns/record] : %8.2F'%(tNew/(nRecords*nRepeat)*1.E9)
+if tNew>0:
+  print 'speedup                  : %8.2F'%(tRef/tNew)
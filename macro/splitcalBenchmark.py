@@ -0,0 +1,54 @@
+#!/usr/bin/env python
+# timing of the splitcal cluster eta/phi/energy computation: splitcalCluster::ComputeEtaPhiE called per cluster
+# versus splitcalCluster::ComputeEtaPhiEForEvent called once per event
+# input is a reconstructed file with Reco_SplitcalClusters, best with high energy photon pairs (many large clusters)
+import ROOT,sys,getopt,time
+
+inputFile = 'ship.conical.Pythia8-TGeant4_rec.root'
+nEvents = 999999
+nRepeat = 10
+
+try:
+        opts, args = getopt.getopt(sys.argv[1:], "f:n:r:",["inputFile=","nEvents=","repeat="])
+except getopt.GetoptError:
+        print ' enter --inputFile=  --nEvents= --repeat= (number of times each event is processed, default 10)'
+        sys.exit()
+for o, a in opts:
+        if o in ("-f", "--inputFile",):
+            inputFile = a
+        if o in ("-n", "--nEvents",):
+            nEvents = int(a)
+        if o in ("-r", "--repeat",):
+            nRepeat = int(a)
+
+f = ROOT.TFile.Open(inputFile)
+sTree = f.cbmsim
+if not sTree.GetBranch("Reco_SplitcalClusters"):
+  print "no Reco_SplitcalClusters in ",inputFile
+  sys.exit()
+
+nEvents = min(nEvents,sTree.GetEntries())
+timePerCluster = 0.
+timePerEvent = 0.
+nClusters = 0
+nDiff = 0
+for n in range(nEvents):
+  sTree.GetEntry(n)
+  clusters = sTree.Reco_SplitcalClusters
+  nClusters += clusters.GetEntries()
+  start = time.time()
+  for i in range(nRepeat):
+    for aCluster in clusters: aCluster.ComputeEtaPhiE()
+  timePerCluster += time.time()-start
+  reference = [(c.GetEta(),c.GetPhi(),c.GetEnergy()) for c in clusters]
+  start = time.time()
+  for i in range(nRepeat):
+    ROOT.splitcalCluster.ComputeEtaPhiEForEvent(clusters)
+  timePerEvent += time.time()-start
+  for k,c in enumerate(clusters):
+    if (c.GetEta(),c.GetPhi(),c.GetEnergy()) != reference[k]: nDiff+=1
+
+print 'processed ',nEvents,' events with ',nClusters,' clusters, ',nRepeat,' times each'
+print 'ComputeEtaPhiE per cluster      : %8.3F s'%(timePerCluster)
+print 'ComputeEtaPhiEForEvent per event: %8.3F s'%(timePerEvent)
+print 'clusters with different eta/phi/energy: ',nDiff
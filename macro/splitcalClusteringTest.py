@@ -0,0 +1,82 @@
+#!/usr/bin/env python
+# comparison of the splitcal clustering of shipDigiReco.digitizeSplitcal (python) with splitcalClusterFinder (C++)
+# both are run on the splitcal hits of the same events, the cluster content has to be identical:
+# hits of every cluster in order, cluster indices and energy weights of the hits, cluster eta/phi/energy
+# input is a simulated file with splitcalPoint, exits with 1 if a difference is found
+import ROOT,sys,getopt
+import __builtin__ as builtin
+from rootpyPickler import Unpickler
+
+inputFile = 'ship.conical.Pythia8-TGeant4.root'
+geoFile = None
+nEvents = 999999
+
+try:
+        opts, args = getopt.getopt(sys.argv[1:], "f:g:n:",["inputFile=","geoFile=","nEvents="])
+except getopt.GetoptError:
+        print ' enter --inputFile=  --geoFile= --nEvents='
+        sys.exit()
+for o, a in opts:
+        if o in ("-f", "--inputFile",):
+            inputFile = a
+        if o in ("-g", "--geoFile",):
+            geoFile = a
+        if o in ("-n", "--nEvents",):
+            nEvents = int(a)
+if not geoFile:
+ geoFile = inputFile.replace('ship.','geofile_full.').replace('_rec','')
+
+# globals needed to import shipDigiReco
+fgeo = ROOT.TFile.Open(geoFile)
+builtin.ShipGeo = Unpickler(fgeo).load('ShipGeo')
+builtin.realPR = ''
+builtin.nativeSplitcalClustering = False
+import shipDigiReco
+
+class SplitcalClustering(shipDigiReco.ShipDigiReco):
+ " only the splitcal digitization and clustering of ShipDigiReco, on the events of a tree"
+ def __init__(self,sTree):
+  self.sTree = sTree
+  self.sTree.t0 = 0.
+  self.digiSplitcal = ROOT.TClonesArray("splitcalHit")
+  self.recoSplitcal = ROOT.TClonesArray("splitcalCluster")
+  self.splitcalClusterFinder = ROOT.splitcalClusterFinder(0.002) # same noise threshold as in digitizeSplitcal
+ def clusters(self,native):
+  builtin.nativeSplitcalClustering = native
+  self.digiSplitcal.Delete()
+  self.recoSplitcal.Delete()
+  self.digitizeSplitcal()
+  result = []
+  for aCluster in self.recoSplitcal:
+   hits = []
+   for hit in aCluster.GetVectorOfHits():
+     hits.append( (hit.GetDetectorID(),tuple(hit.GetClusterIndices()),tuple(hit.GetEnergyWeights())) )
+   result.append( (aCluster.GetIndex(),aCluster.GetEta(),aCluster.GetPhi(),aCluster.GetEnergy(),hits) )
+  return result
+
+f = ROOT.TFile.Open(inputFile)
+sTree = f.cbmsim
+if not sTree.GetBranch("splitcalPoint"):
+  print "no splitcalPoint in ",inputFile
+  sys.exit(1)
+clustering = SplitcalClustering(sTree)
+
+nEvents = min(nEvents,sTree.GetEntries())
+nClusters = 0
+nDiff = 0
+for n in range(nEvents):
+  sTree.GetEntry(n)
+  reference = clustering.clusters(False)
+  native = clustering.clusters(True)
+  nClusters += len(reference)
+  if native != reference:
+    nDiff += 1
+    print 'event ',n,': ',len(reference),' python clusters, ',len(native),' native clusters'
+    for k in range(min(len(reference),len(native))):
+      if native[k] != reference[k]:
+        print '   first different cluster ',k
+        break
+
+print 'compared ',nEvents,' events with ',nClusters,' clusters'
+print 'events with different clusters: ',nDiff
+if nDiff > 0: sys.exit(1)
@@ -0,0 +1,40 @@
+#!/usr/bin/env python
+# build (or rebuild with --force) the frame index sidecar <raw file>.idx of a raw file and list its spills,
+# e.g. to distribute spills over jobs with ShipTdcSource.SelectSpill / convertRawToColumns.py --spill=
+import ROOT,os,sys,getopt
+
+inputFile = 'spill.raw'
+force     = False
+
+try:
+        opts, args = getopt.getopt(sys.argv[1:], "f:",["inputFile=","force"])
+except getopt.GetoptError:
+        print ' enter --inputFile= --force (rebuild sidecar)'
+        sys.exit()
+for o, a in opts:
+        if o in ("-f", "--inputFile",):
+            inputFile = a
+        if o in ("--force",):
+            force = True
+
+index = ROOT.ShipTdcIndex()
+if force:
+  ok = index.Build(inputFile) and index.Write(inputFile)
+else:
+  ok = index.Load(inputFile)
+if not ok:
+  print 'failed to index ',inputFile
+  sys.exit(1)
+
+SoS = 0xFF005C03
+EoS = 0xFF005C04
+print 'sidecar ',index.SidecarName(inputFile),' with ',index.GetNEntries(),' frames'
+print '%12s %8s %12s %12s %10s %4s %4s'%('cycle','frames','offset','bytes','triggers','SoS','EoS')
+for cycle in index.GetSpills():
+  first,last = index.FindSpill(cycle)
+  begin = index.GetEntry(first)
+  end   = index.GetEntry(last-1)
+  triggers = [index.GetEntry(i).timeExtent for i in range(first,last) if index.GetEntry(i).frameTime not in (SoS,EoS)]
+  trange = '%i-%i'%(min(triggers),max(triggers)) if triggers else '-'
+  print '%12i %8i %12i %12i %10s %4s %4s'%(cycle,last-first,begin.offset,end.offset+end.size-begin.offset,trange,
+        'y' if begin.frameTime==SoS else 'n', 'y' if end.frameTime==EoS else 'n')
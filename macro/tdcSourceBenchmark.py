@@ -0,0 +1,56 @@
+#!/usr/bin/env python
+# throughput of ShipTdcSource on a raw spill file, frames read through TFile::ReadBuffer (default)
+# or from the memory mapped file (--mmap), sequential or pipelined with N worker threads (--threads=N).
+# Unpackers as for the muon flux setup.
+# run once per mode, FairRunOnline can only be initialised once per process
+import ROOT,sys,getopt,time
+
+inputFile = 'spill.raw'
+outFile   = 'tdcSourceBenchmark.root'
+useMmap   = False
+charm     = False
+nEvents   = -1
+nThreads  = 0
+
+try:
+        opts, args = getopt.getopt(sys.argv[1:], "f:o:n:",["inputFile=","outputFile=","nEvents=","mmap","charm","threads="])
+except getopt.GetoptError:
+        print ' enter --inputFile= --outputFile= --nEvents= (default all frames) --mmap --charm --threads= (default sequential)'
+        sys.exit()
+for o, a in opts:
+        if o in ("-f", "--inputFile",):
+            inputFile = a
+        if o in ("-o", "--outputFile",):
+            outFile = a
+        if o in ("-n", "--nEvents",):
+            nEvents = int(a)
+        if o in ("--mmap",):
+            useMmap = True
+        if o in ("--charm",):
+            charm = True
+        if o in ("--threads",):
+            nThreads = int(a)
+
+source = ROOT.ShipTdcSource(inputFile)
+source.SetUseMmap(useMmap)
+source.SetNThreads(nThreads)
+source.AddUnpacker(ROOT.DriftTubeUnpack(charm))
+source.AddUnpacker(ROOT.RPCUnpack())
+source.AddUnpacker(ROOT.ScalerUnpack())
+run = ROOT.FairRunOnline(source)
+run.SetOutputFile(outFile)
+run.Init()
+ROOT.FairLogger.GetLogger().SetLogScreenLevel("WARNING")
+
+start = time.time()
+run.Run(nEvents,0)
+elapsed = time.time()-start
+
+nFrames = source.GetNFrames()
+nMB = source.GetNBytes()/1.E6
+print 'mode                    : ',('mmap' if useMmap else 'TFile::ReadBuffer'),('sequential' if nThreads<1 else '%i threads'%(nThreads))
+print 'frames read             : ',nFrames,' (%8.1F MB)'%(nMB)
+print 'time                    : %8.3F s'%(elapsed)
+if elapsed>0:
+  print 'frames/s                : %10.1F'%(nFrames/elapsed)
+  print 'MB/s                    : %10.1F'%(nMB/elapsed)
@@ -0,0 +1,244 @@
+#ifndef ONLINE_DRIFTTUBECALIBRATION_H
+#define ONLINE_DRIFTTUBECALIBRATION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#include "ShipOnlineDataFormat.h"
+#include "DriftTubeMatching.h"
+
+namespace DriftTubes {
+
+// Classification of a matched hit, decides the output collection
+enum HitClass : uint8_t {
+   kTube,          // First hit of a drift tube in the frame
+   kLateTube,      // Further hits of the same drift tube
+   kTrigger,       // Trigger copy in each TDC
+   kMasterTrigger, // Master trigger
+   kBeamCounter,   // Beam counter or RC signal
+   kScintillator,  // Trigger scintillator A/B
+   kBlacklisted    // Not connected
+};
+
+// Calibration of the matched hits of one frame.
+// The matches are transposed into columns (channel, leading edge, time over threshold of the matcher), the trigger
+// times per TDC and the delay between the master trigger and TDC 4 are collected in one pass, then drift time and
+// flags of all hits are computed in branch-free loops over the columns, which the compiler vectorises (gathers from
+// the per TDC and per channel tables with AVX2, emulated otherwise).
+// Times are computed in double and stored as float, as in the per hit version, so the results are identical.
+// Per channel t0s [ns] are subtracted from the drift times of the tubes, they can be reloaded between spills.
+class Calibration {
+public:
+   static constexpr int kChannels = 0x1000;
+   static constexpr int kTDCs = 16;
+   static constexpr double kTdcUnit = 0.098;       // ns per TDC count
+   static constexpr int32_t kDefaultDelay = 13500; // Best guess based on data
+
+   explicit Calibration(bool charm = false) : fCharm(charm) {}
+
+   void SetCharm(bool charm) { fCharm = charm; }
+
+   // Text file with one "TDC channel t0[ns]" per line, '#' starts a comment. Channels not listed have t0 = 0.
+   // The current t0s are kept if the file cannot be read.
+   bool LoadT0s(const std::string &filename)
+   {
+      std::ifstream in(filename);
+      if (!in) {
+         return false;
+      }
+      std::vector<float> t0(kChannels, 0);
+      std::string line;
+      while (std::getline(in, line)) {
+         line = line.substr(0, line.find('#'));
+         std::istringstream fields(line);
+         int TDC, channel;
+         float value;
+         if (!(fields >> TDC >> channel >> value)) {
+            continue;
+         }
+         if (TDC < 0 || TDC >= kTDCs || channel < 0 || channel > 0xFF) {
+            return false;
+         }
+         t0[TDC << 8 | channel] = value;
+      }
+      fT0.swap(t0);
+      fT0File = filename;
+      FileInfo(filename, fT0Size, fT0Time);
+      return true;
+   }
+   // Reload the t0 file if it was modified since it was loaded, returns true if new t0s were loaded
+   bool ReloadT0s()
+   {
+      int64_t size, time;
+      if (fT0File.empty() || !FileInfo(fT0File, size, time) || (size == fT0Size && time == fT0Time)) {
+         return false;
+      }
+      return LoadT0s(fT0File);
+   }
+   const std::string &GetT0File() const { return fT0File; }
+   void SetT0(int TDC, int channel, float t0) { fT0[TDC << 8 | channel] = t0; }
+   float GetT0(int TDC, int channel) const { return fT0[TDC << 8 | channel]; }
+
+   // Calibrate the matches of a frame with the given frame flags, results are valid until the next call
+   void Calibrate(const std::vector<EdgeMatch> &matches, uint16_t flags)
+   {
+      const int n = matches.size();
+      Resize(n);
+      for (int i = 0; i < n; i++) {
+         fChannel[i] = matches[i].channel;
+         fLeading[i] = matches[i].time;
+         fTot[i] = matches[i].time_over_threshold;
+         fMatched[i] = matches[i].matched;
+      }
+
+      // Classification, earliest trigger per TDC and earliest master trigger
+      const int *table = fCharm ? kDetectorIdsCharm.id : kDetectorIds.id;
+      std::fill(fTriggerTime, fTriggerTime + kTDCs, UINT16_MAX);
+      std::fill(fHasTrigger, fHasTrigger + kTDCs, 0);
+      fNTriggers = 0;
+      fMasterTriggerTime = 0;
+      bool master = false;
+      for (int i = 0; i < n; i++) {
+         const int id = table[fChannel[i]];
+         const int TDC = fChannel[i] >> 8;
+         fDetectorId[i] = id;
+         switch (id) {
+         case 0:
+            fClass[i] = kTrigger;
+            fTriggerTime[TDC] = std::min(fTriggerTime[TDC], fLeading[i]);
+            fHasTrigger[TDC] = 1;
+            fNTriggers++;
+            break;
+         case 1:
+            fClass[i] = kMasterTrigger;
+            fMasterTriggerTime = master ? std::min(fMasterTriggerTime, fLeading[i]) : fLeading[i];
+            master = true;
+            break;
+         case -1: fClass[i] = kBeamCounter; break;
+         case -2: fClass[i] = kBlacklisted; break;
+         case 6:
+         case 7: fClass[i] = kScintillator; break;
+         default: fClass[i] = matches[i].first ? kTube : kLateTube; break;
+         }
+      }
+
+      // The trigger of TDC 4 counts as present with time 0 if it is missing, as in the per hit version
+      if (!fHasTrigger[4]) {
+         fTriggerTime[4] = 0;
+         fHasTrigger[4] = 1;
+      }
+      fFlags = flags;
+      fDelay = kDefaultDelay;
+      if (fTriggerTime[4] == 0 || fMasterTriggerTime == 0) {
+         fFlags |= NoDelay;
+      } else {
+         fDelay = int32_t(fTriggerTime[4]) - fMasterTriggerTime;
+      }
+      int32_t offset[kTDCs];
+      int32_t tdcFlags[kTDCs]; // 32 bit for the gathers
+      for (int TDC = 0; TDC < kTDCs; TDC++) {
+         offset[TDC] = fHasTrigger[TDC] ? fDelay - fTriggerTime[TDC] : 0;
+         tdcFlags[TDC] = fFlags | (fHasTrigger[TDC] ? 0 : NoTrigger);
+      }
+
+      // Drift time and flags of all hits
+      CalibrateColumns(n, fChannel.data(), fLeading.data(), fMatched.data(), fClass.data(), fT0.data(), offset,
+                       tdcFlags, flags, fTime.data(), fHitFlags.data());
+   }
+
+   // Columns of the last calibrated frame
+   int GetNHits() const { return fNHits; }
+   HitClass GetClass(int i) const { return HitClass(fClass[i]); }
+   int GetDetectorId(int i) const { return fDetectorId[i]; }
+   uint16_t GetChannel(int i) const { return fChannel[i]; }
+   float GetTime(int i) const { return fTime[i]; }
+   float GetTimeOverThreshold(int i) const { return fTot[i]; }
+   uint16_t GetFlags(int i) const { return fHitFlags[i]; }
+   const float *GetTimes() const { return fTime.data(); }
+   const float *GetTimesOverThreshold() const { return fTot.data(); }
+   const uint16_t *GetFlags() const { return fHitFlags.data(); }
+   // Frame quantities of the last calibrated frame
+   int GetNTriggers() const { return fNTriggers; }
+   int32_t GetDelay() const { return fDelay; }
+   uint16_t GetFrameFlags() const { return fFlags; }
+   uint16_t GetTriggerTime(int TDC) const { return fTriggerTime[TDC]; }
+   uint16_t GetMasterTriggerTime() const { return fMasterTriggerTime; }
+
+private:
+   // Table loads are unconditional and the offset and t0 are blended with 0/1 factors instead of selected,
+   // the compiler does not if-convert conditional loads and floating point operations. Both blends are exact.
+   // The flags are a separate loop, 16 bit results next to 32 bit gathers prevent the vectorisation.
+   // The columns are restrict arguments, restrict local pointers are not kept when inlining.
+   static void CalibrateColumns(int n, const uint16_t *__restrict channel, const uint16_t *__restrict leading,
+                                const uint8_t *__restrict matched, const uint8_t *__restrict cls,
+                                const float *__restrict t0, const int32_t *offset, const int32_t *tdcFlags,
+                                uint16_t frameFlags, float *__restrict time, uint16_t *__restrict hitFlags)
+   {
+      for (int i = 0; i < n; i++) {
+         const int32_t tube = cls[i] <= kLateTube;
+         time[i] = float(kTdcUnit * double(leading[i] + tube * offset[channel[i] >> 8]) -
+                         double(tube) * double(t0[channel[i]]));
+      }
+      for (int i = 0; i < n; i++) {
+         const int32_t flagsOfTDC = tdcFlags[channel[i] >> 8];
+         hitFlags[i] = (cls[i] <= kLateTube ? flagsOfTDC : frameFlags) | (matched[i] ? 0 : NoWidth);
+      }
+   }
+   static bool FileInfo(const std::string &filename, int64_t &size, int64_t &time)
+   {
+      struct stat st;
+      if (stat(filename.c_str(), &st) != 0) {
+         return false;
+      }
+      size = st.st_size;
+      time = st.st_mtime;
+      return true;
+   }
+   void Resize(int n)
+   {
+      fNHits = n;
+      if (fChannel.size() >= size_t(n)) {
+         return;
+      }
+      fChannel.resize(n);
+      fLeading.resize(n);
+      fMatched.resize(n);
+      fClass.resize(n);
+      fDetectorId.resize(n);
+      fTime.resize(n);
+      fTot.resize(n);
+      fHitFlags.resize(n);
+   }
+
+   bool fCharm;
+   std::vector<float> fT0 = std::vector<float>(kChannels, 0);
+   std::string fT0File;
+   int64_t fT0Size = 0;
+   int64_t fT0Time = 0;
+
+   int fNHits = 0;
+   std::vector<uint16_t> fChannel;
+   std::vector<uint16_t> fLeading;
+   std::vector<uint8_t> fMatched;
+   std::vector<uint8_t> fClass;
+   std::vector<int> fDetectorId;
+   std::vector<float> fTime;
+   std::vector<float> fTot;
+   std::vector<uint16_t> fHitFlags;
+
+   uint16_t fTriggerTime[kTDCs];
+   uint8_t fHasTrigger[kTDCs];
+   uint16_t fMasterTriggerTime = 0;
+   int fNTriggers = 0;
+   int32_t fDelay = kDefaultDelay;
+   uint16_t fFlags = 0;
+};
+
+} // namespace DriftTubes
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef ONLINE_DRIFTTUBEMATCHING_H
+#define ONLINE_DRIFTTUBEMATCHING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "ShipOnlineDataFormat.h"
+
+namespace DriftTubes {
+
+struct EdgeMatch {
+   uint16_t channel;          // Channel identifier without edge bit
+   uint16_t time;             // Leading edge time
+   float time_over_threshold; // Estimated if there is no matching trailing edge
+   bool first;                // First leading edge of the channel in this frame
+   bool matched;              // Trailing edge found
+   uint16_t trailing;         // Trailing edge time if matched
+};
+
+// Matching of leading (channelId < 0x1000) and trailing edges of the drift tube TDCs.
+// Hits are counting-sorted by channel into a scratch arena which is kept between frames,
+// then sorted by time within each channel and paired in place.
+// Matches are ordered by channel, then by leading edge time.
+class EdgeMatcher {
+public:
+   static constexpr int kChannels = 0x1000;
+
+   const std::vector<EdgeMatch> &Match(const RawDataHit *hits, int nhits)
+   {
+      fMatches.clear();
+      fChannels.clear();
+      fNLeading = 0;
+      fNMatched = 0;
+      for (int k = 0; k < nhits; k++) {
+         uint16_t channel = hits[k].channelId % kChannels;
+         if (fNLeadingOf[channel] + fNTrailingOf[channel] == 0) {
+            fChannels.push_back(channel);
+         }
+         (hits[k].channelId < kChannels ? fNLeadingOf : fNTrailingOf)[channel]++;
+      }
+      std::sort(fChannels.begin(), fChannels.end());
+
+      // Per channel: leading edge times followed by trailing edge times
+      if (fTimes.size() < size_t(nhits)) {
+         fTimes.resize(nhits);
+      }
+      uint32_t offset = 0;
+      for (auto channel : fChannels) {
+         fLeadingEnd[channel] = offset;
+         fTrailingEnd[channel] = offset + fNLeadingOf[channel];
+         offset += fNLeadingOf[channel] + fNTrailingOf[channel];
+      }
+      for (int k = 0; k < nhits; k++) {
+         uint16_t channel = hits[k].channelId % kChannels;
+         fTimes[(hits[k].channelId < kChannels ? fLeadingEnd : fTrailingEnd)[channel]++] = hits[k].hitTime;
+      }
+
+      for (auto channel : fChannels) {
+         const int nl = fNLeadingOf[channel];
+         const int nt = fNTrailingOf[channel];
+         uint16_t *leading = fTimes.data() + fLeadingEnd[channel] - nl;
+         uint16_t *trailing = fTimes.data() + fTrailingEnd[channel] - nt;
+         std::sort(leading, leading + nl);
+         std::sort(trailing, trailing + nt);
+         fNLeading += nl;
+         bool first = true;
+         for (int i = 0, j = 0; i < nl; i++) {
+            if (j < nt && leading[i] < trailing[j] && (i + 1 >= nl || trailing[j] < leading[i + 1])) {
+               // Successful match
+               fMatches.push_back({channel, leading[i], float(0.098 * (trailing[j] - leading[i])), first, true,
+                                   trailing[j]});
+               fNMatched++;
+               j++;
+            } else if (j < nt && leading[i] > trailing[j] && (j + 1) < nt) {
+               // No match for leading edge, try again with next trailing edge
+               i--;
+               j++;
+               continue;
+            } else {
+               // No match possible, time over threshold estimated from data
+               fMatches.push_back({channel, leading[i], 167.2f, first, false, 0});
+            }
+            first = false;
+         }
+         fNLeadingOf[channel] = 0;
+         fNTrailingOf[channel] = 0;
+      }
+      return fMatches;
+   }
+
+   int GetNLeading() const { return fNLeading; }
+   int GetNMatched() const { return fNMatched; }
+   int GetNUnmatched() const { return fNLeading - fNMatched; }
+
+private:
+   std::vector<uint32_t> fNLeadingOf = std::vector<uint32_t>(kChannels, 0);
+   std::vector<uint32_t> fNTrailingOf = std::vector<uint32_t>(kChannels, 0);
+   std::vector<uint32_t> fLeadingEnd = std::vector<uint32_t>(kChannels, 0);
+   std::vector<uint32_t> fTrailingEnd = std::vector<uint32_t>(kChannels, 0);
+   std::vector<uint16_t> fChannels;
+   std::vector<uint16_t> fTimes;
+   std::vector<EdgeMatch> fMatches;
+   int fNLeading = 0;
+   int fNMatched = 0;
+};
+
+} // namespace DriftTubes
+
+#endif
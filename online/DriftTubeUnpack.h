@@ -11,6 +11,9 @@
 
 #include "ShipUnpack.h"
 #include "TClonesArray.h"
+#include "TString.h"
+#include "DriftTubeMatching.h"
+#include "DriftTubeCalibration.h"
 
 class TClonesArray;
 
@@ -34,6 +37,11 @@ public:
 
    uint16_t GetPartition() override { return fPartitionId; }
 
+   /** Per channel t0s subtracted from the drift times, see DriftTubes::Calibration::LoadT0s for the format.
+    *  Loaded in Init(), reloaded at the start of each spill if the file was modified. */
+   void SetT0File(const char *filename) { fT0File = filename; }
+   const DriftTubes::Calibration &GetCalibration() const { return fCalibration; }
+
 protected:
    /** Register the output structures. */
    virtual void Register() override;
@@ -47,13 +55,17 @@ private:
    std::unique_ptr<TClonesArray> fRawTriggers{new TClonesArray("ScintillatorHit")};
    uint16_t fPartitionId = 0x0C00;
    bool fCharm = false;
+   DriftTubes::EdgeMatcher fMatcher; //! Scratch memory for the edge matching, reused between frames
+   TString fT0File;
+   DriftTubes::Calibration fCalibration{fCharm}; //! Columns of the calibrated hits, reused between frames
+   ShipUnpackColumns *fColumnsOfClass[DriftTubes::kBlacklisted + 1] = {}; //! Output columns by hit class
 
    DriftTubeUnpack(const DriftTubeUnpack &);
    DriftTubeUnpack &operator=(const DriftTubeUnpack &);
 
 public:
    // Class definition
-   ClassDefOverride(DriftTubeUnpack, 1)
+   ClassDefOverride(DriftTubeUnpack, 2)
 };
 
 #endif
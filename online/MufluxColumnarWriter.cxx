@@ -0,0 +1,86 @@
+// ROOT headers
+#include "TFile.h"
+#include "TTree.h"
+
+// Fair headers
+#include "FairRun.h"
+#include "FairEventHeader.h"
+#include "FairLogger.h"
+
+// SHiP headers
+#include "MufluxColumnarWriter.h"
+#include "ShipUnpack.h"
+
+MufluxColumnarWriter::MufluxColumnarWriter(TString filename, TString treename)
+   : FairTask("MufluxColumnarWriter"), fFilename(std::move(filename)), fTreename(std::move(treename))
+{
+   // Arrays filled by DriftTubeUnpack and RPCUnpack
+   fPrefixes["Digi_MufluxSpectrometerHits"] = "dt";
+   fPrefixes["Digi_LateMufluxSpectrometerHits"] = "dt_late";
+   fPrefixes["Digi_BeamCounters"] = "beamcounter";
+   fPrefixes["Digi_MasterTrigger"] = "mastertrigger";
+   fPrefixes["Digi_Triggers"] = "trigger";
+   fPrefixes["Digi_MuonTaggerHits"] = "rpc";
+}
+
+MufluxColumnarWriter::~MufluxColumnarWriter()
+{
+   delete fFile;
+}
+
+void MufluxColumnarWriter::AddUnpacker(ShipUnpack *unpacker)
+{
+   unpacker->SetColumnar(kTRUE);
+   fUnpackers.push_back(unpacker);
+}
+
+InitStatus MufluxColumnarWriter::Init()
+{
+   fFile = TFile::Open(fFilename, "RECREATE");
+   if (!fFile || fFile->IsZombie()) {
+      LOG(ERROR) << "MufluxColumnarWriter: Cannot open " << fFilename << FairLogger::endl;
+      return kERROR;
+   }
+   fTree = new TTree(fTreename, "Unpacked hits in columns");
+   fTree->SetAutoFlush(-fAutoFlush);
+   fTree->Branch("event_time", &fEventTime);
+   // The columns of the unpackers are made in their Init(), which FairRunOnline calls before the tasks
+   for (auto &&unpacker : fUnpackers) {
+      for (auto &&item : unpacker->GetColumns()) {
+         auto prefix = fPrefixes.find(item.first);
+         if (prefix == fPrefixes.end()) {
+            LOG(INFO) << "MufluxColumnarWriter: No columns for " << item.first << FairLogger::endl;
+            continue;
+         }
+         auto &&columns = item.second;
+         fTree->Branch(prefix->second + "_detectorId", &columns.detectorId);
+         fTree->Branch(prefix->second + "_time", &columns.time);
+         if (item.first != "Digi_MuonTaggerHits") {
+            fTree->Branch(prefix->second + "_tot", &columns.tot);
+            fTree->Branch(prefix->second + "_flags", &columns.flags);
+            fTree->Branch(prefix->second + "_channel", &columns.channel);
+         }
+      }
+   }
+   return kSUCCESS;
+}
+
+void MufluxColumnarWriter::Exec(Option_t *)
+{
+   auto header = FairRun::Instance()->GetEventHeader();
+   fEventTime = header ? header->GetEventTime() : 0;
+   fTree->Fill();
+}
+
+void MufluxColumnarWriter::Finish()
+{
+   if (!fFile) {
+      return;
+   }
+   LOG(INFO) << "MufluxColumnarWriter: " << fTree->GetEntries() << " entries written to " << fFilename
+             << FairLogger::endl;
+   fFile->Write();
+   fFile->Close();
+}
+
+ClassImp(MufluxColumnarWriter)
@@ -0,0 +1,53 @@
+#ifndef ONLINE_MUFLUXCOLUMNARWRITER_H
+#define ONLINE_MUFLUXCOLUMNARWRITER_H
+
+#include "FairTask.h"
+#include "TString.h"
+
+#include <map>
+#include <vector>
+
+class ShipUnpack;
+class TFile;
+class TTree;
+
+/**
+ * Writes the unpacked hits of the muon flux setup as flat columns, one std::vector per quantity and
+ * detector (e.g. dt_detectorId, dt_time, dt_tot, dt_flags, dt_channel, rpc_detectorId), one entry per frame.
+ * The branches point directly to the hit columns the unpackers fill while decoding (ShipUnpack::SetColumnar),
+ * no hit objects are made unless the unpackers are persistent. Run after the unpackers in FairRunOnline.
+ * The tree is flushed every fAutoFlush bytes, memory does not grow with the run.
+ */
+class MufluxColumnarWriter : public FairTask {
+public:
+   explicit MufluxColumnarWriter(TString filename = "muflux_columns.root", TString treename = "hits");
+   virtual ~MufluxColumnarWriter();
+
+   /** Write the columns of an unpacker, switches it to columnar mode. Must be called before Init(). */
+   void AddUnpacker(ShipUnpack *unpacker);
+
+   virtual InitStatus Init() override;
+   virtual void Exec(Option_t *option) override;
+   virtual void Finish() override;
+
+   /** Bytes of baskets in memory before the tree is flushed to the file. */
+   void SetAutoFlush(Long64_t bytes) { fAutoFlush = bytes; }
+
+private:
+   TString fFilename;
+   TString fTreename;
+   Long64_t fAutoFlush = 30000000;
+   std::vector<ShipUnpack *> fUnpackers; //!
+   std::map<TString, TString> fPrefixes; //! Column prefix by output array name
+   TFile *fFile = nullptr;               //!
+   TTree *fTree = nullptr;               //!
+   Double_t fEventTime = 0;              //!
+
+   MufluxColumnarWriter(const MufluxColumnarWriter &);
+   MufluxColumnarWriter &operator=(const MufluxColumnarWriter &);
+
+public:
+   ClassDefOverride(MufluxColumnarWriter, 2)
+};
+
+#endif
@@ -4,12 +4,17 @@
 #pragma link off all classes;
 #pragma link off all functions;
 
+#pragma link C++ class ShipUnpackStats+;
 #pragma link C++ class ShipUnpack+;
 #pragma link C++ class DriftTubeUnpack+;
 #pragma link C++ class RPCUnpack+;
 #pragma link C++ class ScalerUnpack+;
 #pragma link C++ class PixelUnpack+;
 #pragma link C++ class DummyUnpack+;
+#pragma link C++ class ShipTdcSourceStats+;
+#pragma link C++ struct ShipTdcIndexEntry+;
+#pragma link C++ class ShipTdcIndex+;
 #pragma link C++ class ShipTdcSource+;
+#pragma link C++ class MufluxColumnarWriter+;
 
 #endif
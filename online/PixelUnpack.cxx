@@ -2,11 +2,13 @@
 
 // ROOT headers
 #include "TClonesArray.h"
+#include "ROOT/RVec.hxx"
 
 // Fair headers
 #include "FairRootManager.h"
 #include "FairRunOnline.h"
 #include "FairLogger.h"
+#include "ShipUnpackLog.h"
 
 // SHiP headers
 #include "PixelUnpack.h"
@@ -52,13 +54,13 @@ void PixelUnpack::Register()
    if (!fMan) {
       return;
    }
-   fMan->Register("Digi_PixelHits", "Pixels", fRawData, kTRUE);
+   fMan->Register("Digi_PixelHits", "Pixels", fRawData, fPersistent);
 }
 
 // DoUnpack: Public method
 Bool_t PixelUnpack::DoUnpack(Int_t *data, Int_t size)
 {
-   LOG(INFO) << "PixelUnpack : Unpacking frame... size/bytes = " << size << FairLogger::endl;
+   UNPACK_LOG_FRAME << "PixelUnpack : Unpacking frame... size/bytes = " << size << FairLogger::endl;
 
    auto df = reinterpret_cast<DataFrame *>(data);
    switch (df->header.frameTime) {
@@ -68,8 +70,8 @@ Bool_t PixelUnpack::DoUnpack(Int_t *data, Int_t size)
    }
    assert(df->header.size == size);
    auto nhits = df->getHitCount();
-   std::vector<RawDataHit> hits(df->hits, df->hits + nhits);
-   for (auto &&hit : hits) {
+   fStats.AddFrame(nhits);
+   for (auto &&hit : ROOT::VecOps::RVec<RawDataHit>(df->hits, nhits)) {
       auto hitData = reinterpret_cast<HitData *>(&(hit.hitTime));
       auto channelId = reinterpret_cast<ChannelId *>(&(hit.channelId));
       auto detectorID = (fPartitionId%0x0800) * 10000000 + 1000000 * hitData->moduleID + 1000 * channelId->row + channelId->column;
@@ -85,7 +87,7 @@ Bool_t PixelUnpack::DoUnpack(Int_t *data, Int_t size)
 // Reset: Public method
 void PixelUnpack::Reset()
 {
-   LOG(DEBUG) << "PixelUnpack : Clearing Data Structure" << FairLogger::endl;
+   UNPACK_LOG_FRAME << "PixelUnpack : Clearing Data Structure" << FairLogger::endl;
    fRawData->Clear();
    fNHits = 0;
 }
@@ -0,0 +1,159 @@
+#ifndef ONLINE_RPCDECODING_H
+#define ONLINE_RPCDECODING_H
+
+#include <cassert>
+#include <cstdint>
+
+namespace RPC {
+
+// Record of one RPC front end board, the hit pattern holds channels 56-63 in its first byte
+// and channels 0-7 in its last byte, bit j of a byte is channel 8 * n + j.
+struct RawHit {
+   uint16_t ncrate : 8;
+   uint16_t nboard : 8;
+   uint16_t hitTime;
+   uint8_t pattern[8];
+};
+static_assert(sizeof(RawHit) == 12, "Padding is off");
+
+enum Direction { horizontal = 0, vertical = 1 };
+
+inline int GetId(int ncrate, int nboard, int channel)
+{
+   assert(ncrate == 16 || ncrate == 18);
+   assert(nboard > 0 && nboard < 16);
+   int station;
+   int nboardofstation;
+   switch (ncrate) {
+   case 16:
+      station = (nboard < 6) ? 1 : 2;
+      nboardofstation = nboard - (station - 1) * 5;
+      break;
+   case 18:
+      station = (nboard < 6) ? 3 : (nboard < 11) ? 4 : 5;
+      nboardofstation = nboard - (station - 3) * 5;
+      break;
+   }
+   int direction = (nboardofstation < 4) ? vertical : horizontal;
+   int strip = direction == vertical
+                  ? channel - 3
+                  : (channel < 16) ? 10 - channel
+                                   : (channel < 32) ? 42 - channel : (channel < 48) ? 74 - channel : 106 - channel;
+   strip += (nboardofstation - (direction == vertical ? 1 : 4)) * 64;
+   return 10000 * station + 1000 * direction + strip;
+}
+
+// Channels without strip, hits on them are noise
+inline bool IsUnconnected(unsigned int crate, unsigned int board, int channel)
+{
+   return (crate == 16 && (board == 5 || board == 10) && channel >= 48 && channel <= 53) ||
+          (crate == 16 && (board == 3 || board == 8) && channel >= 60 && channel <= 63) ||
+          (crate == 16 && (board == 4 || board == 9) && channel >= 10 && channel <= 15) ||
+          (crate == 16 && (board == 1 || board == 6) && channel >= 0 && channel <= 3) ||
+          (crate == 18 && (board == 5 || board == 10 || board == 15) && channel >= 48 && channel <= 53) ||
+          (crate == 18 && (board == 3 || board == 8 || board == 13) && channel >= 60 && channel <= 63) ||
+          (crate == 18 && (board == 4 || board == 9 || board == 14) && channel >= 10 && channel <= 15) ||
+          (crate == 18 && (board == 1 || board == 6 || board == 11) && channel >= 0 && channel <= 3);
+}
+
+// Bit by bit decoding of pattern byte k (1-8) of a record, the loop of the original unpacker:
+// calls channel(c) for every connected channel c with a hit, returns the number of hits on unconnected
+// channels. After a hit on an unconnected channel the bit mask is not shifted, so the same bit is
+// tested again for the next channel. This is kept to reproduce the MuonTagger hits of the original
+// unpacker: a lone noise hit on channels 0-3 or 48-53 of such a board gives one hit on the next connected
+// channel of the byte (4 or 54), and the following unconnected channels of the byte count as skipped again.
+template <typename F>
+int DecodeByteReference(unsigned int crate, unsigned int board, int k, unsigned char byte, F &&channel)
+{
+   const int BYTES_PER_HITPATTERN = 8;
+   int skipped = 0;
+   auto bitMask = 0x1;
+   for (int j = 0; j < 8; j++) {
+      if (byte & bitMask) {
+         auto c = (BYTES_PER_HITPATTERN - k) * 8 + j;
+         if (IsUnconnected(crate, board, c)) {
+            skipped++;
+            continue;
+         }
+         channel(c);
+      }
+      bitMask <<= 1;
+   }
+   return skipped;
+}
+
+// Bit by bit decoding of one record: calls hit(detectorId) for every connected channel with a hit,
+// returns the number of hits on unconnected channels
+template <typename F>
+int DecodeRecordReference(const unsigned char *record, F &&hit)
+{
+   const int BYTES_PER_HITPATTERN = 8;
+   int skipped = 0;
+   auto crate = (unsigned int)record[0];
+   auto board = (unsigned int)record[1];
+   for (int k = 1; k <= BYTES_PER_HITPATTERN; k++) {
+      skipped += DecodeByteReference(crate, board, k, record[k + 3],
+                                     [&hit, crate, board](int channel) { hit(GetId(crate, board, channel)); });
+   }
+   return skipped;
+}
+
+// Decoding of the whole 64 bit pattern at once. The pattern bytes are looked up in tables built with
+// DecodeByteReference for every (crate, board, byte, value): the channels with a hit, as bits of the
+// byte, and the number of hits on unconnected channels. The bits of the 8 bytes are combined into one
+// little endian word, so bit b is channel b ^ 56 and set bits come in the same order as in
+// DecodeRecordReference. Detector IDs are looked up per (crate, board, bit).
+class Decoder {
+public:
+   Decoder()
+   {
+      for (int c = 0; c < 2; c++) {
+         unsigned int crate = c ? 18 : 16;
+         for (unsigned int board = 1; board < 16; board++) {
+            for (int bit = 0; bit < 64; bit++) {
+               fId[c][board][bit] = GetId(crate, board, bit ^ 56);
+            }
+            for (int i = 0; i < 8; i++) {
+               for (int value = 0; value < 256; value++) {
+                  uint8_t channels = 0;
+                  fSkipped[c][board][i][value] = DecodeByteReference(
+                     crate, board, i + 1, value, [&channels](int channel) { channels |= 1 << (channel % 8); });
+                  fChannels[c][board][i][value] = channels;
+               }
+            }
+         }
+      }
+   }
+
+   // Same results as DecodeRecordReference, which is used for unknown crates and boards
+   template <typename F>
+   int DecodeRecord(const unsigned char *record, F &&hit) const
+   {
+      unsigned int crate = record[0];
+      unsigned int board = record[1];
+      if ((crate != 16 && crate != 18) || board == 0 || board > 15) {
+         return DecodeRecordReference(record, hit);
+      }
+      int c = crate == 18;
+      uint64_t channels = 0;
+      int skipped = 0;
+      for (int i = 0; i < 8; i++) {
+         auto value = record[4 + i];
+         channels |= uint64_t(fChannels[c][board][i][value]) << (8 * i);
+         skipped += fSkipped[c][board][i][value];
+      }
+      for (uint64_t bits = channels; bits; bits &= bits - 1) {
+         hit(fId[c][board][__builtin_ctzll(bits)]);
+      }
+      return skipped;
+   }
+
+private:
+   uint8_t fChannels[2][16][8][256] = {};
+   uint8_t fSkipped[2][16][8][256] = {};
+   int fId[2][16][64] = {};
+};
+
+} // namespace RPC
+
+#endif
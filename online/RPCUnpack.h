@@ -10,6 +10,7 @@
 #define ONLINE_RPCUNPACK_H
 
 #include "ShipUnpack.h"
+#include "RPCDecoding.h"
 
 class TClonesArray;
 
@@ -43,6 +44,8 @@ private:
    Int_t fNHits;              /**< Number of raw items in current event. */
    Int_t fNHitsTotal;         /**< Total number of raw items. */
    uint16_t fPartitionId;
+   RPC::Decoder fDecoder; //! Pattern byte and detector ID tables per crate and board
+   ShipUnpackColumns *fColumnsOut = nullptr; //! Output columns, nullptr unless columnar
 
    RPCUnpack(const RPCUnpack &);
    RPCUnpack &operator=(const RPCUnpack &);
@@ -31,161 +31,238 @@ struct DataFrame {
 };
 
 namespace DriftTubes {
+// Pieces of ChannelId::ComputeDetectorId(Charm), single expressions so that the tables are C++11 constant expressions
+namespace DetectorIdParts {
+// Muon flux setup, by TDC and channel
+constexpr bool Trigger(int TDC, int channel)
+{
+   return (TDC == 0 || TDC == 2) ? channel == 126 : (TDC == 1 || TDC == 3) ? channel == 0 : TDC == 4 && channel == 96;
+}
+constexpr bool ScintillatorA(int TDC, int channel)
+{
+   return (TDC == 0 && channel == 127) || (TDC == 1 && channel == 1);
+}
+constexpr bool ScintillatorB(int TDC, int channel)
+{
+   return (TDC == 2 && channel == 127) || (TDC == 3 && channel == 1);
+}
+constexpr bool MasterTrigger(int TDC, int channel)
+{
+   return TDC == 4 && channel == 99;
+}
+// beam counter or RC signal
+constexpr bool BeamCounter(int TDC, int channel)
+{
+   return TDC == 4 && (channel == 97 || channel == 98 || channel > 111);
+}
+constexpr bool Blacklisted(int TDC, int channel)
+{
+   return (TDC == 0 || TDC == 2) ? channel >= 120
+                                 : (TDC == 1 || TDC == 3) ? channel < 8 || channel >= 128 : TDC == 4 && channel >= 96;
+}
+constexpr int Station(int TDC, int channel)
+{
+   return TDC == 0 ? ((channel < 96) ? 1 : 2)
+                   : TDC == 1 ? ((channel < 80) ? 2 : 4)
+                              : TDC == 2 ? 4 : TDC == 3 ? ((channel < 32) ? 4 : 3) : TDC == 4 ? 3 : 0;
+}
+constexpr int ChannelOffset(int TDC, int channel)
+{
+   return TDC == 1 ? ((channel < 80) ? 112 : 1) +
+                        ((channel >= 32 && channel < 48) ? +16 : (channel >= 48 && channel < 64) ? -16 : 0)
+                   : TDC == 2 ? -119 : TDC == 3 ? ((channel < 32) ? 1 : 33) : TDC == 4 ? (channel < 48) * 33 : 0;
+}
+// module before the remapping of the channel, TDC 1 takes it from the remapped channel
+constexpr int Module(int TDC, int channel)
+{
+   return TDC == 0 ? (channel / 48) % 2
+                   : TDC == 2 ? (channel / 48) % 3 + 1
+                              : TDC == 3 ? ((channel + 16) / 48 + 3) % 4 : TDC == 4 ? (channel / 48) % 2 + 2 : 0;
+}
+constexpr bool ReverseX(int TDC, int channel)
+{
+   return !(Station(TDC, channel) == 2 || (TDC == 4 && channel >= 48));
+}
+constexpr int Wrapped(int c)
+{
+   return c + (c < 0) * 0x80;
+}
+constexpr int Remapped(int TDC, int channel, int c)
+{
+   return (TDC == 0 && channel < 96) ? c + (c ? 63 : 191)
+                                     : (TDC == 3 && channel < 96) ? c + ((channel < 32) ? 24 : 32) : c;
+}
+// channel after offset, wrapping, reversal and remapping
+constexpr int TubeChannel(int TDC, int channel)
+{
+   return Remapped(TDC, channel,
+                   ReverseX(TDC, channel) ? (0x80 - Wrapped(channel + ChannelOffset(TDC, channel)) % 0x80) % 0x80
+                                          : Wrapped(channel + ChannelOffset(TDC, channel)));
+}
+// view, plane, layer and straw from the remapped channel c
+constexpr int View(int station, int module)
+{
+   return (station == 1 || station == 2) * module % 2;
+}
+constexpr int Plane(int TDC, int channel, int station, int c)
+{
+   return ((TDC == 2) ? ((c % 48) / 24 + 1) % 2
+                      : (station == 3 && TDC == 4) ? 1 - (channel % 48) / 24 : (c % 48) / 24) -
+          (station == 4 && TDC == 3);
+}
+constexpr int Layer(int TDC, int channel, int c)
+{
+   return (TDC == 4) ? 1 - (channel % 24) / 12 : (c % 24) / 12;
+}
+constexpr int Straw(int station, int module, int c)
+{
+   return c % 12 + ((station == 3 || station == 4) ? 1 + (3 - module) * 12 : 1);
+}
+constexpr int TubeDetectorId(int TDC, int channel, int station, int module, int c)
+{
+   return station * 10000000 + View(station, module) * 1000000 + Plane(TDC, channel, station, c) * 100000 +
+          Layer(TDC, channel, c) * 10000 + 2000 + Straw(station, module, c);
+}
+constexpr int TubeDetectorId(int TDC, int channel, int c)
+{
+   return TubeDetectorId(TDC, channel, Station(TDC, channel), TDC == 1 ? (c / 48) % 2 : Module(TDC, channel), c);
+}
+
+// Charm setup, by TDC and channel
+constexpr bool TriggerCharm(int TDC, int channel)
+{
+   return TDC == 0 ? channel == 126 || channel == 120
+                   : TDC == 1 || TDC == 3 ? channel == 0 : TDC == 2 && channel == 126;
+}
+constexpr bool MasterTriggerCharm(int TDC, int channel)
+{
+   return TDC == 0 && channel == 123;
+}
+// beam counter or RC signal
+constexpr bool BeamCounterCharm(int TDC, int channel)
+{
+   return (TDC == 0 && (channel == 121 || channel == 122)) || (TDC == 1 && channel >= 2 && channel <= 5);
+}
+constexpr int StationCharm(int TDC, int channel)
+{
+   return TDC == 0 ? 3
+                   : TDC == 1 ? ((channel < 80) ? 3 : 4)
+                              : TDC == 2 ? 4 : TDC == 3 ? ((channel < 32 || channel >= 80) ? 4 : 3) : 0;
+}
+constexpr int ModuleCharm(int TDC, int channel)
+{
+   return TDC == 0 ? ((channel < 96) ? 2 + (channel / 48) % 2 : 0)
+                   : TDC == 1 ? ((channel >= 32 && channel < 80) ? 1 : 0)
+                              : TDC == 2 ? (channel / 48) + 1 : TDC == 3 ? ((channel < 32) ? 3 : 4) : 0;
+}
+// channel of the module before the reversal of a front end board or the cable swap
+constexpr int ModuleChannelCharm(int TDC, int channel)
+{
+   return (TDC == 0 || TDC == 2) ? channel % 48 : (TDC == 1 || TDC == 3) ? (channel + 16) % 48 : 0;
+}
+constexpr int SwappedModuleChannelCharm(int TDC, int module, int mc)
+{
+   return (TDC == 0 && module == 3) ? 12 * (mc / 12) + (11 - mc % 12)
+                                    : (TDC == 1 && module == 1) ? mc + ((mc < 16) ? 16 : (mc < 32) ? -16 : 0) : mc;
+}
+constexpr int ModuleDetectorIdCharm(int station, int module, int mc)
+{
+   return station * 10000000 + (1 - (mc / 24)) * 100000 + (1 - (mc % 24) / 12) * 10000 + 2000 +
+          (module >= 4 ? module : 3 - module) * 12 + (11 - (mc % 12)) + 1;
+}
+constexpr int TubeDetectorIdCharm(int TDC, int channel, int module)
+{
+   return ModuleDetectorIdCharm(StationCharm(TDC, channel), module,
+                                SwappedModuleChannelCharm(TDC, module, ModuleChannelCharm(TDC, channel)));
+}
+} // namespace DetectorIdParts
+
 struct ChannelId {
    uint16_t channel : 8;
    uint16_t TDC : 4;
    uint16_t edge : 1;
    uint16_t padding : 3;
-   int GetDetectorId() const
+   // Table lookups, the tables are filled at compile time with ComputeDetectorId(Charm)
+   int GetDetectorId() const;
+   int GetDetectorIdCharm() const;
+   // Detector ID of a drift tube, or 0: trigger, 1: master trigger, -1: beam counter or RC signal,
+   // 6/7: scintillator A/B, -2: blacklisted channel
+   static constexpr int ComputeDetectorId(int TDC, int channel)
    {
-      bool trigger = false;
-      bool beamcounter = false;
-      bool RC_signal = false;
-      bool scintillatorA = false;
-      bool scintillatorB = false;
-      bool master_trigger = false;
-      bool blacklisted = false;
-      int module = 0;
-      int station = 0;
-      int channel_offset = 0;
-      switch (TDC) {
-      case 0:
-         trigger = channel == 126;
-         scintillatorA = channel == 127;
-         station = (channel < 96) ? 1 : 2;
-         module = (channel / 48) % 2;
-         blacklisted = channel >= 120;
-         break;
-      case 1:
-         trigger = channel == 0;
-         scintillatorA = channel == 1;
-         station = (channel < 80) ? 2 : 4;
-         channel_offset = (channel < 80) ? 112 : 1;
-         channel_offset += (channel >= 32 && channel < 48) ? +16 : (channel >= 48 && channel < 64) ? -16 : 0;
-         blacklisted = channel < 8;
-         blacklisted |= channel >= 128;
-         break;
-      case 2:
-         trigger = channel == 126;
-         scintillatorB = channel == 127;
-         station = 4;
-         channel_offset = -119;
-         module = (channel / 48) % 3 + 1;
-         blacklisted = channel >= 120;
-         break;
-      case 3:
-         trigger = channel == 0;
-         scintillatorB = channel == 1;
-         station = (channel < 32) ? 4 : 3;
-         channel_offset = (channel < 32) ? 1 : 33;
-         module = ((channel + 16) / 48 + 3) % 4;
-         blacklisted = channel < 8;
-         blacklisted |= channel >= 128;
-         break;
-      case 4:
-         trigger = channel == 96;
-         RC_signal = channel == 97 || channel == 98;
-         master_trigger = channel == 99;
-         beamcounter = channel > 111;
-         module = (channel / 48) % 2 + 2;
-         channel_offset = (channel < 48) * 33;
-         station = 3;
-         blacklisted = channel >= 96;
-         break;
-      }
-      if (trigger) {
-         return 0;
-      } else if (master_trigger) {
-         return 1;
-      } else if (beamcounter || RC_signal) {
-         return -1;
-      } else if (scintillatorA) {
-         return 6;
-      } else if (scintillatorB) {
-         return 7;
-      } else if(blacklisted) {
-         return -2;
-      }
-      bool reverse_x = !(station == 2 || (TDC == 4 && channel >= 48));
-      int _channel = channel + channel_offset;
-      _channel += (_channel < 0) * 0x80;
-      _channel = reverse_x ? (0x80 - _channel % 0x80) % 0x80 : _channel;
-      if (TDC == 0 && channel < 96) {
-         _channel += _channel ? 63 : 191;
-      } else if (TDC == 3 && channel < 96) {
-         _channel += (channel < 32) ? 24 : 32;
-      }
-      if (TDC == 1) {
-         module = (_channel / 48) % 2;
-      }
-
-      int view = (station == 1 || station == 2) * module % 2;
-      int plane = (TDC == 2) ? ((_channel % 48) / 24 + 1) % 2
-                             : (station == 3 && TDC == 4) ? 1 - (channel % 48) / 24 : (_channel % 48) / 24;
-      if (station == 4 && TDC == 3) {
-         plane -= 1;
-      }
-      int layer = (TDC == 4) ? 1 - (channel % 24) / 12 : (_channel % 24) / 12;
-      int straw = _channel % 12 + ((station == 3 || station == 4) ? 1 + (3 - module) * 12 : 1);
-      return station * 10000000 + view * 1000000 + plane * 100000 + layer * 10000 + 2000 + straw;
-   };
-  int GetDetectorIdCharm() const
+      using namespace DetectorIdParts;
+      return Trigger(TDC, channel)
+                ? 0
+                : MasterTrigger(TDC, channel)
+                     ? 1
+                     : BeamCounter(TDC, channel)
+                          ? -1
+                          : ScintillatorA(TDC, channel)
+                               ? 6
+                               : ScintillatorB(TDC, channel)
+                                    ? 7
+                                    : Blacklisted(TDC, channel)
+                                         ? -2
+                                         : TubeDetectorId(TDC, channel, TubeChannel(TDC, channel));
+   }
+   static constexpr int ComputeDetectorIdCharm(int TDC, int channel)
    {
-     bool trigger = false;
-     bool beamcounter = false;
-     bool RC_signal = false;
-     bool master_trigger = false;
-     int module = 0;
-     int station = 0;
-     int module_channel = 0;
-     switch (TDC) {
-     case 0:
-       trigger = channel == 126 || channel == 120;
-       RC_signal = channel == 121 || channel == 122;
-       master_trigger = channel == 123;
-       station = 3;
-       module = (channel < 96) ? 2 + (channel / 48) % 2 : 0;
-       module_channel = channel % 48;
-       //reverse front end board
-       if(module == 3) module_channel = 12*(module_channel/12)+(11-module_channel%12);
-       break;
-     case 1:
-       trigger = channel == 0;
-       beamcounter = channel >=2 && channel <= 5;
-       station = (channel < 80) ? 3 : 4;
-       module = (channel >= 32 && channel < 80) ? 1 : 0;
-       module_channel = (channel + 16) % 48;
-       //cable swap
-       if(module==1) module_channel += ( module_channel < 16 ) ? 16 : ( module_channel < 32 ) ? -16 : 0;
-       break;
-     case 2:
-       trigger = channel == 126;
-       station = 4;
-       module = (channel / 48)  + 1 ;
-       module_channel = channel % 48;
-       break;
-     case 3:
-       trigger = channel == 0;
-       station = (channel < 32 || channel >= 80) ? 4 : 3;
-       module = (channel < 32 ) ? 3 : 4;
-       module_channel = (channel + 16) % 48;
-       break;
-     }
-     if (trigger) {
-       return 0;
-     } else if (master_trigger) {
-       return 1;
-     } else if (beamcounter || RC_signal) {
-       return -1;
-     }
-     
-     int plane = 1 - (module_channel / 24);
-     int layer = 1 - (module_channel % 24) / 12;
-     int straw = (module >= 4 ? module : 3 - module) * 12 + (11 - (module_channel % 12)) + 1;
-     
-     return station * 10000000 + plane * 100000 + layer * 10000 + 2000 + straw;
-   };
+      using namespace DetectorIdParts;
+      return TriggerCharm(TDC, channel)
+                ? 0
+                : MasterTriggerCharm(TDC, channel)
+                     ? 1
+                     : BeamCounterCharm(TDC, channel) ? -1
+                                                      : TubeDetectorIdCharm(TDC, channel, ModuleCharm(TDC, channel));
+   }
+};
+
+// Detector IDs for all (TDC, channel), indexed by TDC << 8 | channel
+struct DetectorIdTable {
+   int id[0x1000];
+};
+namespace DetectorIdParts {
+// 0, 1, ..., N-1 as a parameter pack, halving N keeps the template depth small
+template <int... I>
+struct Indices {
 };
+template <typename A, typename B>
+struct Concat;
+template <int... I, int... J>
+struct Concat<Indices<I...>, Indices<J...>> {
+   typedef Indices<I..., (sizeof...(I) + J)...> type;
+};
+template <int N>
+struct MakeIndices {
+   typedef typename Concat<typename MakeIndices<N / 2>::type, typename MakeIndices<N - N / 2>::type>::type type;
+};
+template <>
+struct MakeIndices<0> {
+   typedef Indices<> type;
+};
+template <>
+struct MakeIndices<1> {
+   typedef Indices<0> type;
+};
+template <int... I>
+constexpr DetectorIdTable MakeTable(bool charm, Indices<I...>)
+{
+   return DetectorIdTable{{(charm ? ChannelId::ComputeDetectorIdCharm(I >> 8, I & 0xFF)
+                                  : ChannelId::ComputeDetectorId(I >> 8, I & 0xFF))...}};
+}
+} // namespace DetectorIdParts
+constexpr DetectorIdTable kDetectorIds =
+   DetectorIdParts::MakeTable(false, DetectorIdParts::MakeIndices<0x1000>::type());
+constexpr DetectorIdTable kDetectorIdsCharm =
+   DetectorIdParts::MakeTable(true, DetectorIdParts::MakeIndices<0x1000>::type());
+
+inline int ChannelId::GetDetectorId() const
+{
+   return kDetectorIds.id[TDC << 8 | channel];
+}
+inline int ChannelId::GetDetectorIdCharm() const
+{
+   return kDetectorIdsCharm.id[TDC << 8 | channel];
+}
 enum Flag : uint16_t {
    All_OK = 1,
    TDC0_PROBLEM = 1 << 1,
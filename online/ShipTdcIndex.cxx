@@ -0,0 +1,177 @@
+#include "ShipTdcIndex.h"
+#include "ShipOnlineDataFormat.h"
+#include "FairLogger.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char kIndexMagic[8] = {'S', 'H', 'I', 'P', 'T', 'D', 'C', 'I'};
+const uint32_t kIndexVersion = 1;
+// magic, version, raw file size and time, number of entries
+const uint64_t kIndexHeaderSize = sizeof(kIndexMagic) + sizeof(uint32_t) + 2 * sizeof(uint64_t) + sizeof(uint64_t);
+
+Bool_t RawFileInfo(const char *rawfile, uint64_t &size, int64_t &time)
+{
+   struct stat st;
+   if (stat(rawfile, &st) != 0) {
+      return kFALSE;
+   }
+   size = st.st_size;
+   time = st.st_mtime;
+   return kTRUE;
+}
+} // namespace
+
+Bool_t ShipTdcIndex::Load(const char *rawfile)
+{
+   if (Read(rawfile)) {
+      return kTRUE;
+   }
+   if (!Build(rawfile)) {
+      return kFALSE;
+   }
+   if (!Write(rawfile)) {
+      LOG(WARNING) << "ShipTdcIndex: Cannot write " << SidecarName(rawfile) << ", index is not kept."
+                   << FairLogger::endl;
+   }
+   return kTRUE;
+}
+
+Bool_t ShipTdcIndex::Build(const char *rawfile)
+{
+   fEntries.clear();
+   if (!RawFileInfo(rawfile, fRawSize, fRawTime)) {
+      LOG(ERROR) << "ShipTdcIndex: Cannot open " << rawfile << FairLogger::endl;
+      return kFALSE;
+   }
+   std::ifstream in(rawfile, std::ios::binary);
+   DataFrameHeader header;
+   uint64_t offset = 0;
+   while (offset + sizeof(header) <= fRawSize && in.seekg(offset) &&
+          in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+      if (header.size < sizeof(header)) {
+         LOG(ERROR) << "ShipTdcIndex: Corrupt frame header at offset " << offset << ", stop indexing."
+                    << FairLogger::endl;
+         break;
+      }
+      if (offset + header.size > fRawSize) {
+         LOG(WARNING) << "ShipTdcIndex: Truncated frame at offset " << offset << " ignored." << FairLogger::endl;
+         break;
+      }
+      fEntries.push_back(
+         {offset, header.cycleIdentifier, header.frameTime, header.timeExtent, header.partitionId, header.size, 0});
+      offset += header.size;
+   }
+   LOG(INFO) << "ShipTdcIndex: Indexed " << fEntries.size() << " frames in " << rawfile << FairLogger::endl;
+   return kTRUE;
+}
+
+Bool_t ShipTdcIndex::Read(const char *rawfile)
+{
+   uint64_t size, sidecarSize;
+   int64_t time, sidecarTime;
+   if (!RawFileInfo(rawfile, size, time) || !RawFileInfo(SidecarName(rawfile).Data(), sidecarSize, sidecarTime)) {
+      return kFALSE;
+   }
+   std::ifstream in(SidecarName(rawfile).Data(), std::ios::binary);
+   char magic[8];
+   uint32_t version;
+   uint64_t n;
+   in.read(magic, sizeof(magic));
+   in.read(reinterpret_cast<char *>(&version), sizeof(version));
+   in.read(reinterpret_cast<char *>(&fRawSize), sizeof(fRawSize));
+   in.read(reinterpret_cast<char *>(&fRawTime), sizeof(fRawTime));
+   in.read(reinterpret_cast<char *>(&n), sizeof(n));
+   if (!in || memcmp(magic, kIndexMagic, sizeof(magic)) != 0 || version != kIndexVersion || fRawSize != size ||
+       fRawTime != time) {
+      return kFALSE;
+   }
+   // n is only trusted if the entries fill the rest of the sidecar, e.g. not after a partial write
+   if (sidecarSize < kIndexHeaderSize || n != (sidecarSize - kIndexHeaderSize) / sizeof(ShipTdcIndexEntry) ||
+       (sidecarSize - kIndexHeaderSize) % sizeof(ShipTdcIndexEntry) != 0) {
+      LOG(WARNING) << "ShipTdcIndex: Corrupt " << SidecarName(rawfile) << ", rebuilding the index." << FairLogger::endl;
+      return kFALSE;
+   }
+   fEntries.resize(n);
+   in.read(reinterpret_cast<char *>(fEntries.data()), n * sizeof(ShipTdcIndexEntry));
+   if (!in) {
+      fEntries.clear();
+      return kFALSE;
+   }
+   for (auto &&entry : fEntries) {
+      if (entry.offset + entry.size > size) {
+         LOG(WARNING) << "ShipTdcIndex: Frame beyond the end of " << rawfile << " in " << SidecarName(rawfile)
+                      << ", rebuilding the index." << FairLogger::endl;
+         fEntries.clear();
+         return kFALSE;
+      }
+   }
+   return kTRUE;
+}
+
+Bool_t ShipTdcIndex::Write(const char *rawfile) const
+{
+   // Written to a temporary file and renamed, readers see the old sidecar or the complete new one
+   TString sidecar = SidecarName(rawfile);
+   TString tmp = sidecar + TString::Format(".%d.tmp", getpid());
+   std::ofstream out(tmp.Data(), std::ios::binary);
+   uint64_t n = fEntries.size();
+   out.write(kIndexMagic, sizeof(kIndexMagic));
+   out.write(reinterpret_cast<const char *>(&kIndexVersion), sizeof(kIndexVersion));
+   out.write(reinterpret_cast<const char *>(&fRawSize), sizeof(fRawSize));
+   out.write(reinterpret_cast<const char *>(&fRawTime), sizeof(fRawTime));
+   out.write(reinterpret_cast<const char *>(&n), sizeof(n));
+   out.write(reinterpret_cast<const char *>(fEntries.data()), n * sizeof(ShipTdcIndexEntry));
+   out.close();
+   if (!out || std::rename(tmp.Data(), sidecar.Data()) != 0) {
+      std::remove(tmp.Data());
+      return kFALSE;
+   }
+   return kTRUE;
+}
+
+std::vector<uint32_t> ShipTdcIndex::GetSpills() const
+{
+   std::vector<uint32_t> spills;
+   for (auto &&entry : fEntries) {
+      if (spills.empty() || spills.back() != entry.cycleIdentifier) {
+         spills.push_back(entry.cycleIdentifier);
+      }
+   }
+   return spills;
+}
+
+std::pair<size_t, size_t> ShipTdcIndex::FindSpill(uint32_t cycleIdentifier) const
+{
+   size_t first = 0;
+   while (first < fEntries.size() && fEntries[first].cycleIdentifier != cycleIdentifier) {
+      first++;
+   }
+   size_t last = first;
+   while (last < fEntries.size() && fEntries[last].cycleIdentifier == cycleIdentifier) {
+      last++;
+   }
+   return {first, last};
+}
+
+std::pair<size_t, size_t>
+ShipTdcIndex::FindTriggers(uint32_t cycleIdentifier, uint16_t firstTrigger, uint16_t lastTrigger) const
+{
+   auto spill = FindSpill(cycleIdentifier);
+   size_t first = spill.first;
+   while (first < spill.second && (fEntries[first].timeExtent < firstTrigger ||
+                                   fEntries[first].frameTime == SoS || fEntries[first].frameTime == EoS)) {
+      first++;
+   }
+   size_t last = first;
+   while (last < spill.second && fEntries[last].timeExtent <= lastTrigger && fEntries[last].frameTime != EoS) {
+      last++;
+   }
+   return {first, last};
+}
+
+ClassImp(ShipTdcIndex)
@@ -0,0 +1,55 @@
+#ifndef ONLINE_SHIPTDCINDEX_H
+#define ONLINE_SHIPTDCINDEX_H
+
+#include "TObject.h"
+#include "TString.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/** Header of a top level frame of a raw file and its position. */
+struct ShipTdcIndexEntry {
+   uint64_t offset;
+   uint32_t cycleIdentifier;
+   uint32_t frameTime;
+   uint16_t timeExtent; // sequential trigger number
+   uint16_t partitionId;
+   uint16_t size;
+   uint16_t padding;
+};
+
+/**
+ * Index of the frames of a raw file, kept in a binary sidecar <raw file>.idx next to it.
+ * The sidecar stores size and modification time of the raw file and is rebuilt if they changed.
+ */
+class ShipTdcIndex : public TObject {
+public:
+   /** Read the sidecar of the raw file if it is up to date, otherwise scan the raw file and write the sidecar. */
+   Bool_t Load(const char *rawfile);
+   /** Scan all frame headers of the raw file. */
+   Bool_t Build(const char *rawfile);
+   Bool_t Read(const char *rawfile);
+   Bool_t Write(const char *rawfile) const;
+   static TString SidecarName(const char *rawfile) { return TString(rawfile) + ".idx"; }
+
+   size_t GetNEntries() const { return fEntries.size(); }
+   const ShipTdcIndexEntry &GetEntry(size_t i) const { return fEntries[i]; }
+   const std::vector<ShipTdcIndexEntry> &GetEntries() const { return fEntries; }
+   /** Cycle identifiers in the order of the file. */
+   std::vector<uint32_t> GetSpills() const;
+   /** Entries [first, last) of a spill, empty range if not found. */
+   std::pair<size_t, size_t> FindSpill(uint32_t cycleIdentifier) const;
+   /** Entries [first, last) of a spill with sequential trigger numbers from firstTrigger to lastTrigger,
+    *  without SoS and EoS frames. Trigger numbers are assumed to increase within the spill. */
+   std::pair<size_t, size_t> FindTriggers(uint32_t cycleIdentifier, uint16_t firstTrigger, uint16_t lastTrigger) const;
+
+private:
+   std::vector<ShipTdcIndexEntry> fEntries; //!
+   uint64_t fRawSize = 0;
+   int64_t fRawTime = 0;
+
+   ClassDef(ShipTdcIndex, 1)
+};
+
+#endif
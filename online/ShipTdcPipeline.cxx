@@ -0,0 +1,148 @@
+#include "ShipTdcPipeline.h"
+
+#include <cstdint>
+
+ShipTdcPipeline::ShipTdcPipeline(int nworkers, size_t depth) : fBuffers(depth)
+{
+   for (auto &&buffer : fBuffers) {
+      buffer.resize(UINT16_MAX);
+      fFree.push_back(buffer.data());
+   }
+   for (int i = 0; i < nworkers; i++) {
+      fWorkers.emplace_back(&ShipTdcPipeline::WorkLoop, this);
+   }
+}
+
+ShipTdcPipeline::~ShipTdcPipeline()
+{
+   StopReader();
+   {
+      std::lock_guard<std::mutex> lock(fTaskMutex);
+      fStopWorkers = true;
+   }
+   fTaskCondition.notify_all();
+   for (auto &&worker : fWorkers) {
+      worker.join();
+   }
+}
+
+void ShipTdcPipeline::StartReader(Reader reader)
+{
+   StopReader();
+   fReader = std::move(reader);
+   fStopReader = false;
+   fReaderThread = std::thread(&ShipTdcPipeline::ReadLoop, this);
+}
+
+void ShipTdcPipeline::StopReader()
+{
+   if (!fReaderThread.joinable()) {
+      return;
+   }
+   {
+      std::lock_guard<std::mutex> lock(fReaderMutex);
+      fStopReader = true;
+   }
+   fReaderCondition.notify_all();
+   fReaderThread.join();
+   // Give all buffers back for a restart
+   for (auto &&item : fFilled) {
+      fFree.push_back(item.second);
+   }
+   fFilled.clear();
+   if (fCurrent) {
+      fFree.push_back(fCurrent);
+      fCurrent = nullptr;
+   }
+}
+
+void ShipTdcPipeline::ReadLoop()
+{
+   while (true) {
+      unsigned char *buffer;
+      {
+         std::unique_lock<std::mutex> lock(fReaderMutex);
+         fReaderCondition.wait(lock, [this] { return fStopReader || !fFree.empty(); });
+         if (fStopReader) {
+            return;
+         }
+         buffer = fFree.back();
+         fFree.pop_back();
+      }
+      // The reader is only called from this thread, no lock needed while reading
+      int status = fReader(buffer);
+      {
+         std::lock_guard<std::mutex> lock(fReaderMutex);
+         fFilled.emplace_back(status, buffer);
+      }
+      fReaderCondition.notify_all();
+      if (status == 1) {
+         return;
+      }
+   }
+}
+
+int ShipTdcPipeline::NextFrame(unsigned char *&frame)
+{
+   std::unique_lock<std::mutex> lock(fReaderMutex);
+   if (fCurrent) {
+      fFree.push_back(fCurrent);
+      fCurrent = nullptr;
+      fReaderCondition.notify_all();
+   }
+   fReaderCondition.wait(lock, [this] { return !fFilled.empty(); });
+   int status = fFilled.front().first;
+   if (status == 1) {
+      // Keep the end entry, every further call returns the same status
+      frame = nullptr;
+      return status;
+   }
+   if (status != 0) {
+      fFree.push_back(fFilled.front().second);
+      fFilled.pop_front();
+      fReaderCondition.notify_all();
+      frame = nullptr;
+      return status;
+   }
+   fCurrent = frame = fFilled.front().second;
+   fFilled.pop_front();
+   return 0;
+}
+
+void ShipTdcPipeline::Submit(std::function<void()> task)
+{
+   {
+      std::lock_guard<std::mutex> lock(fTaskMutex);
+      fTasks.push_back(std::move(task));
+      fPending++;
+   }
+   fTaskCondition.notify_one();
+}
+
+void ShipTdcPipeline::Wait()
+{
+   std::unique_lock<std::mutex> lock(fTaskMutex);
+   fDoneCondition.wait(lock, [this] { return fPending == 0; });
+}
+
+void ShipTdcPipeline::WorkLoop()
+{
+   while (true) {
+      std::function<void()> task;
+      {
+         std::unique_lock<std::mutex> lock(fTaskMutex);
+         fTaskCondition.wait(lock, [this] { return fStopWorkers || !fTasks.empty(); });
+         if (fTasks.empty()) {
+            return;
+         }
+         task = std::move(fTasks.front());
+         fTasks.pop_front();
+      }
+      task();
+      {
+         std::lock_guard<std::mutex> lock(fTaskMutex);
+         fPending--;
+      }
+      fDoneCondition.notify_all();
+   }
+}
@@ -0,0 +1,58 @@
+#ifndef ONLINE_SHIPTDCPIPELINE_H
+#define ONLINE_SHIPTDCPIPELINE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads of the pipelined mode of ShipTdcSource:
+// - a reader thread filling a bounded queue of raw frames ahead of the event loop,
+// - a worker pool unpacking the sub-frames of an event builder frame, one task per unpacker.
+// Events stay in order: the event loop takes one frame at a time and waits for all its tasks.
+class ShipTdcPipeline {
+public:
+   // Reads one frame into the buffer, returns 0 if ok, otherwise the status for ReadEvent (1: end of file, 2: bad frame)
+   using Reader = std::function<int(unsigned char *)>;
+
+   explicit ShipTdcPipeline(int nworkers, size_t depth = 64);
+   ~ShipTdcPipeline();
+
+   void StartReader(Reader reader);
+   void StopReader();
+   // Next frame of the reader thread, valid until the next call. Returns the status of the reader
+   int NextFrame(unsigned char *&frame);
+
+   void Submit(std::function<void()> task);
+   // Wait until all submitted tasks are done
+   void Wait();
+   int GetNWorkers() const { return fWorkers.size(); }
+
+private:
+   void ReadLoop();
+   void WorkLoop();
+
+   // Reader
+   Reader fReader;
+   std::thread fReaderThread;
+   std::vector<std::vector<unsigned char>> fBuffers;
+   std::deque<std::pair<int, unsigned char *>> fFilled;
+   std::vector<unsigned char *> fFree;
+   unsigned char *fCurrent = nullptr;
+   bool fStopReader = false;
+   std::mutex fReaderMutex;
+   std::condition_variable fReaderCondition;
+
+   // Worker pool
+   std::vector<std::thread> fWorkers;
+   std::deque<std::function<void()>> fTasks;
+   int fPending = 0;
+   bool fStopWorkers = false;
+   std::mutex fTaskMutex;
+   std::condition_variable fTaskCondition;
+   std::condition_variable fDoneCondition;
+};
+
+#endif
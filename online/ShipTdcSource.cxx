@@ -2,7 +2,19 @@
 #include "FairLogger.h"
 #include "FairEventHeader.h"
 #include "ShipUnpack.h"
+#include "ShipUnpackLog.h"
 #include "ShipOnlineDataFormat.h"
+#include "ShipTdcPipeline.h"
+#include "TROOT.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 ShipTdcSource::ShipTdcSource() : fFilename("tdcdata.bin") {}
 
@@ -14,13 +26,144 @@ ShipTdcSource::~ShipTdcSource() = default;
 
 Bool_t ShipTdcSource::Init()
 {
+   BuildUnpackerTable();
+   if (fNThreads > 0) {
+      ROOT::EnableThreadSafety();
+      fPipeline.reset(new ShipTdcPipeline(fNThreads));
+      LOG(INFO) << "ShipTdcSource: Pipelined mode with " << fNThreads << " threads." << FairLogger::endl;
+   }
+   // Frames [first, second) of the file to read
+   std::pair<size_t, size_t> frames(0, SIZE_MAX);
+   if (fUseIndex || fSelectedSpill >= 0) {
+      if (!fIndex.Load(fFilename)) {
+         return kFALSE;
+      }
+   }
+   if (fSelectedSpill >= 0) {
+      frames = fFirstTrigger < 0 ? fIndex.FindSpill(fSelectedSpill)
+                                 : fIndex.FindTriggers(fSelectedSpill, fFirstTrigger, fLastTrigger);
+      if (frames.first == frames.second) {
+         LOG(ERROR) << "ShipTdcSource: No frames for cycle " << fSelectedSpill << " in " << fFilename
+                    << FairLogger::endl;
+         return kFALSE;
+      }
+      LOG(INFO) << "ShipTdcSource: Reading frames " << frames.first << " to " << frames.second - 1 << " of cycle "
+                << fSelectedSpill << FairLogger::endl;
+   }
+   if (fUseMmap) {
+      if (!MapFile()) {
+         return kFALSE;
+      }
+      fNextFrame = frames.first;
+      fEndFrame = std::min(frames.second, fFrameIndex.size());
+      return kTRUE;
+   }
    fIn = TFile::Open(fFilename + "?filetype=raw", "read");
+   if (fIn && frames.first > 0) {
+      fIn->Seek(fIndex.GetEntry(frames.first).offset);
+   }
+   fFramesLeft = frames.second - frames.first;
+   if (fPipeline && fIn) {
+      fPipeline->StartReader([this](unsigned char *frame) { return ReadFrame(frame); });
+   }
+   return kTRUE;
+}
+
+Bool_t ShipTdcSource::MapFile()
+{
+   int fd = open(fFilename.Data(), O_RDONLY);
+   if (fd < 0) {
+      LOG(ERROR) << "ShipTdcSource: Cannot open " << fFilename << FairLogger::endl;
+      return kFALSE;
+   }
+   struct stat st;
+   if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      LOG(ERROR) << "ShipTdcSource: Cannot map empty or unreadable file " << fFilename << FairLogger::endl;
+      close(fd);
+      return kFALSE;
+   }
+   // Private writable mapping: pages are only copied if an unpacker writes into its frame
+   void *addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (addr == MAP_FAILED) {
+      LOG(ERROR) << "ShipTdcSource: Failed to map " << fFilename << FairLogger::endl;
+      return kFALSE;
+   }
+   madvise(addr, st.st_size, MADV_SEQUENTIAL);
+   fMapped = static_cast<unsigned char *>(addr);
+   fMappedSize = st.st_size;
+   BuildFrameIndex();
    return kTRUE;
 }
 
+void ShipTdcSource::BuildFrameIndex()
+{
+   fFrameIndex.clear();
+   fNextFrame = 0;
+   if (fIndex.GetNEntries() > 0) {
+      // Sidecar is up to date with the file
+      for (auto &&entry : fIndex.GetEntries()) {
+         fFrameIndex.push_back(entry.offset);
+      }
+      return;
+   }
+   size_t offset = 0;
+   while (offset + sizeof(DataFrame) <= fMappedSize) {
+      auto df = reinterpret_cast<DataFrame *>(fMapped + offset);
+      size_t size = df->header.size;
+      if (size < sizeof(DataFrame)) {
+         LOG(ERROR) << "ShipTdcSource: Corrupt frame header at offset " << offset << ", stop indexing."
+                    << FairLogger::endl;
+         break;
+      }
+      if (offset + size > fMappedSize) {
+         LOG(WARNING) << "ShipTdcSource: Truncated frame at offset " << offset << " ignored." << FairLogger::endl;
+         break;
+      }
+      fFrameIndex.push_back(offset);
+      offset += size;
+   }
+   LOG(INFO) << "ShipTdcSource: Indexed " << fFrameIndex.size() << " frames in " << fFilename << FairLogger::endl;
+}
+
+void ShipTdcSource::BuildUnpackerTable()
+{
+   fUnpackerTable.assign(UINT16_MAX + 1, nullptr);
+   for (TObject *item : *fUnpackers) {
+      auto unpacker = dynamic_cast<ShipUnpack *>(item);
+      if (!unpacker) {
+         continue;
+      }
+      auto partitionId = unpacker->GetPartition();
+      if (fUnpackerTable[partitionId]) {
+         LOG(WARNING) << "ShipTdcSource: Second unpacker for PartitionId " << std::hex << partitionId << std::dec
+                      << " ignored." << FairLogger::endl;
+         continue;
+      }
+      fUnpackerTable[partitionId] = unpacker;
+   }
+}
+
 void ShipTdcSource::Close()
 {
    LOG(DEBUG) << "Closing file " << fFilename << FairLogger::endl;
+   fStats.Print();
+   for (TObject *item : *fUnpackers) {
+      auto unpacker = dynamic_cast<ShipUnpack *>(item);
+      if (unpacker) {
+         unpacker->GetStats().Print(unpacker->ClassName());
+      }
+   }
+   if (fPipeline) {
+      fPipeline->StopReader();
+   }
+   if (fMapped) {
+      munmap(fMapped, fMappedSize);
+      fMapped = nullptr;
+      fMappedSize = 0;
+      fFrameIndex.clear();
+      return;
+   }
    fIn->Close();
 }
 
@@ -35,15 +178,23 @@ Int_t ShipTdcSource::UnpackEventFrame(Int_t *data, Int_t total_size)
    case EoS: LOG(INFO) << "ShipTdcSource: EoS frame." << FairLogger::endl; break;
    default: break;
    }
+   if (fPipeline) {
+      // Nothing is queued if a partition is unknown, the sub-frames point into a reused buffer
+      auto queued = fSubFrames.Queue(data, total_size, [this](uint16_t partitionId) {
+         UNPACK_LOG_FRAME << "ShipTdcSource: PartitionId " << std::hex << partitionId << std::dec << FairLogger::endl;
+         return GetUnpacker(partitionId);
+      });
+      if (!queued || !UnpackParallel()) {
+         return 3;
+      }
+      return (frameTime == EoS) ? 1 : 0;
+   }
    while (total_size > 0) {
       auto df = reinterpret_cast<DataFrame *>(data);
       Int_t size = df->header.size;
       uint16_t partitionId = df->header.partitionId;
-      LOG(DEBUG) << "ShipTdcSource: PartitionId " << std::hex << partitionId << std::dec << FairLogger::endl;
+      UNPACK_LOG_FRAME << "ShipTdcSource: PartitionId " << std::hex << partitionId << std::dec << FairLogger::endl;
       if (!Unpack(data, size, partitionId)) {
-         LOG(WARNING) << "ShipTdcSource: Failed to Unpack." << FairLogger::endl;
-         LOG(WARNING) << "ShipTdcSource: Maybe missing unpacker for PartitionId " << std::hex << partitionId << std::dec
-                      << FairLogger::endl;
          return 3;
       }
       data += size / sizeof(Int_t);
@@ -55,65 +206,128 @@ Int_t ShipTdcSource::UnpackEventFrame(Int_t *data, Int_t total_size)
 
 Int_t ShipTdcSource::ReadEvent(UInt_t)
 {
-   auto df = new (buffer) DataFrame();
-   if (!fIn->ReadBuffer(reinterpret_cast<char *>(df), sizeof(DataFrame))) {
-      size_t size = df->header.size;
-      auto frameTime = df->header.frameTime;
-      switch (frameTime) {
-      case SoS: LOG(INFO) << "ShipTdcSource: SoS frame." << FairLogger::endl; break;
-      case EoS: LOG(INFO) << "ShipTdcSource: EoS frame." << FairLogger::endl; break;
-      default: break;
+   if (fMapped) {
+      if (fNextFrame >= fEndFrame) {
+         return 1;
       }
-      fEventTime = double(frameTime) * 25;
-      uint16_t partitionId = df->header.partitionId;
-      if (partitionId == 0x8000) {
-         LOG(DEBUG) << "ShipTdcSource: Event builder meta frame." << FairLogger::endl;
-         assert(size - sizeof(DataFrame) > 0);
-         if (!fIn->ReadBuffer(reinterpret_cast<char *>(df->hits), size - sizeof(DataFrame))) {
-            if (fEventTime > 5000000000 && frameTime != EoS && frameTime != SoS) {
-               LOG(WARNING) << "Late event:" << FairLogger::endl;
-               for (int i = 0; i < size; i++) {
-                  if (i % 4 == 0) {
-                     std::cout << ' ';
-                  } else if (i % 16 == 0) {
-                     std::cout << '\n';
-                  }
-                  std::cout << std::hex << +buffer[i] << std::dec;
-               }
-               std::cout << std::endl;
+      return UnpackFrame(fMapped + fFrameIndex[fNextFrame++]);
+   }
+   if (fPipeline) {
+      unsigned char *frame;
+      auto status = fPipeline->NextFrame(frame);
+      return status ? status : UnpackFrame(frame);
+   }
+   auto status = ReadFrame(buffer);
+   return status ? status : UnpackFrame(buffer);
+}
+
+Int_t ShipTdcSource::ReadFrame(unsigned char *frame)
+{
+   if (fFramesLeft == 0) {
+      return 1;
+   }
+   fFramesLeft--;
+   auto df = new (frame) DataFrame();
+   if (fIn->ReadBuffer(reinterpret_cast<char *>(df), sizeof(DataFrame))) {
+      return 1;
+   }
+   size_t size = df->header.size;
+   if (size < sizeof(DataFrame) ||
+       (size > sizeof(DataFrame) && fIn->ReadBuffer(reinterpret_cast<char *>(df->hits), size - sizeof(DataFrame)))) {
+      LOG(WARNING) << "ShipTdcSource: Failed to read hits." << FairLogger::endl;
+      return 2;
+   }
+   return 0;
+}
+
+Int_t ShipTdcSource::UnpackFrame(unsigned char *frame)
+{
+   auto df = reinterpret_cast<DataFrame *>(frame);
+   size_t size = df->header.size;
+   fStats.AddFrame(size);
+   auto frameTime = df->header.frameTime;
+   switch (frameTime) {
+   case SoS: LOG(INFO) << "ShipTdcSource: SoS frame." << FairLogger::endl; break;
+   case EoS: LOG(INFO) << "ShipTdcSource: EoS frame." << FairLogger::endl; break;
+   default: break;
+   }
+   fEventTime = double(frameTime) * 25;
+   uint16_t partitionId = df->header.partitionId;
+   if (partitionId == 0x8000) {
+      UNPACK_LOG_FRAME << "ShipTdcSource: Event builder meta frame." << FairLogger::endl;
+      assert(size - sizeof(DataFrame) > 0);
+      if (fEventTime > 5000000000 && frameTime != EoS && frameTime != SoS) {
+         LOG(WARNING) << "Late event:" << FairLogger::endl;
+         for (int i = 0; i < size; i++) {
+            if (i % 4 == 0) {
+               std::cout << ' ';
+            } else if (i % 16 == 0) {
+               std::cout << '\n';
             }
-            return UnpackEventFrame(reinterpret_cast<Int_t *>(&buffer), size);
+            std::cout << std::hex << +frame[i] << std::dec;
          }
+         std::cout << std::endl;
       }
-      LOG(DEBUG) << "ShipTdcSource: PartitionId " << std::hex << partitionId << std::dec << FairLogger::endl;
-      if (!fIn->ReadBuffer(reinterpret_cast<char *>(df->hits), size - sizeof(DataFrame))) {
+      return UnpackEventFrame(reinterpret_cast<Int_t *>(frame), size);
+   }
+   UNPACK_LOG_FRAME << "ShipTdcSource: PartitionId " << std::hex << partitionId << std::dec << FairLogger::endl;
+   if (Unpack(reinterpret_cast<Int_t *>(frame), size, partitionId)) {
+      return 0;
+   }
+   return 3;
+}
 
-         if (Unpack(reinterpret_cast<Int_t *>(&buffer), size, partitionId)) {
-            return 0;
-         }
-         LOG(WARNING) << "ShipTdcSource: Failed to Unpack." << FairLogger::endl;
-         LOG(WARNING) << "ShipTdcSource: Maybe missing unpacker for PartitionId " << std::hex << partitionId << std::dec
-                      << FairLogger::endl;
-         return 3;
-      }
-      LOG(WARNING) << "ShipTdcSource: Failed to read hits." << FairLogger::endl;
-      return 2;
+ShipUnpack *ShipTdcSource::GetUnpacker(uint16_t partitionId)
+{
+   if (fUnpackerTable.empty()) {
+      BuildUnpackerTable();
+   }
+   auto unpacker = fUnpackerTable[partitionId];
+   if (!unpacker) {
+      // Counted instead of logged, summary at Close()
+      fStats.AddUnknown(partitionId);
    }
-   return 1;
+   return unpacker;
 }
 
 Bool_t ShipTdcSource::Unpack(Int_t *data, Int_t size, uint16_t partitionId)
 {
+   auto unpacker = GetUnpacker(partitionId);
+   if (!unpacker) {
+      return kFALSE;
+   }
+   if (unpacker->DoUnpack(data, size)) {
+      return kTRUE;
+   }
+   LOG(WARNING) << "ShipTdcSource: Failed to Unpack PartitionId " << std::hex << partitionId << std::dec
+                << FairLogger::endl;
+   return kFALSE;
+}
 
-   for (TObject *item : *fUnpackers) {
-      auto unpacker = dynamic_cast<ShipUnpack *>(item);
-      if (unpacker->GetPartition() == partitionId) {
-         return unpacker->DoUnpack(data, size);
+Bool_t ShipTdcSource::UnpackParallel()
+{
+   // Unpackers write to their own output arrays, the sub-frames of one unpacker stay in order on one thread
+   std::atomic<bool> ok(true);
+   for (auto &&item : fSubFrames) {
+      if (item.second.empty()) {
+         continue;
       }
+      auto unpacker = item.first;
+      auto &&subframes = item.second;
+      fPipeline->Submit([unpacker, &subframes, &ok] {
+         for (auto &&subframe : subframes) {
+            if (!unpacker->DoUnpack(subframe.first, subframe.second)) {
+               LOG(WARNING) << "ShipTdcSource: Failed to Unpack PartitionId " << std::hex << unpacker->GetPartition()
+                            << std::dec << FairLogger::endl;
+               ok = false;
+               return;
+            }
+         }
+      });
    }
-
-   LOG(WARNING) << "ShipTdcSource: Failed to find suitable unpacker." << FairLogger::endl;
-   return kFALSE;
+   fPipeline->Wait();
+   fSubFrames.Clear();
+   return ok;
 }
 
 void ShipTdcSource::FillEventHeader(FairEventHeader *feh)
@@ -124,4 +338,28 @@ void ShipTdcSource::FillEventHeader(FairEventHeader *feh)
    return;
 }
 
+ULong64_t ShipTdcSourceStats::GetNUnknownFrames(uint16_t partitionId) const
+{
+   auto it = fUnknownPartitions.find(partitionId);
+   return it == fUnknownPartitions.end() ? 0 : it->second;
+}
+
+void ShipTdcSourceStats::Print(Option_t *) const
+{
+   LOG(INFO) << "ShipTdcSource: " << fNFrames << " frames, " << fNBytes << " bytes read." << FairLogger::endl;
+   for (auto &&item : fUnknownPartitions) {
+      LOG(WARNING) << "ShipTdcSource: " << item.second << " frames for PartitionId " << std::hex << item.first
+                   << std::dec << " without unpacker." << FairLogger::endl;
+   }
+}
+
+void ShipTdcSourceStats::Clear(Option_t *)
+{
+   fNFrames = 0;
+   fNBytes = 0;
+   fNUnknownFrames = 0;
+   fUnknownPartitions.clear();
+}
+
+ClassImp(ShipTdcSourceStats)
 ClassImp(ShipTdcSource)
@@ -6,8 +6,47 @@
 #include "TFile.h"
 
 #include "FairUnpack.h"
+#include "ShipTdcIndex.h"
+#include "ShipTdcSubFrames.h"
+
+#include <vector>
+#include <map>
+#include <memory>
 
 class FairEventHeader;
+class ShipUnpack;
+class ShipTdcPipeline;
+
+/** Frame statistics of a ShipTdcSource, queryable at the end of the run. */
+class ShipTdcSourceStats : public TObject {
+public:
+   void AddFrame(size_t size)
+   {
+      fNFrames++;
+      fNBytes += size;
+   }
+   void AddUnknown(uint16_t partitionId)
+   {
+      fNUnknownFrames++;
+      fUnknownPartitions[partitionId]++;
+   }
+   ULong64_t GetNFrames() const { return fNFrames; }
+   ULong64_t GetNBytes() const { return fNBytes; }
+   /** Frames (also sub-frames of event builder frames) without unpacker for their partition. */
+   ULong64_t GetNUnknownFrames() const { return fNUnknownFrames; }
+   ULong64_t GetNUnknownFrames(uint16_t partitionId) const;
+   const std::map<uint16_t, ULong64_t> &GetUnknownPartitions() const { return fUnknownPartitions; }
+   virtual void Print(Option_t *option = "") const;
+   virtual void Clear(Option_t *option = "");
+
+private:
+   ULong64_t fNFrames = 0;
+   ULong64_t fNBytes = 0;
+   ULong64_t fNUnknownFrames = 0;
+   std::map<uint16_t, ULong64_t> fUnknownPartitions;
+
+   ClassDef(ShipTdcSourceStats, 1)
+};
 
 class ShipTdcSource : public FairOnlineSource {
 public:
@@ -21,16 +60,69 @@ public:
    virtual void Close();
    void FillEventHeader(FairEventHeader *feh);
 
+   /** Map the raw file into memory instead of reading it through TFile, must be set before Init().
+    *  Unpackers get pointers into the mapped region, only local files are supported. */
+   void SetUseMmap(Bool_t useMmap = kTRUE) { fUseMmap = useMmap; }
+   Bool_t GetUseMmap() const { return fUseMmap; }
+   /** Number of top level frames in the mapped file, known after Init(). */
+   size_t GetNFramesInFile() const { return fFrameIndex.size(); }
+   /** Number of frames and bytes read so far. */
+   ULong64_t GetNFrames() const { return fStats.GetNFrames(); }
+   ULong64_t GetNBytes() const { return fStats.GetNBytes(); }
+   const ShipTdcSourceStats &GetStats() const { return fStats; }
+   /** Pipelined mode with the given number of worker threads, must be set before Init(), 0 for sequential.
+    *  Frames are read ahead by a separate thread (not with mmap), the sub-frames of an event builder frame
+    *  are unpacked in parallel, one task per unpacker. */
+   void SetNThreads(Int_t nthreads) { fNThreads = nthreads; }
+   Int_t GetNThreads() const { return fNThreads; }
+   /** Use the frame index of the sidecar file <raw file>.idx, built and written on first use. */
+   void SetUseIndex(Bool_t useIndex = kTRUE) { fUseIndex = useIndex; }
+   /** Only read the frames of one spill, or of a range of sequential trigger numbers within it.
+    *  Seeks with the index, must be set before Init(). */
+   void SelectSpill(UInt_t cycleIdentifier) { fSelectedSpill = cycleIdentifier; }
+   void SelectTriggers(UInt_t cycleIdentifier, UShort_t firstTrigger, UShort_t lastTrigger)
+   {
+      fSelectedSpill = cycleIdentifier;
+      fFirstTrigger = firstTrigger;
+      fLastTrigger = lastTrigger;
+   }
+   const ShipTdcIndex &GetIndex() const { return fIndex; }
+
 protected:
    Bool_t Unpack(Int_t *data, Int_t size, uint16_t partitionId);
+   ShipUnpack *GetUnpacker(uint16_t partitionId);
+   Bool_t UnpackParallel();
+   Int_t ReadFrame(unsigned char *frame);
    Int_t UnpackEventFrame(Int_t *data, Int_t total_size);
+   Int_t UnpackFrame(unsigned char *frame);
+   Bool_t MapFile();
+   void BuildFrameIndex();
+   void BuildUnpackerTable();
    TFile *fIn;
    unsigned char buffer[UINT16_MAX];
    Double_t fEventTime = 0;
 
    TString fFilename;
 
-   ClassDef(ShipTdcSource, 1)
+   Bool_t fUseMmap = kFALSE;
+   unsigned char *fMapped = nullptr; //!
+   size_t fMappedSize = 0;           //!
+   std::vector<size_t> fFrameIndex;  //! Offsets of the top level frames in the mapped file
+   size_t fNextFrame = 0;            //!
+   size_t fEndFrame = 0;             //!
+   size_t fFramesLeft = 0;           //! Frames to read without mmap
+   std::vector<ShipUnpack *> fUnpackerTable; //! Unpacker for each partitionId, nullptr if none
+   ShipTdcSourceStats fStats;               //!
+   Int_t fNThreads = 0;
+   std::unique_ptr<ShipTdcPipeline> fPipeline; //!
+   ShipTdcSubFrames<ShipUnpack> fSubFrames;    //! Sub-frames per unpacker
+   Bool_t fUseIndex = kFALSE;
+   Long64_t fSelectedSpill = -1;
+   Int_t fFirstTrigger = -1;
+   Int_t fLastTrigger = -1;
+   ShipTdcIndex fIndex; //!
+
+   ClassDef(ShipTdcSource, 4)
 };
 
 #endif
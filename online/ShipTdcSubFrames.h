@@ -0,0 +1,67 @@
+#ifndef ONLINE_SHIPTDCSUBFRAMES_H
+#define ONLINE_SHIPTDCSUBFRAMES_H
+
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "ShipOnlineDataFormat.h"
+
+// Sub-frames of one event builder frame grouped by unpacker, for the pipelined mode of ShipTdcSource.
+// The sub-frames of an unpacker stay in frame order. A frame is queued completely or not at all: the
+// groups of the previous frame are dropped first, and nothing is left queued if a partition has no
+// unpacker, since the sub-frames point into a buffer which is reused for the next frame.
+template <typename Unpacker>
+class ShipTdcSubFrames {
+public:
+   using SubFrame = std::pair<int32_t *, int32_t>;
+   using Groups = std::map<Unpacker *, std::vector<SubFrame>>;
+
+   // Group the sub-frames following the header of an event builder frame, size in bytes.
+   // lookup(partitionId) gives the unpacker of a partition or nullptr. Returns false if a partition has none.
+   template <typename Lookup>
+   bool Queue(int32_t *data, int32_t size, Lookup &&lookup)
+   {
+      Clear();
+      while (size > 0) {
+         auto df = reinterpret_cast<DataFrame *>(data);
+         int32_t frameSize = df->header.size;
+         auto unpacker = lookup(df->header.partitionId);
+         if (!unpacker) {
+            Clear();
+            return false;
+         }
+         fGroups[unpacker].emplace_back(data, frameSize);
+         data += frameSize / sizeof(int32_t);
+         size -= frameSize;
+      }
+      assert(size == 0);
+      return true;
+   }
+
+   // Empty groups are kept, their vectors are reused by the next frame
+   void Clear()
+   {
+      for (auto &&item : fGroups) {
+         item.second.clear();
+      }
+   }
+
+   size_t GetNSubFrames() const
+   {
+      size_t n = 0;
+      for (auto &&item : fGroups) {
+         n += item.second.size();
+      }
+      return n;
+   }
+   typename Groups::iterator begin() { return fGroups.begin(); }
+   typename Groups::iterator end() { return fGroups.end(); }
+
+private:
+   Groups fGroups;
+};
+
+#endif
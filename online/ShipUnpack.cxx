@@ -33,7 +33,17 @@ Bool_t ShipUnpack::Init()
 }
 
 // Reset: Public method
-void ShipUnpack::Reset() {}
+void ShipUnpack::Reset()
+{
+   ClearColumns();
+}
+
+void ShipUnpack::ClearColumns()
+{
+   for (auto &&item : fColumns) {
+      item.second.Clear();
+   }
+}
 
 void ShipUnpack::Register()
 {
@@ -44,4 +54,25 @@ void ShipUnpack::Register()
    }
 }
 
+void ShipUnpackStats::Print(Option_t *option) const
+{
+   LOG(INFO) << option << ": " << fNFrames << " frames, " << fNHits << " hits." << FairLogger::endl;
+   if (fNUnmatched) {
+      LOG(INFO) << option << ": " << fNUnmatched << " leading edges without trailing edge." << FairLogger::endl;
+   }
+   if (fNSkipped) {
+      LOG(INFO) << option << ": " << fNSkipped << " hits on unconnected channels skipped (probably noise)."
+                << FairLogger::endl;
+   }
+}
+
+void ShipUnpackStats::Clear(Option_t *)
+{
+   fNFrames = 0;
+   fNHits = 0;
+   fNUnmatched = 0;
+   fNSkipped = 0;
+}
+
+ClassImp(ShipUnpackStats)
 ClassImp(ShipUnpack)
@@ -10,10 +10,72 @@
 #define ONLINE_SHIPUNPACK_H
 
 #include "FairUnpack.h"
+#include "TString.h"
+#include <map>
 #include <memory>
+#include <vector>
 
 class TClonesArray;
 
+/** Counters of an unpacker, summed over the run and queryable at its end. */
+class ShipUnpackStats : public TObject {
+public:
+   void AddFrame(size_t nhits)
+   {
+      fNFrames++;
+      fNHits += nhits;
+   }
+   void AddUnmatched(size_t n) { fNUnmatched += n; }
+   void AddSkipped(size_t n) { fNSkipped += n; }
+   ULong64_t GetNFrames() const { return fNFrames; }
+   ULong64_t GetNHits() const { return fNHits; }
+   /** Leading edges without trailing edge (drift tubes). */
+   ULong64_t GetNUnmatched() const { return fNUnmatched; }
+   /** Hits on channels which are not connected (RPCs). */
+   ULong64_t GetNSkipped() const { return fNSkipped; }
+   /** option is used as prefix of the summary, e.g. the name of the unpacker. */
+   virtual void Print(Option_t *option = "") const;
+   virtual void Clear(Option_t *option = "");
+
+private:
+   ULong64_t fNFrames = 0;
+   ULong64_t fNHits = 0;
+   ULong64_t fNUnmatched = 0;
+   ULong64_t fNSkipped = 0;
+
+   ClassDef(ShipUnpackStats, 1)
+};
+
+/** Hits of one output array of an unpacker as columns, one entry per hit of the frame.
+ *  tot, flags and channel are only filled for the drift tube TDCs. */
+struct ShipUnpackColumns {
+   std::vector<Int_t> detectorId;
+   std::vector<Float_t> time;
+   std::vector<Float_t> tot;
+   std::vector<UShort_t> flags;
+   std::vector<UShort_t> channel; // TDC and channel, without the edge bit
+   void Add(Int_t id, Float_t t)
+   {
+      detectorId.push_back(id);
+      time.push_back(t);
+   }
+   void Add(Int_t id, Float_t t, Float_t timeOverThreshold, UShort_t hitFlags, UShort_t channelId)
+   {
+      Add(id, t);
+      tot.push_back(timeOverThreshold);
+      flags.push_back(hitFlags);
+      channel.push_back(channelId % 0x1000);
+   }
+   void Clear()
+   {
+      detectorId.clear();
+      time.clear();
+      tot.clear();
+      flags.clear();
+      channel.clear();
+   }
+};
+
 /**
  * An example unpacker of MBS data.
  */
@@ -39,10 +101,33 @@ public:
 
    virtual uint16_t GetPartition() = 0;
 
+   /** Frames, hits, unmatched edges and skipped channels so far. */
+   const ShipUnpackStats &GetStats() const { return fStats; }
+
+   /** Write the output arrays to the output file (default), must be set before Init(). */
+   void SetPersistence(Bool_t persistent) { fPersistent = persistent; }
+
+   /** Fill the hits of each output array as columns in DoUnpack, e.g. for MufluxColumnarWriter.
+    *  Must be set before Init(). Hit objects are then only made if the arrays are persistent. */
+   void SetColumnar(Bool_t columnar) { fColumnar = columnar; }
+   /** Columns by output array name, filled in columnar mode, cleared by Reset(). */
+   std::map<TString, ShipUnpackColumns> &GetColumns() { return fColumns; }
+
 protected:
    /** Register the output structures. */
    virtual void Register() override;
 
+   /** Columns of an output array in columnar mode, nullptr otherwise. To be called in Register(). */
+   ShipUnpackColumns *AddColumns(const char *arrayName) { return fColumnar ? &fColumns[arrayName] : nullptr; }
+   void ClearColumns();
+   /** Hit objects are needed in the output arrays */
+   Bool_t MakeObjects() const { return !fColumnar || fPersistent; }
+
+   ShipUnpackStats fStats; //!
+   Bool_t fPersistent = kTRUE;
+   Bool_t fColumnar = kFALSE;
+   std::map<TString, ShipUnpackColumns> fColumns; //!
+
 private:
    std::unique_ptr<TClonesArray> fRawData; /**< Array of output raw items. */
    Int_t fNHits;           /**< Number of raw items in current event. */
@@ -54,7 +139,7 @@ private:
 
 public:
    // Class definition
-   ClassDefOverride(ShipUnpack, 1)
+   ClassDefOverride(ShipUnpack, 2)
 };
 
 #endif
@@ -0,0 +1,21 @@
+#ifndef ONLINE_SHIPUNPACKLOG_H
+#define ONLINE_SHIPUNPACKLOG_H
+
+#include "FairLogger.h"
+
+// Debug output in the per-frame and per-hit loops of the unpackers.
+// Statements above SHIP_UNPACK_LOG_LEVEL (0: none, 1: per frame, 2: per channel and hit) are dead code,
+// their arguments are never evaluated. Compiled in statements go through LOG(DEBUG) as usual.
+#ifndef SHIP_UNPACK_LOG_LEVEL
+#define SHIP_UNPACK_LOG_LEVEL 0
+#endif
+
+#define UNPACK_LOG(level)                \
+   if (SHIP_UNPACK_LOG_LEVEL < (level)) { \
+   } else                                 \
+      LOG(DEBUG)
+
+#define UNPACK_LOG_FRAME UNPACK_LOG(1)
+#define UNPACK_LOG_HIT UNPACK_LOG(2)
+
+#endif
@@ -113,6 +113,10 @@ class MufluxDigiReco:
         self.v_drift       = modules["MufluxSpectrometer"].TubeVdrift()
         self.sigma_spatial = modules["MufluxSpectrometer"].TubeSigmaSpatial()
         self.viewangle     = modules["MufluxSpectrometer"].ViewAngle()
+        # rt relations as tables per station, the parabola and calibrations taken from h when available
+        self.rtParabola    = ROOT.RTRelation()
+        self.rtParabola.SetParabolas()
+        self.rtCalibration = ROOT.RTRelation()
 
         # access ShipTree
         self.sTree.GetEvent(0)
@@ -124,6 +128,15 @@ class MufluxDigiReco:
         self.fM.init(self.bfield)
 
         ROOT.genfit.MaterialEffects.getInstance().init(self.geoMat)
+        # corrected wire end points of all tubes, see correctAlignment
+        self.alignment = self.alignmentStore()
+        # RPC strip end points from the geometry for real data
+        self.taggerStrips = ROOT.MuonTaggerStripTable()
+        if self.sTree.GetBranch("Digi_MuonTaggerHits"):
+            self.taggerStrips.FillFromGeometry()
+        # C++ version of MufluxPatRec, with nativePR
+        self.trackFinder = ROOT.MufluxTrackFinder()
+        self.patRecHits = ROOT.MufluxPatRecHits()
 
         # init fitter, to be done before importing shipPatRec
         self.fitter      = ROOT.genfit.DAF()
@@ -391,54 +404,76 @@ class MufluxDigiReco:
             pnb = 0
         return statnb,vnb,pnb,lnb,view
 
-    def correctAlignment(self, hit):
+    def layerCorrection(self, s, view, p, l):
         # Taken from charmdet/drifttubeMonitoring.py
-        sqrt2 = ROOT.TMath.Sqrt(2.)
+        # shift (dx,dy) of the wires of a layer
         cos30 = ROOT.TMath.Cos(30./180.*ROOT.TMath.Pi())
         sin30 = ROOT.TMath.Sin(30./180.*ROOT.TMath.Pi())
         #delX=[[0,0,0,0],[0,0,0,0],[0,0,0,0],[0,0,0,0]]
         delX=[[-1.2,1.4,-0.9,0.7],[-1.69-1.31,0.3+2.82,0.6-0.4,-0.8-0.34],[-0.9,1.14,-0.80,1.1],[-0.8,1.29,0.15,2.0]]
         #delUV = [[1.8,-2.,0.8,-1.],[1.2,-1.1,-0.5,0.3]]
         delUV = [[0,0,0,0],[0,0,0,0]]
+        if view=='_x':
+            return delX[s-1][2*l+p],0.
+        if view=='_u':     cor = delUV[0][2*l+p]
+        elif view=='_v':   cor = delUV[1][2*l+p]
+        return cor*cos30,cor*sin30
+
+    def alignmentStore(self):
+        # one module per layer: x views (s-1)*4+2*l+p, u views 16+2*l+p, v views 20+2*l+p
+        # corrected with the layer shifts of layerCorrection
+        store = ROOT.DtAlignmentStore()
+        vtop = ROOT.TVector3()
+        vbot = ROOT.TVector3()
+        for s in range(1,5):
+            for v in range(2):
+                if s>2 and v>0: continue
+                for p in range(2):
+                    for l in range(2):
+                        for straw in range(1,(12 if s<3 else 48)+1):
+                            hit = ROOT.MufluxSpectrometerHit(s*10000000+v*1000000+p*100000+l*10000+2000+straw,0.)
+                            rc = hit.MufluxSpectrometerEndPoints(vbot,vtop)
+                            view = self.stationInfo(hit)[4]
+                            if view=='_x':   module = (s-1)*4+2*l+p
+                            elif view=='_u': module = 16+2*l+p
+                            else:            module = 20+2*l+p
+                            store.SetTube(hit.GetDetectorID(),module,vbot,vtop)
+                        dx,dy = self.layerCorrection(s,view,p,l)
+                        store.SetCorrection(module,dx,dy,0)
+        return store
+
+    def correctAlignment(self, hit):
+        # wire end points shifted by the module corrections of alignmentStore,
+        # the layer shift of layerCorrection for tubes which are not in the store
         vtop = ROOT.TVector3()
         vbot = ROOT.TVector3()
+        if self.alignment.GetEndPoints(hit.GetDetectorID(),vbot,vtop):
+            return vbot,vtop
         rc = hit.MufluxSpectrometerEndPoints(vbot,vtop)
         s,v,p,l,view = self.stationInfo(hit)
-        if view=='_x':
-            cor = delX[s-1][2*l+p]
-            vbot[0]=vbot[0]+cor
-            vtop[0]=vtop[0]+cor
-        else:
-            if view=='_u':     cor = delUV[0][2*l+p]
-            elif view=='_v':   cor = delUV[1][2*l+p]
-            vbot[0]=vbot[0]+cor*cos30
-            vtop[0]=vtop[0]+cor*cos30
-            vbot[1]=vbot[1]+cor*sin30
-            vtop[1]=vtop[1]+cor*sin30
-            #tmp = vbot[0]*ROOT.TMath.Cos(rotUV)-vbot[1]*ROOT.TMath.Sin(rotUV)
-            #vbot[1]=vbot[1]*ROOT.TMath.Cos(rotUV)+vbot[0]*ROOT.TMath.Sin(rotUV)
-            #vbot[0]=tmp
-            #tmp = vtop[0]*ROOT.TMath.Cos(rotUV)-vtop[1]*ROOT.TMath.Sin(rotUV)
-            #vtop[1]=vtop[1]*ROOT.TMath.Cos(rotUV)+vtop[0]*ROOT.TMath.Sin(rotUV)
-            #vbot[0]=tmp
+        dx,dy = self.layerCorrection(s,view,p,l)
+        vbot[0]=vbot[0]+dx
+        vtop[0]=vtop[0]+dx
+        if view!='_x':
+            vbot[1]=vbot[1]+dy
+            vtop[1]=vtop[1]+dy
         return vbot,vtop
 
 
     def RT(self, s,t,function='parabola'):
         # Taken from charmdet/drifttubeMonitoring.py
         # rt relation, drift time to distance, drift time?
-        tMinAndTmax = {1:[587,1860],2:[587,1860],3:[610,2300],4:[610,2100]}
-        R = ShipGeo.MufluxSpectrometer.InnerTubeDiameter/2. #  = 3.63*u.cm
-        # parabola
+        # tables of RTRelation, parabola or the calibration rtTDC<s>000_x sampled between tMin and tMax
+        # tMinAndTmax = {1:[587,1860],2:[587,1860],3:[610,2300],4:[610,2100]}
+        # p1p2 = {1:[688.,7.01],2:[688.,7.01],3:[923.,4.41],4:[819.,0.995]}
         if function == 'parabola' or not h.has_key('rtTDC'+str(s)+'000_x'):
-            p1p2 = {1:[688.,7.01],2:[688.,7.01],3:[923.,4.41],4:[819.,0.995]}
-            t0_corr = max(0,t-tMinAndTmax[s][0])
-            tmp1 = ROOT.TMath.Sqrt(p1p2[s][0]**2+4.*p1p2[s][1]*t0_corr)
-            r = (2*tmp1-2*p1p2[s][0]+p1p2[s][0]*ROOT.TMath.Log(-p1p2[s][0]+2*tmp1)-p1p2[s][0]*ROOT.TMath.Log(p1p2[s][0]) )/(8*p1p2[s][1])
+            r = self.rtParabola.Eval(s,t)
         else:
-            if t > tMinAndTmax[s][1]: r = R
-            elif t< tMinAndTmax[s][0]: r = 0
-            else: r = h['rtTDC'+str(s)+'000_x'].Eval(t)
+            if self.rtCalibration.GetModel(s) == ROOT.RTRelation.kNone:
+                tMinAndTmax = {1:[587,1860],2:[587,1860],3:[610,2300],4:[610,2100]}
+                R = ShipGeo.MufluxSpectrometer.InnerTubeDiameter/2. #  = 3.63*u.cm
+                self.rtCalibration.SetCalibration(s,h['rtTDC'+str(s)+'000_x'],tMinAndTmax[s][0],tMinAndTmax[s][1],R)
+            r = self.rtCalibration.Eval(s,t)
         # h['TDC2R'].Fill(t,r)
         return r
 
@@ -447,20 +482,34 @@ class MufluxDigiReco:
 
         # smear strawtube points
         SmearedHits = []
+        # drift radii of all hits in one call, parabola as RT(s,t)
+        nHits = self.sTree.Digi_MufluxSpectrometerHits.GetEntries()
+        stations = array('i',[0]*nHits)
+        tdcs     = array('f',[0]*nHits)
+        dists    = array('f',[0]*nHits)
+        for key in range(nHits):
+            ahit = self.sTree.Digi_MufluxSpectrometerHits[key]
+            stations[key] = ahit.GetDetectorID()/10000000
+            tdcs[key]     = ahit.GetDigi()
+        self.rtParabola.Evaluate(stations,tdcs,dists,nHits)
+        # corrected wire end points of all hits in one call
+        ends = ROOT.DtWireEnds()
+        self.alignment.GetEndPoints(self.sTree.Digi_MufluxSpectrometerHits,ends)
         key = -1
         for ahit in self.sTree.Digi_MufluxSpectrometerHits:
             key+=1
             detID = ahit.GetDetectorID()
-            top = ROOT.TVector3()
-            bot = ROOT.TVector3()
-            bot, top = self.correctAlignment(ahit)
+            if ends.known[key]:
+                top = ROOT.TVector3(ends.topX[key],ends.topY[key],ends.topZ[key])
+                bot = ROOT.TVector3(ends.botX[key],ends.botY[key],ends.botZ[key])
+            else:
+                bot, top = self.correctAlignment(ahit)
             # modules["MufluxSpectrometer"].TubeEndPoints(detID,bot,top)
             # ahit.MufluxSpectrometerEndPoints(bot,top)
             # MufluxSpectrometerHit::MufluxSpectrometerEndPoints(TVector3 &vbot, TVector3 &vtop)
             # distance to wire.
             # dist  = ahit.GetDigi() * 3.7 / (2000. * 2.)
-            tdc = ahit.GetDigi()
-            dist = self.RT(ahit.GetDetectorID()/10000000, tdc)
+            dist = dists[key]
 
             SmearedHits.append( {'digiHit':key,'xtop':top.x(),'ytop':top.y(),'z':top.z(),'xbot':bot.x(),'ybot':bot.y(),'dist':dist, 'detID':detID} )
 
@@ -490,17 +539,37 @@ class MufluxDigiReco:
         # smear strawtube points
         TaggerHits = []
         key = -1
+        top = ROOT.TVector3()
+        bot = ROOT.TVector3()
         for ahit in self.sTree.Digi_MuonTaggerHits:
             key+=1
             detID = ahit.GetDetectorID()
-            top = ROOT.TVector3()
-            bot = ROOT.TVector3()
-            ahit.EndPoints(bot,top)
+            if not self.taggerStrips.GetEndPoints(detID,bot,top):
+                ahit.EndPoints(bot,top)
 
             TaggerHits.append( {'digiHit':key,'xtop':top.x(),'ytop':top.y(),'z':top.z(),'xbot':bot.x(),'ybot':bot.y(), 'detID':detID} )
 
         return TaggerHits
 
+    def nativePatRec(self):
+
+        # MufluxTrackFinder on the SmearedHits, output as MufluxPatRec.execute
+        hits = self.patRecHits
+        hits.Clear()
+        for ahit in self.SmearedHits:
+            hits.Add(ahit['detID'],ahit['digiHit'],ahit['xtop'],ahit['ytop'],ahit['xbot'],ahit['ybot'],ahit['z'])
+        track_hits = {}
+        for i_track in range(self.trackFinder.Execute(hits)):
+            atrack = self.trackFinder.GetTrack(i_track)
+            track_hits[i_track] = {'y12': [self.SmearedHits[i] for i in atrack.y12],
+                                   'stereo12': [self.SmearedHits[i] for i in atrack.stereo12],
+                                   '34': [self.SmearedHits[i] for i in atrack.y34],
+                                   'y_tagger': [],
+                                   'p': atrack.p,
+                                   'x_in_magnet': atrack.xInMagnet,
+                                   'y_in_magnet': atrack.yInMagnet}
+        return track_hits
+
 
     def getPtruthFirst(self,mcPartKey):
         Ptruth,Ptruthx,Ptruthy,Ptruthz = -1.,-1.,-1.,-1.
@@ -1208,7 +1277,10 @@ class MufluxDigiReco:
         if realPR:
 
             # Do real PatRec
-            track_hits = MufluxPatRec.execute(self.SmearedHits, self.TaggerHits, withNTaggerHits, withDist2Wire)
+            if nativePR:
+                track_hits = self.nativePatRec()
+            else:
+                track_hits = MufluxPatRec.execute(self.SmearedHits, self.TaggerHits, withNTaggerHits, withDist2Wire)
 
             # Create hitPosLists for track fit
             for i_track in track_hits.keys():
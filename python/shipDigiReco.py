@@ -96,9 +96,11 @@ class ShipDigiReco:
    self.digiSplitcalBranch=self.sTree.Branch("Digi_SplitcalHits",self.digiSplitcal,32000,-1) 
    self.recoSplitcal = ROOT.TClonesArray("splitcalCluster") 
    self.recoSplitcalBranch=self.sTree.Branch("Reco_SplitcalClusters",self.recoSplitcal,32000,-1) 
+   if nativeSplitcalClustering: self.splitcalClusterFinder = ROOT.splitcalClusterFinder(0.002) # same noise threshold as in digitizeSplitcal
 
 # setup ecal reconstruction
   self.caloTasks = []  
+  self.ecalPipeline = None
   if self.sTree.GetBranch("EcalPoint") and not self.sTree.GetBranch("splitcalPoint"):
 # Creates. exports and fills calorimeter structure
    dflag = 0
@@ -148,6 +150,11 @@ class ShipDigiReco:
  # ecal drawer: Draws calorimeter structure, incoming particles, clusters, maximums
     ecalDrawer=ROOT.ecalDrawer("clusterFinder",10)
     self.caloTasks.append(ecalDrawer)
+   elif ecalWorkers>1:
+# same chain, instantiated for each worker thread and run over batches of events
+    self.ecalPipeline = ROOT.ecalRecoPipeline(ecalGeo, ecalWorkers, ecalClusterCalib, dflag)
+    self.ecalBatch = 20*ecalWorkers
+    self.caloTasks = []
  # add pid reco
    import shipPid
    self.caloTasks.append(shipPid.Task(self))
@@ -159,7 +166,13 @@ class ShipDigiReco:
   self.PDG = ROOT.TDatabasePDG.Instance()
 # access ShipTree
   self.sTree.GetEvent(0)
-  if len(self.caloTasks)>0:
+  if self.ecalPipeline:
+   print "** initialize Calo reconstruction with ",ecalWorkers," threads **"
+   self.ecalClusters      = ROOT.TClonesArray("ecalCluster")
+   self.EcalClusters = self.sTree.Branch("EcalClusters",self.ecalClusters,32000,-1)
+   self.ecalReconstructed = ROOT.TClonesArray("ecalReconstructed")
+   self.EcalReconstructed = self.sTree.Branch("EcalReconstructed",self.ecalReconstructed,32000,-1)
+  elif len(self.caloTasks)>0:
    print "** initialize Calo reconstruction **" 
    self.ecalStructure     = ecalFiller.InitPython(self.sTree.EcalPointLite)
    ecalDigi.InitPython(self.ecalStructure)
@@ -204,6 +217,7 @@ class ShipDigiReco:
    ntracks = self.findTracks()
    nGoodTracks = self.findGoodTracks()
    self.linkVetoOnTracks()
+   if self.ecalPipeline: self.reconstructEcal()
    for x in self.caloTasks: 
     if hasattr(x,'execute'): x.execute()
     elif x.GetName() == 'ecalFiller': x.Exec('start',self.sTree.EcalPointLite)
@@ -216,6 +230,19 @@ class ShipDigiReco:
 # now go for 2-track combinations
     self.Vertexing.execute()
 
+ def reconstructEcal(self):
+# ECAL input of the next events is read ahead and reconstructed in parallel, results are taken in event order
+   n = self.sTree.GetReadEntry()
+   if not self.ecalPipeline.HasEvent(n):
+    self.ecalPipeline.Clear()
+    branches = [self.sTree.GetBranch("EcalPointLite"),self.sTree.GetBranch("MCTrack")]
+    for k in range(n,min(n+self.ecalBatch,self.sTree.GetEntries())):
+     for b in branches: b.GetEntry(k)
+     self.ecalPipeline.AddEvent(k,self.sTree.EcalPointLite,self.sTree.MCTrack)
+    for b in branches: b.GetEntry(n)
+    self.ecalPipeline.Process()
+   self.ecalPipeline.FillEvent(n,self.ecalClusters,self.ecalReconstructed)
+
  def digitize(self):
    self.sTree.t0 = self.random.Rndm()*1*u.microsecond
    self.header.SetEventTime( self.sTree.t0 )
@@ -260,6 +287,11 @@ class ShipDigiReco:
        self.digiSplitcal[indexOfExistingHit].UpdateEnergy(aHit.GetEnergy())
    self.digiSplitcal.Compress() #remove empty slots from array
 
+   if nativeSplitcalClustering:
+     # same clustering as below, with neighbour search on hits binned per layer and strip coordinate
+     self.splitcalClusterFinder.FindClusters(self.digiSplitcal,self.recoSplitcal)
+     return
+
    ##########################    
    # cluster reconstruction #
    ##########################
@@ -411,7 +443,6 @@ class ShipDigiReco:
        else: aCluster.AddHit(h)
 
      aCluster.SetIndex(int(i))
-     aCluster.ComputeEtaPhiE()
      # aCluster.Print()
 
      if self.recoSplitcal.GetSize() == i: 
@@ -419,6 +450,7 @@ class ShipDigiReco:
      self.recoSplitcal[i]=aCluster
 
    self.recoSplitcal.Compress() #remove empty slots from array
+   ROOT.splitcalCluster.ComputeEtaPhiEForEvent(self.recoSplitcal)
 
 
    # #################
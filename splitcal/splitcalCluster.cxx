@@ -1,10 +1,12 @@
 #include "splitcalCluster.h"
 #include "TMath.h"
+#include "TClonesArray.h"
 
 #include <iostream>
 #include <math.h>
 #include <functional>   
 #include <numeric>     
+#include <algorithm>
 
 
 // -----   constructor from list/vector of splitcalHit   ------------------------------------------
@@ -183,6 +185,129 @@ void splitcalCluster::ComputeEtaPhiE()
 
 
 
+void splitcalCluster::ComputeEtaPhiEForEvent(TClonesArray* clusters)
+{
+
+  // buffer is reused from event to event, no allocation once it reached the size of the largest event
+  static thread_local std::vector<splitcalBufferHit > buffer;
+  static thread_local std::vector<size_t > firstHit;
+  static thread_local std::vector<double > clusterEnergy;
+
+  int nClusters = clusters->GetEntriesFast();
+  buffer.clear();
+  firstHit.clear();
+  clusterEnergy.clear();
+
+  // fill the buffer, the cluster energy is summed in hit order as in ComputeEtaPhiE
+  for (int i=0; i<nClusters; i++) {
+    splitcalCluster* cluster = static_cast<splitcalCluster*>(clusters->At(i));
+    firstHit.push_back(buffer.size());
+    double energy = 0.;
+    int sequence = 0;
+    for (auto hit : cluster->_vectorOfHits){
+      splitcalBufferHit h;
+      h.layer = hit->GetLayerNumber();
+      h.sequence = sequence++;
+      h.isX = hit->IsX();
+      h.isY = hit->IsY();
+      h.x = hit->GetX();
+      h.y = hit->GetY();
+      h.z = hit->GetZ();
+      h.energy = hit->GetEnergyForCluster(cluster->_index);
+      energy += h.energy;
+      buffer.push_back(h);
+    }
+    clusterEnergy.push_back(energy);
+  }
+  firstHit.push_back(buffer.size());
+
+  for (int i=0; i<nClusters; i++) {
+    splitcalCluster* cluster = static_cast<splitcalCluster*>(clusters->At(i));
+    auto begin = buffer.begin() + firstHit[i];
+    auto end = buffer.begin() + firstHit[i+1];
+    // group the hits by layer, keeping the original order inside a layer
+    std::sort(begin, end, [](const splitcalBufferHit& a, const splitcalBufferHit& b) {
+	return a.layer < b.layer || (a.layer == b.layer && a.sequence < b.sequence); });
+
+    // running sums of the energy weighted coordinates of the current layer
+    double sumWX = 0., sumWeightsX = 0., z1 = 0.;
+    double sumWY = 0., sumWeightsY = 0., z2 = 0.;
+    bool hasX = false, hasY = false;
+    // first and last layer giving x and y, as start and end point of the cluster
+    bool foundX = false, foundY = false;
+    double minX = 0., minZ1 = 0., maxX = 0., maxZ1 = 0.;
+    double minY = 0., minZ2 = 0., maxY = 0., maxZ2 = 0.;
+    // running sums for the zx and zy regressions over the layer averages
+    double nZX = 0., sZ1 = 0., sX = 0., sZ1Z1 = 0., sZ1X = 0.;
+    double nZY = 0., sZ2 = 0., sY = 0., sZ2Z2 = 0., sZ2Y = 0.;
+
+    for (auto it = begin; it != end; ++it) {
+      // hits from high precision layers give both x and y coordinates --> use if-if instead of if-else
+      if (it->isX) {
+	sumWX += it->x*it->energy;
+	sumWeightsX += it->energy;
+	z1 = it->z;
+	hasX = true;
+      }
+      if (it->isY) {
+	sumWY += it->y*it->energy;
+	sumWeightsY += it->energy;
+	z2 = it->z;
+	hasY = true;
+      }
+      if (it+1 != end && (it+1)->layer == it->layer) continue;
+
+      // last hit of the layer
+      if (hasX) {
+	double x = sumWX/sumWeightsX;
+	if (!foundX) { minX = x; minZ1 = z1; foundX = true; }
+	maxX = x; maxZ1 = z1;
+	nZX += 1.; sZ1 += z1; sX += x; sZ1Z1 += z1*z1; sZ1X += z1*x;
+      }
+      if (hasY) {
+	double y = sumWY/sumWeightsY;
+	// z of the start and end point is taken from the x measurement of the same layer, as in ComputeEtaPhiE
+	double z = hasX ? z1 : 0.;
+	if (!foundY) { minY = y; minZ2 = z; foundY = true; }
+	maxY = y; maxZ2 = z;
+	nZY += 1.; sZ2 += z2; sY += y; sZ2Z2 += z2*z2; sZ2Y += z2*y;
+      }
+      sumWX = sumWeightsX = sumWY = sumWeightsY = 0.;
+      hasX = hasY = false;
+    }
+
+    double energy = clusterEnergy[i];
+    if (!foundX || !foundY) {
+      cluster->SetEnergy(energy);
+      continue;
+    }
+
+    cluster->SetStartPoint(minX, minY, (minZ1+minZ2)/2.);
+    cluster->SetEndPoint(maxX, maxY, (maxZ1+maxZ2)/2.);
+
+    // get direction vector from end-strat vector difference
+    TVector3 direction = cluster->_end - cluster->_start;
+    double eta = direction.Eta();
+    double phi = direction.Phi();
+    cluster->SetEtaPhiE(eta, phi, energy);
+
+    double denominatorZX = nZX*sZ1Z1 - sZ1*sZ1;
+    if (denominatorZX != 0.) {
+      cluster->_mZX = (nZX*sZ1X - sZ1*sX)/denominatorZX;
+      cluster->_qZX = (sZ1Z1*sX - sZ1X*sZ1)/denominatorZX;
+    }
+    double denominatorZY = nZY*sZ2Z2 - sZ2*sZ2;
+    if (denominatorZY != 0.) {
+      cluster->_mZY = (nZY*sZ2Y - sZ2*sY)/denominatorZY;
+      cluster->_qZY = (sZ2Z2*sY - sZ2Y*sZ2)/denominatorZY;
+    }
+  }
+
+  return;
+}
+
+
+
 regression splitcalCluster::LinearRegression(std::vector<double >& x, std::vector<double >& y) {
 
   const auto n    = x.size();
@@ -11,6 +11,8 @@
 /* #include <TLorentzVector.h> */
 #include <TVector3.h>
 
+class TClonesArray;
+
 struct regression
 {
 
@@ -21,6 +23,18 @@ struct regression
 
 };
 
+// hit of the contiguous per-event buffer used by splitcalCluster::ComputeEtaPhiEForEvent
+struct splitcalBufferHit
+{
+
+  int layer;
+  int sequence; // position of the hit in the cluster, keeps the summation order of ComputeEtaPhiE
+  bool isX, isY;
+  double x, y, z;
+  double energy; // energy assigned to the cluster
+
+};
+
 
 class splitcalCluster : public TObject
 {
@@ -65,6 +79,9 @@ class splitcalCluster : public TObject
 
     regression LinearRegression(std::vector<double >& x, std::vector<double >& y);
     void ComputeEtaPhiE();
+    // same as ComputeEtaPhiE for all clusters of the event in one call: the hits are copied once to a
+    // reused contiguous buffer and each cluster is done in a single pass, also filling the zx/zy regression
+    static void ComputeEtaPhiEForEvent(TClonesArray* clusters);
     
     // temporary for test
     double GetSlopeZX() {return _mZX;}
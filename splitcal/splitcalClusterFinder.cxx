@@ -0,0 +1,309 @@
+#include "splitcalClusterFinder.h"
+#include "splitcalCluster.h"
+#include "TClonesArray.h"
+
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <math.h>
+
+
+// allow one or more 'missing' hit in x/y: not large difference between 1 (no gap) or 2 (one 'missing' hit)
+static const double maxGap = 2.;
+// minimum number of hits for a subcluster not to be considered a fragment
+static const size_t minSubclusterSize = 5;
+
+// -----   Default constructor   -------------------------------------------
+splitcalClusterFinder::splitcalClusterFinder()
+  : _noiseEnergyThreshold(0.002), _step(1)
+{
+}
+// -----   Standard constructor   ------------------------------------------
+splitcalClusterFinder::splitcalClusterFinder(double noiseEnergyThreshold)
+  : _noiseEnergyThreshold(noiseEnergyThreshold), _step(1)
+{
+}
+
+
+int splitcalClusterFinder::FindClusters(TClonesArray* hits, TClonesArray* clusters)
+{
+
+  // hit selection
+  // step 0: select hits above noise threshold to use in cluster reconstruction
+  std::vector<splitcalHit* > hitsAboveThreshold;
+  for (int i=0; i<hits->GetEntriesFast(); i++) {
+    splitcalHit* hit = static_cast<splitcalHit*>(hits->At(i));
+    if (hit->GetEnergy() > _noiseEnergyThreshold) {
+      hit->SetIsUsed(0);
+      hitsAboveThreshold.push_back(hit);
+    }
+  }
+
+  // clustering
+  // step 1: group of neighbouring cells: loose criteria -> splitting clusters is easier than merging clusters
+  _step = 1;
+  std::vector<std::vector<splitcalHit* > > clustersOfHits = Clustering(hitsAboveThreshold);
+
+  // step 2: to check if clusters can be split do clustering separtely in the XZ and YZ planes
+  _step = 2;
+  std::vector<std::vector<splitcalHit* > > finalClusters;
+
+  for (auto& cluster : clustersOfHits) {
+
+    std::vector<splitcalHit* > hitsX;
+    std::vector<splitcalHit* > hitsY;
+    for (auto hit : cluster) {
+      hit->SetIsUsed(0);
+      if (hit->IsX()) hitsX.push_back(hit);
+      if (hit->IsY()) hitsY.push_back(hit);
+    }
+
+    // re-run reclustering only in xz plane
+    std::vector<std::vector<splitcalHit* > > subclustersOfHitsX = Clustering(hitsX);
+    double clusterEnergyX = GetClusterEnergy(hitsX);
+    std::vector<std::vector<splitcalHit* > > subclustersX = GetSubclustersExcludingFragments(subclustersOfHitsX);
+    std::vector<double > weightsFromXSplitting;
+    for (auto& subcluster : subclustersX) weightsFromXSplitting.push_back(GetClusterEnergy(subcluster)/clusterEnergyX);
+
+    // re-run reclustering only in yz plane
+    std::vector<std::vector<splitcalHit* > > subclustersOfHitsY = Clustering(hitsY);
+    double clusterEnergyY = GetClusterEnergy(hitsY);
+    std::vector<std::vector<splitcalHit* > > subclustersY = GetSubclustersExcludingFragments(subclustersOfHitsY);
+    std::vector<double > weightsFromYSplitting;
+    for (auto& subcluster : subclustersY) weightsFromYSplitting.push_back(GetClusterEnergy(subcluster)/clusterEnergyY);
+
+    // final list of clusters: every combination of x and y subclusters, the hits are shared
+    // with the energy weight coming from the splitting in the other view
+    for (size_t ix=0; ix<subclustersX.size(); ix++) {
+      for (size_t iy=0; iy<subclustersY.size(); iy++) {
+	int indexFinalCluster = finalClusters.size();
+	for (auto hit : subclustersY[iy]) {
+	  hit->AddClusterIndex(indexFinalCluster);
+	  hit->AddEnergyWeight(weightsFromXSplitting[ix]);
+	}
+	for (auto hit : subclustersX[ix]) {
+	  hit->AddClusterIndex(indexFinalCluster);
+	  hit->AddEnergyWeight(weightsFromYSplitting[iy]);
+	}
+	std::vector<splitcalHit* > finalCluster(subclustersY[iy]);
+	finalCluster.insert(finalCluster.end(), subclustersX[ix].begin(), subclustersX[ix].end());
+	finalClusters.push_back(finalCluster);
+      }
+    }
+  }
+
+  // fill clusters
+  for (size_t i=0; i<finalClusters.size(); i++) {
+    splitcalCluster* aCluster = new((*clusters)[i]) splitcalCluster(finalClusters[i][0]);
+    for (size_t j=1; j<finalClusters[i].size(); j++) aCluster->AddHit(finalClusters[i][j]);
+    aCluster->SetIndex(i);
+  }
+  splitcalCluster::ComputeEtaPhiEForEvent(clusters);
+
+  return finalClusters.size();
+
+}
+
+
+void splitcalClusterFinder::BuildGrid(std::vector<splitcalHit* >& inputHits)
+{
+
+  size_t n = inputHits.size();
+  _hits = inputHits;
+  _x.resize(n); _y.resize(n); _z.resize(n);
+  _xError.resize(n); _yError.resize(n); _zError.resize(n);
+  _isX.resize(n); _isY.resize(n);
+  _layers.clear();
+
+  std::map<int, int> layerIndex;
+  for (size_t i=0; i<n; i++) {
+    splitcalHit* hit = inputHits[i];
+    _x[i] = hit->GetX();
+    _y[i] = hit->GetY();
+    _z[i] = hit->GetZ();
+    _isX[i] = hit->IsX();
+    _isY[i] = hit->IsY();
+    _xError[i] = _isX[i] ? hit->GetXError()*maxGap : hit->GetXError();
+    _yError[i] = _isY[i] ? hit->GetYError()*maxGap : hit->GetYError();
+    _zError[i] = hit->GetZError();
+
+    int layer = hit->GetLayerNumber();
+    auto it = layerIndex.find(layer);
+    if (it == layerIndex.end()) {
+      it = layerIndex.insert(std::make_pair(layer, (int)_layers.size())).first;
+      splitcalLayerBin bin;
+      bin.zMin = bin.zMax = _z[i];
+      bin.maxXError = bin.maxYError = bin.maxZError = 0.;
+      _layers.push_back(bin);
+    }
+    splitcalLayerBin& bin = _layers[it->second];
+    bin.zMin = std::min(bin.zMin, _z[i]);
+    bin.zMax = std::max(bin.zMax, _z[i]);
+    bin.maxXError = std::max(bin.maxXError, _xError[i]);
+    bin.maxYError = std::max(bin.maxYError, _yError[i]);
+    bin.maxZError = std::max(bin.maxZError, _zError[i]);
+    bin.sortedByX.push_back(i);
+    bin.sortedByY.push_back(i);
+  }
+
+  for (auto& bin : _layers) {
+    std::sort(bin.sortedByX.begin(), bin.sortedByX.end(), [this](int a, int b) {return _x[a] < _x[b];});
+    std::sort(bin.sortedByY.begin(), bin.sortedByY.end(), [this](int a, int b) {return _y[a] < _y[b];});
+  }
+
+}
+
+
+void splitcalClusterFinder::GetNeighbours(int index, std::vector<int >& neighbours)
+{
+
+  // same window rules as shipDigiReco.getNeighbours, the layer bins and the sorted strip
+  // coordinates are only used to restrict the hits the rules are evaluated on
+  neighbours.clear();
+  _candidates.clear();
+
+  // for step 2 relax the condition on Dz (some clusters were split erroneously along z while here one wants to split only in x/y)
+  double zFactor = _step == 1 ? 2. : 6.;
+  double x1 = _x[index], y1 = _y[index], z1 = _z[index];
+  double errX1 = _xError[index], errY1 = _yError[index], errZ1 = _zError[index];
+  // windows are slightly enlarged so that rounding never drops a hit passing the exact selection below
+  const double tolerance = 1e-9;
+
+  for (auto& bin : _layers) {
+    double zWindow = zFactor*(errZ1 + bin.maxZError) + tolerance;
+    if (z1 < bin.zMin - zWindow || z1 > bin.zMax + zWindow) continue;
+    if (_isX[index]) {
+      double xWindow = errX1 + bin.maxXError + tolerance;
+      auto first = std::lower_bound(bin.sortedByX.begin(), bin.sortedByX.end(), x1 - xWindow, [this](int a, double v) {return _x[a] < v;});
+      for (auto it = first; it != bin.sortedByX.end() && _x[*it] <= x1 + xWindow; ++it) _candidates.push_back(*it);
+    }
+    if (_isY[index]) {
+      double yWindow = errY1 + bin.maxYError + tolerance;
+      auto first = std::lower_bound(bin.sortedByY.begin(), bin.sortedByY.end(), y1 - yWindow, [this](int a, double v) {return _y[a] < v;});
+      for (auto it = first; it != bin.sortedByY.end() && _y[*it] <= y1 + yWindow; ++it) _candidates.push_back(*it);
+    }
+  }
+
+  // keep the order of the input hits, as the python implementation does
+  std::sort(_candidates.begin(), _candidates.end());
+  _candidates.erase(std::unique(_candidates.begin(), _candidates.end()), _candidates.end());
+
+  for (auto i2 : _candidates) {
+    if (i2 == index) continue;
+    double Dx = fabs(_x[i2]-x1);
+    double Dy = fabs(_y[i2]-y1);
+    double Dz = fabs(_z[i2]-z1);
+    double errX = errX1 + _xError[i2];
+    double errY = errY1 + _yError[i2];
+    double errZ = zFactor*(errZ1 + _zError[i2]);
+    bool isNeighbour = false;
+    if (_isX[index] && Dx<=errX && Dz<=errZ && ((Dy<=errY && Dz>0.) || Dy==0)) isNeighbour = true;
+    if (_isY[index] && Dy<=errY && Dz<=errZ && ((Dx<=errX && Dz>0.) || Dx==0)) isNeighbour = true;
+    if (isNeighbour) neighbours.push_back(i2);
+  }
+
+}
+
+
+std::vector<std::vector<splitcalHit* > > splitcalClusterFinder::Clustering(std::vector<splitcalHit* >& inputHits)
+{
+
+  std::vector<std::vector<splitcalHit* > > hitsInCluster;
+  BuildGrid(inputHits);
+
+  std::vector<int > neighbours;
+  std::vector<int > expandNeighbours;
+  // cluster number for which a hit was already queued as neighbour
+  std::vector<int > inNeighbours(_hits.size(), -1);
+
+  for (size_t i=0; i<_hits.size(); i++) {
+    splitcalHit* hit = _hits[i];
+    if (hit->IsUsed()==1) continue;
+
+    GetNeighbours(i, neighbours);
+    if (neighbours.size() < 1) continue; // lonely fragment
+
+    int clusterIndex = hitsInCluster.size();
+    hit->SetIsUsed(1);
+    hitsInCluster.push_back(std::vector<splitcalHit* >(1, hit));
+    for (auto n : neighbours) inNeighbours[n] = clusterIndex;
+
+    // neighbours grows while the cluster is expanded
+    for (size_t k=0; k<neighbours.size(); k++) {
+      splitcalHit* neighbouringHit = _hits[neighbours[k]];
+      if (neighbouringHit->IsUsed()==1) continue;
+
+      neighbouringHit->SetIsUsed(1);
+      hitsInCluster[clusterIndex].push_back(neighbouringHit);
+
+      GetNeighbours(neighbours[k], expandNeighbours);
+      for (auto additional : expandNeighbours) {
+	if (inNeighbours[additional] != clusterIndex) {
+	  inNeighbours[additional] = clusterIndex;
+	  neighbours.push_back(additional);
+	}
+      }
+    }
+  }
+
+  return hitsInCluster;
+
+}
+
+
+std::vector<std::vector<splitcalHit* > > splitcalClusterFinder::GetSubclustersExcludingFragments(std::vector<std::vector<splitcalHit* > >& subclusters)
+{
+
+  std::vector<int > fragmentIndices;
+  std::vector<int > subclusterIndices;
+  for (size_t k=0; k<subclusters.size(); k++) {
+    if (subclusters[k].size() < minSubclusterSize) fragmentIndices.push_back(k); //FIXME: it can be tuned on a physics case
+    else subclusterIndices.push_back(k);
+  }
+
+  // merge fragments in the closest subcluster. If there is not subcluster but everything is fragmented, merge all the fragments together
+  // as in the python implementation, the closest distance is not reset between fragments
+  double minDistance = -1;
+  int minIndex = -1;
+
+  if (subclusterIndices.size() == 0 && fragmentIndices.size() != 0) subclusterIndices.push_back(0); // merge all fragments into the first fragment
+
+  for (auto indexFragment : fragmentIndices) {
+    splitcalHit* firstHitFragment = subclusters[indexFragment][0];
+    for (auto indexSubcluster : subclusterIndices) {
+      splitcalHit* firstHitSubcluster = subclusters[indexSubcluster][0];
+      double distance;
+      if (firstHitFragment->IsX()) distance = fabs(firstHitFragment->GetX()-firstHitSubcluster->GetX());
+      else distance = fabs(firstHitFragment->GetY()-firstHitSubcluster->GetY());
+      if (minDistance < 0 || distance < minDistance) {
+	minDistance = distance;
+	minIndex = indexSubcluster;
+      }
+    }
+    if (minIndex != indexFragment) { // in case there were only fragments - this is to prevent to sum twice fragment 0
+      subclusters[minIndex].insert(subclusters[minIndex].end(), subclusters[indexFragment].begin(), subclusters[indexFragment].end());
+    }
+  }
+
+  std::vector<std::vector<splitcalHit* > > subclustersExcludingFragments;
+  for (auto indexSubcluster : subclusterIndices) subclustersExcludingFragments.push_back(subclusters[indexSubcluster]);
+
+  return subclustersExcludingFragments;
+
+}
+
+
+double splitcalClusterFinder::GetClusterEnergy(std::vector<splitcalHit* >& hits)
+{
+  double energy = 0.;
+  for (auto hit : hits) energy += hit->GetEnergy();
+  return energy;
+}
+
+// -------------------------------------------------------------------------
+
+// -----   Destructor   ----------------------------------------------------
+splitcalClusterFinder::~splitcalClusterFinder() { }
+// -------------------------------------------------------------------------
+
+ClassImp(splitcalClusterFinder)
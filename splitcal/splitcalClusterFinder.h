@@ -0,0 +1,70 @@
+#ifndef SPLITCALCLUSTERFINDER_H
+#define SPLITCALCLUSTERFINDER_H 1
+
+#include "TObject.h"
+
+#include "splitcalHit.h"
+#include <vector>
+
+class TClonesArray;
+
+// per-layer bin of the hits used in one clustering pass,
+// hits are kept sorted along the x and y strip coordinates for the window lookup
+struct splitcalLayerBin
+{
+  double zMin, zMax;
+  double maxXError, maxYError, maxZError;
+  std::vector<int > sortedByX;
+  std::vector<int > sortedByY;
+};
+
+
+class splitcalClusterFinder : public TObject
+{
+  public:
+
+    /** Constructors **/
+    splitcalClusterFinder();
+    /** Constructor with arguments
+     *@param noiseEnergyThreshold   hits below this energy (GeV) are not used in the clustering
+     **/
+    splitcalClusterFinder(double noiseEnergyThreshold);
+
+    /** Destructor **/
+    virtual ~splitcalClusterFinder();
+
+    /** Methods **/
+    void SetNoiseEnergyThreshold(double e) {_noiseEnergyThreshold = e;}
+    double GetNoiseEnergyThreshold() {return _noiseEnergyThreshold;}
+
+    // same algorithm as shipDigiReco.digitizeSplitcal: step 1 clustering of all hits above threshold,
+    // step 2 re-clustering of each cluster separately in the xz and yz planes, fragment removal,
+    // and filling of the splitcalCluster objects. Returns the number of clusters written.
+    int FindClusters(TClonesArray* hits, TClonesArray* clusters);
+
+  private:
+    /** Copy constructor **/
+    splitcalClusterFinder(const splitcalClusterFinder& finder);
+    splitcalClusterFinder operator=(const splitcalClusterFinder& finder);
+
+    void BuildGrid(std::vector<splitcalHit* >& inputHits);
+    void GetNeighbours(int index, std::vector<int >& neighbours);
+    std::vector<std::vector<splitcalHit* > > Clustering(std::vector<splitcalHit* >& inputHits);
+    std::vector<std::vector<splitcalHit* > > GetSubclustersExcludingFragments(std::vector<std::vector<splitcalHit* > >& subclusters);
+    double GetClusterEnergy(std::vector<splitcalHit* >& hits);
+
+    double _noiseEnergyThreshold;
+    int _step; //!
+
+    // flat copy of the hits of the current clustering pass, errors already include the allowed gap
+    std::vector<splitcalHit* > _hits; //!
+    std::vector<double > _x, _y, _z, _xError, _yError, _zError; //!
+    std::vector<bool > _isX, _isY; //!
+    std::vector<splitcalLayerBin > _layers; //!
+    std::vector<int > _candidates; //!
+
+    ClassDef(splitcalClusterFinder,1);
+
+};
+
+#endif
@@ -1,7 +1,18 @@
 #define CATCH_CONFIG_MAIN
 #include "/usr/include/catch/catch.hpp"
 #include "../online/ShipOnlineDataFormat.h"
+#include "../online/DriftTubeMatching.h"
+#include "../online/DriftTubeCalibration.h"
+#include "../online/RPCDecoding.h"
+#include "../online/ShipTdcSubFrames.h"
 #include "ROOT/TSeq.hxx"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
 
 using namespace DriftTubes;
 
@@ -106,3 +117,603 @@ TEST_CASE("Detector ID conversion (RC signal)", "[RC_signal]")
    REQUIRE(DetectorIdTest(1121) == -1);
    REQUIRE(DetectorIdTest(1122) == -1);
 }
+
+// Channel mapping as done before the compile-time tables (ChannelId::GetDetectorId and
+// GetDetectorIdCharm), kept verbatim as independent reference for the tables
+int ReferenceDetectorId(int TDC, int channel)
+{
+   bool trigger = false;
+   bool beamcounter = false;
+   bool RC_signal = false;
+   bool scintillatorA = false;
+   bool scintillatorB = false;
+   bool master_trigger = false;
+   bool blacklisted = false;
+   int module = 0;
+   int station = 0;
+   int channel_offset = 0;
+   switch (TDC) {
+   case 0:
+      trigger = channel == 126;
+      scintillatorA = channel == 127;
+      station = (channel < 96) ? 1 : 2;
+      module = (channel / 48) % 2;
+      blacklisted = channel >= 120;
+      break;
+   case 1:
+      trigger = channel == 0;
+      scintillatorA = channel == 1;
+      station = (channel < 80) ? 2 : 4;
+      channel_offset = (channel < 80) ? 112 : 1;
+      channel_offset += (channel >= 32 && channel < 48) ? +16 : (channel >= 48 && channel < 64) ? -16 : 0;
+      blacklisted = channel < 8;
+      blacklisted |= channel >= 128;
+      break;
+   case 2:
+      trigger = channel == 126;
+      scintillatorB = channel == 127;
+      station = 4;
+      channel_offset = -119;
+      module = (channel / 48) % 3 + 1;
+      blacklisted = channel >= 120;
+      break;
+   case 3:
+      trigger = channel == 0;
+      scintillatorB = channel == 1;
+      station = (channel < 32) ? 4 : 3;
+      channel_offset = (channel < 32) ? 1 : 33;
+      module = ((channel + 16) / 48 + 3) % 4;
+      blacklisted = channel < 8;
+      blacklisted |= channel >= 128;
+      break;
+   case 4:
+      trigger = channel == 96;
+      RC_signal = channel == 97 || channel == 98;
+      master_trigger = channel == 99;
+      beamcounter = channel > 111;
+      module = (channel / 48) % 2 + 2;
+      channel_offset = (channel < 48) * 33;
+      station = 3;
+      blacklisted = channel >= 96;
+      break;
+   }
+   if (trigger) {
+      return 0;
+   } else if (master_trigger) {
+      return 1;
+   } else if (beamcounter || RC_signal) {
+      return -1;
+   } else if (scintillatorA) {
+      return 6;
+   } else if (scintillatorB) {
+      return 7;
+   } else if(blacklisted) {
+      return -2;
+   }
+   bool reverse_x = !(station == 2 || (TDC == 4 && channel >= 48));
+   int _channel = channel + channel_offset;
+   _channel += (_channel < 0) * 0x80;
+   _channel = reverse_x ? (0x80 - _channel % 0x80) % 0x80 : _channel;
+   if (TDC == 0 && channel < 96) {
+      _channel += _channel ? 63 : 191;
+   } else if (TDC == 3 && channel < 96) {
+      _channel += (channel < 32) ? 24 : 32;
+   }
+   if (TDC == 1) {
+      module = (_channel / 48) % 2;
+   }
+
+   int view = (station == 1 || station == 2) * module % 2;
+   int plane = (TDC == 2) ? ((_channel % 48) / 24 + 1) % 2
+                          : (station == 3 && TDC == 4) ? 1 - (channel % 48) / 24 : (_channel % 48) / 24;
+   if (station == 4 && TDC == 3) {
+      plane -= 1;
+   }
+   int layer = (TDC == 4) ? 1 - (channel % 24) / 12 : (_channel % 24) / 12;
+   int straw = _channel % 12 + ((station == 3 || station == 4) ? 1 + (3 - module) * 12 : 1);
+   return station * 10000000 + view * 1000000 + plane * 100000 + layer * 10000 + 2000 + straw;
+}
+
+int ReferenceDetectorIdCharm(int TDC, int channel)
+ {
+   bool trigger = false;
+   bool beamcounter = false;
+   bool RC_signal = false;
+   bool master_trigger = false;
+   int module = 0;
+   int station = 0;
+   int module_channel = 0;
+   switch (TDC) {
+   case 0:
+     trigger = channel == 126 || channel == 120;
+     RC_signal = channel == 121 || channel == 122;
+     master_trigger = channel == 123;
+     station = 3;
+     module = (channel < 96) ? 2 + (channel / 48) % 2 : 0;
+     module_channel = channel % 48;
+     //reverse front end board
+     if(module == 3) module_channel = 12*(module_channel/12)+(11-module_channel%12);
+     break;
+   case 1:
+     trigger = channel == 0;
+     beamcounter = channel >=2 && channel <= 5;
+     station = (channel < 80) ? 3 : 4;
+     module = (channel >= 32 && channel < 80) ? 1 : 0;
+     module_channel = (channel + 16) % 48;
+     //cable swap
+     if(module==1) module_channel += ( module_channel < 16 ) ? 16 : ( module_channel < 32 ) ? -16 : 0;
+     break;
+   case 2:
+     trigger = channel == 126;
+     station = 4;
+     module = (channel / 48)  + 1 ;
+     module_channel = channel % 48;
+     break;
+   case 3:
+     trigger = channel == 0;
+     station = (channel < 32 || channel >= 80) ? 4 : 3;
+     module = (channel < 32 ) ? 3 : 4;
+     module_channel = (channel + 16) % 48;
+     break;
+   }
+   if (trigger) {
+     return 0;
+   } else if (master_trigger) {
+     return 1;
+   } else if (beamcounter || RC_signal) {
+     return -1;
+   }
+   
+   int plane = 1 - (module_channel / 24);
+   int layer = 1 - (module_channel % 24) / 12;
+   int straw = (module >= 4 ? module : 3 - module) * 12 + (11 - (module_channel % 12)) + 1;
+   
+   return station * 10000000 + plane * 100000 + layer * 10000 + 2000 + straw;
+}
+
+TEST_CASE("Detector ID lookup table", "[drifttubes]")
+{
+   // All channel identifiers, including edge and padding bits
+   for (auto i : ROOT::TSeqI(0x10000)) {
+      uint16_t channel = i;
+      auto id = reinterpret_cast<ChannelId *>(&channel);
+      REQUIRE(id->GetDetectorId() == ReferenceDetectorId(id->TDC, id->channel));
+      REQUIRE(id->GetDetectorIdCharm() == ReferenceDetectorIdCharm(id->TDC, id->channel));
+   }
+}
+
+// Edge matching as done before the scratch arena, used as reference
+std::vector<EdgeMatch> ReferenceMatch(const std::vector<RawDataHit> &hits)
+{
+   std::vector<EdgeMatch> matches;
+   std::set<uint16_t> channels;
+   std::vector<RawDataHit> leading, trailing;
+   for (auto &&hit : hits) {
+      channels.emplace(hit.channelId % 0x1000);
+      (hit.channelId < 0x1000 ? leading : trailing).emplace_back(hit);
+   }
+   auto compare_hit_time = [](const RawDataHit &a, const RawDataHit &b) { return a.hitTime < b.hitTime; };
+   std::sort(leading.begin(), leading.end(), compare_hit_time);
+   std::sort(trailing.begin(), trailing.end(), compare_hit_time);
+   std::map<uint16_t, std::vector<uint16_t>> channel_leading, channel_trailing;
+   for (auto &&hit : leading) {
+      channel_leading[hit.channelId % 0x1000].emplace_back(hit.hitTime);
+   }
+   for (auto &&hit : trailing) {
+      channel_trailing[hit.channelId % 0x1000].emplace_back(hit.hitTime);
+   }
+   for (auto &&channel : channels) {
+      bool first = true;
+      auto &&l = channel_leading[channel];
+      auto &&t = channel_trailing[channel];
+      for (int i = 0, j = 0; i < int(l.size()); i++) {
+         if (j < int(t.size()) && l[i] < t[j] && (i + 1 >= int(l.size()) || t[j] < l[i + 1])) {
+            matches.push_back({channel, l[i], float(0.098 * (t[j] - l[i])), first, true, t[j]});
+            first = false;
+            j++;
+         } else if (j < int(t.size()) && l[i] > t[j] && (j + 1) < int(t.size())) {
+            i--;
+            j++;
+         } else {
+            matches.push_back({channel, l[i], 167.2f, first, false, 0});
+            first = false;
+         }
+      }
+   }
+   return matches;
+}
+
+void RequireSameMatches(const std::vector<EdgeMatch> &a, const std::vector<EdgeMatch> &b)
+{
+   REQUIRE(a.size() == b.size());
+   for (auto i : ROOT::TSeqI(a.size())) {
+      REQUIRE(a[i].channel == b[i].channel);
+      REQUIRE(a[i].time == b[i].time);
+      REQUIRE(a[i].time_over_threshold == b[i].time_over_threshold);
+      REQUIRE(a[i].first == b[i].first);
+      REQUIRE(a[i].matched == b[i].matched);
+      REQUIRE(a[i].trailing == b[i].trailing);
+   }
+}
+
+TEST_CASE("Edge matching", "[drifttubes]")
+{
+   EdgeMatcher matcher;
+   SECTION("Leading and trailing edge")
+   {
+      std::vector<RawDataHit> hits = {{0x1005, 200}, {0x0005, 100}};
+      auto &&matches = matcher.Match(hits.data(), hits.size());
+      REQUIRE(matches.size() == 1);
+      REQUIRE(matches[0].channel == 5);
+      REQUIRE(matches[0].time == 100);
+      REQUIRE(matches[0].time_over_threshold == float(0.098 * 100));
+      REQUIRE(matches[0].first);
+      REQUIRE(matches[0].matched);
+      REQUIRE(matcher.GetNMatched() == 1);
+      REQUIRE(matcher.GetNUnmatched() == 0);
+   }
+   SECTION("Unmatched leading edges and trailing edge only channels")
+   {
+      std::vector<RawDataHit> hits = {{0x0007, 300}, {0x0007, 100}, {0x1003, 50}};
+      auto &&matches = matcher.Match(hits.data(), hits.size());
+      REQUIRE(matches.size() == 2);
+      REQUIRE(matches[0].time == 100);
+      REQUIRE(matches[0].first);
+      REQUIRE(!matches[0].matched);
+      REQUIRE(matches[1].time == 300);
+      REQUIRE(!matches[1].first);
+      REQUIRE(matches[1].time_over_threshold == 167.2f);
+      REQUIRE(matcher.GetNLeading() == 2);
+      REQUIRE(matcher.GetNUnmatched() == 2);
+   }
+   SECTION("Trailing edge before leading edge is skipped")
+   {
+      std::vector<RawDataHit> hits = {{0x1009, 10}, {0x0009, 100}, {0x1009, 150}};
+      auto &&matches = matcher.Match(hits.data(), hits.size());
+      REQUIRE(matches.size() == 1);
+      REQUIRE(matches[0].matched);
+      REQUIRE(matches[0].time_over_threshold == float(0.098 * 50));
+   }
+   SECTION("Channels are ordered and independent between frames")
+   {
+      std::vector<RawDataHit> hits = {{0x0020, 5}, {0x0002, 7}, {0x1020, 9}};
+      matcher.Match(hits.data(), hits.size());
+      RequireSameMatches(matcher.Match(hits.data(), hits.size()), ReferenceMatch(hits));
+      REQUIRE(matcher.Match(hits.data(), hits.size())[0].channel == 2);
+      REQUIRE(matcher.Match(hits.data(), 0).empty());
+   }
+}
+
+TEST_CASE("Edge matching agrees with reference", "[drifttubes]")
+{
+   EdgeMatcher matcher;
+   std::mt19937 generator(42);
+   for (auto frame : ROOT::TSeqI(200)) {
+      // Few channels to get many edges per channel
+      std::uniform_int_distribution<uint16_t> channel(0, frame % 2 ? 0x0FFF : 0x000F);
+      std::uniform_int_distribution<uint16_t> time(0, 2000);
+      std::uniform_int_distribution<int> size(0, 500);
+      std::vector<RawDataHit> hits(size(generator));
+      for (auto &&hit : hits) {
+         hit.channelId = channel(generator) | (generator() % 2 ? 0x1000 : 0);
+         hit.hitTime = time(generator);
+      }
+      RequireSameMatches(matcher.Match(hits.data(), hits.size()), ReferenceMatch(hits));
+   }
+}
+
+TEST_CASE("Drift tube calibration", "[drifttubes]")
+{
+   DriftTubes::Calibration calibration;
+   // Triggers of TDC 0 and 1, a tube with a late hit in TDC 1 and the master trigger
+   uint16_t trigger0 = 126, trigger1 = 0x100, master = 0x463, tube = 0x100 + 20, tube_late = 0x100 + 21;
+   REQUIRE(kDetectorIds.id[trigger0] == 0);
+   REQUIRE(kDetectorIds.id[master] == 1);
+   REQUIRE(kDetectorIds.id[tube] > 1000);
+   std::vector<EdgeMatch> matches = {
+      {trigger0, 300, float(0.098 * 20), true, true, 320},  {trigger1, 200, 167.2f, true, false, 0},
+      {trigger1, 150, float(0.098 * 10), false, true, 160}, {tube, 1000, float(0.098 * 100), true, true, 1100},
+      {tube_late, 1200, 167.2f, false, false, 0},          {master, 100, float(0.098 * 10), true, true, 110}};
+   SECTION("Drift time, time over threshold and flags")
+   {
+      calibration.Calibrate(matches, DriftTubes::All_OK);
+      REQUIRE(calibration.GetNHits() == 6);
+      REQUIRE(calibration.GetNTriggers() == 3);
+      REQUIRE(calibration.GetTriggerTime(1) == 150);
+      // No trigger in TDC 4: time 0, no delay
+      REQUIRE(calibration.GetFrameFlags() == (DriftTubes::All_OK | DriftTubes::NoDelay));
+      REQUIRE(calibration.GetDelay() == 13500);
+      REQUIRE(calibration.GetClass(0) == DriftTubes::kTrigger);
+      REQUIRE(calibration.GetClass(3) == DriftTubes::kTube);
+      REQUIRE(calibration.GetClass(4) == DriftTubes::kLateTube);
+      REQUIRE(calibration.GetClass(5) == DriftTubes::kMasterTrigger);
+      REQUIRE(calibration.GetTime(0) == float(0.098 * 300));
+      REQUIRE(calibration.GetTimeOverThreshold(0) == float(0.098 * 20));
+      REQUIRE(calibration.GetTimeOverThreshold(1) == 167.2f);
+      REQUIRE(calibration.GetFlags(1) == (DriftTubes::All_OK | DriftTubes::NoWidth));
+      REQUIRE(calibration.GetTime(3) == float(0.098 * (13500 - 150 + 1000)));
+      REQUIRE(calibration.GetFlags(3) == (DriftTubes::All_OK | DriftTubes::NoDelay));
+      REQUIRE(calibration.GetFlags(4) == (DriftTubes::All_OK | DriftTubes::NoDelay | DriftTubes::NoWidth));
+      // Delay from the trigger of TDC 4
+      matches.push_back({0x460, 600, float(0.098 * 10), true, true, 610});
+      REQUIRE(kDetectorIds.id[0x460] == 0);
+      calibration.Calibrate(matches, DriftTubes::All_OK);
+      REQUIRE(calibration.GetDelay() == 500);
+      REQUIRE(calibration.GetFrameFlags() == DriftTubes::All_OK);
+      REQUIRE(calibration.GetTime(3) == float(0.098 * (500 - 150 + 1000)));
+      // Tube in a TDC without trigger
+      matches[2].channel = matches[1].channel = 0x200 + 126;
+      calibration.Calibrate(matches, DriftTubes::All_OK);
+      REQUIRE(calibration.GetTime(3) == float(0.098 * 1000));
+      REQUIRE(calibration.GetFlags(3) == (DriftTubes::All_OK | DriftTubes::NoTrigger));
+   }
+   SECTION("t0s from file and reload")
+   {
+      const char *filename = "test_online_t0.txt";
+      {
+         std::ofstream out(filename);
+         out << "# TDC channel t0\n1 20 1.5\n";
+      }
+      REQUIRE(calibration.LoadT0s(filename));
+      REQUIRE(calibration.GetT0(1, 20) == 1.5f);
+      REQUIRE(calibration.GetT0(1, 21) == 0.f);
+      calibration.Calibrate(matches, DriftTubes::All_OK);
+      REQUIRE(calibration.GetTime(3) == float(0.098 * (13500 - 150 + 1000) - 1.5));
+      REQUIRE(!calibration.ReloadT0s());
+      {
+         std::ofstream out(filename);
+         out << "1 20 2.5\n1 21 -1.25 # late\n";
+      }
+      REQUIRE(calibration.ReloadT0s());
+      REQUIRE(calibration.GetT0(1, 20) == 2.5f);
+      REQUIRE(calibration.GetT0(1, 21) == -1.25f);
+      {
+         std::ofstream out(filename);
+         out << "17 20 2.5\n";
+      }
+      REQUIRE(!calibration.LoadT0s(filename));
+      REQUIRE(calibration.GetT0(1, 20) == 2.5f);
+      std::remove(filename);
+      REQUIRE(!calibration.LoadT0s(filename));
+   }
+}
+
+// Hit by hit calibration as in DriftTubeUnpack before the column version: class, detector ID, time, ToT, flags
+struct CalibratedHit {
+   int cls;
+   int detectorId;
+   float time;
+   float time_over_threshold;
+   uint16_t flags;
+};
+
+std::vector<CalibratedHit> ReferenceCalibration(const std::vector<EdgeMatch> &matches, uint16_t flags)
+{
+   std::vector<CalibratedHit> hits(matches.size());
+   std::map<int, uint16_t> trigger_times;
+   uint16_t master_trigger_time = 0;
+   bool master = false;
+   for (auto i : ROOT::TSeqI(matches.size())) {
+      auto &&match = matches[i];
+      int detectorId = kDetectorIds.id[match.channel];
+      int TDC = match.channel >> 8;
+      uint16_t hit_flags = match.matched ? flags : flags | DriftTubes::NoWidth;
+      float time_over_threshold = match.matched ? 0.098 * (match.trailing - match.time) : 167.2;
+      int cls = match.first ? DriftTubes::kTube : DriftTubes::kLateTube;
+      if (detectorId == 0) {
+         cls = DriftTubes::kTrigger;
+         trigger_times[TDC] = trigger_times.count(TDC) ? std::min(match.time, trigger_times[TDC]) : match.time;
+      } else if (detectorId == 1) {
+         cls = DriftTubes::kMasterTrigger;
+         master_trigger_time = master ? std::min(match.time, master_trigger_time) : match.time;
+         master = true;
+      } else if (detectorId == -1) {
+         cls = DriftTubes::kBeamCounter;
+      } else if (detectorId == -2) {
+         cls = DriftTubes::kBlacklisted;
+      } else if (detectorId == 6 || detectorId == 7) {
+         cls = DriftTubes::kScintillator;
+      }
+      hits[i] = {cls, detectorId, float(0.098 * float(match.time)), time_over_threshold, hit_flags};
+   }
+   int32_t delay = 13500;
+   if (!trigger_times[4] || master_trigger_time == 0) {
+      flags |= DriftTubes::NoDelay;
+   } else {
+      delay = trigger_times[4] - master_trigger_time;
+   }
+   for (auto i : ROOT::TSeqI(matches.size())) {
+      if (hits[i].cls > DriftTubes::kLateTube) {
+         continue;
+      }
+      hits[i].flags |= flags;
+      auto TDC = matches[i].channel >> 8;
+      if (trigger_times.count(TDC)) {
+         hits[i].time = 0.098 * (delay - trigger_times[TDC] + matches[i].time);
+      } else {
+         hits[i].time = 0.098 * matches[i].time;
+         hits[i].flags |= DriftTubes::NoTrigger;
+      }
+   }
+   return hits;
+}
+
+TEST_CASE("Drift tube calibration agrees with reference", "[drifttubes]")
+{
+   EdgeMatcher matcher;
+   DriftTubes::Calibration calibration;
+   std::mt19937 generator(42);
+   for (auto frame : ROOT::TSeqI(200)) {
+      std::uniform_int_distribution<uint16_t> channel(0, 0x0FFF);
+      std::uniform_int_distribution<uint16_t> time(0, 2000);
+      std::uniform_int_distribution<int> size(0, 500);
+      std::vector<RawDataHit> hits(size(generator));
+      for (auto &&hit : hits) {
+         // Triggers and master trigger in most frames
+         auto special = generator() % 16;
+         hit.channelId = special == 0 ? 0x460 : special == 1 ? 0x463 : special == 2 ? 0x100 : channel(generator);
+         hit.channelId |= generator() % 2 ? 0x1000 : 0;
+         hit.hitTime = time(generator);
+      }
+      auto &&matches = matcher.Match(hits.data(), hits.size());
+      uint16_t flags = frame % 3 ? DriftTubes::All_OK : DriftTubes::TDC1_PROBLEM;
+      calibration.Calibrate(matches, flags);
+      auto reference = ReferenceCalibration(matches, flags);
+      REQUIRE(calibration.GetNHits() == int(reference.size()));
+      for (auto i : ROOT::TSeqI(reference.size())) {
+         REQUIRE(calibration.GetClass(i) == reference[i].cls);
+         REQUIRE(calibration.GetDetectorId(i) == reference[i].detectorId);
+         REQUIRE(calibration.GetFlags(i) == reference[i].flags);
+         REQUIRE(calibration.GetTime(i) == reference[i].time);
+         REQUIRE(calibration.GetTimeOverThreshold(i) == reference[i].time_over_threshold);
+      }
+   }
+}
+
+std::vector<unsigned char> RPCRecord(unsigned char crate, unsigned char board, std::vector<int> channels)
+{
+   std::vector<unsigned char> record(sizeof(RPC::RawHit), 0);
+   record[0] = crate;
+   record[1] = board;
+   for (auto &&channel : channels) {
+      record[11 - channel / 8] |= 1 << (channel % 8);
+   }
+   return record;
+}
+
+// Loop of RPCUnpack::DoUnpack before RPCDecoding.h, verbatim apart from the hit callback, used as reference
+template <typename F>
+int OriginalDecodeRecord(const unsigned char *hit, F &&add)
+{
+   int skipped = 0;
+   const int BYTES_PER_HITPATTERN = 8;
+   auto crate = (unsigned int)hit[0];
+   auto board = (unsigned int)hit[1];
+   for (int k = 1; k <= BYTES_PER_HITPATTERN; k++) {
+      auto index = k + 3;
+
+      auto bitMask = 0x1;
+      for (int j = 0; j < 8; j++) {
+         if (hit[index] & bitMask) {
+            auto channel = (BYTES_PER_HITPATTERN - k) * 8 + j;
+            if ((crate == 16 && (board == 5 || board == 10) && channel >= 48 && channel <= 53) ||
+                (crate == 16 && (board == 3 || board == 8) && channel >= 60 && channel <= 63) ||
+                (crate == 16 && (board == 4 || board == 9) && channel >= 10 && channel <= 15) ||
+                (crate == 16 && (board == 1 || board == 6) && channel >= 0 && channel <= 3) ||
+                (crate == 18 && (board == 5 || board == 10 || board == 15) && channel >= 48 && channel <= 53) ||
+                (crate == 18 && (board == 3 || board == 8 || board == 13) && channel >= 60 && channel <= 63) ||
+                (crate == 18 && (board == 4 || board == 9 || board == 14) && channel >= 10 && channel <= 15) ||
+                (crate == 18 && (board == 1 || board == 6 || board == 11) && channel >= 0 && channel <= 3)) {
+               skipped++;
+               continue;
+            }
+            add(RPC::GetId(crate, board, channel));
+         }
+         bitMask <<= 1;
+      }
+   }
+   return skipped;
+}
+
+TEST_CASE("RPC decoding", "[RPC]")
+{
+   RPC::Decoder decoder;
+   std::vector<int> ids, reference_ids;
+   auto add = [&ids](int id) { ids.push_back(id); };
+   auto add_reference = [&reference_ids](int id) { reference_ids.push_back(id); };
+   SECTION("Channel order")
+   {
+      auto record = RPCRecord(16, 2, {5, 63, 8, 56});
+      REQUIRE(decoder.DecodeRecord(record.data(), add) == 0);
+      REQUIRE(ids == std::vector<int>{RPC::GetId(16, 2, 56), RPC::GetId(16, 2, 63), RPC::GetId(16, 2, 8),
+                                      RPC::GetId(16, 2, 5)});
+   }
+   SECTION("Unconnected channels")
+   {
+      // The bit of an unconnected channel is tested again for the next channels
+      auto record = RPCRecord(16, 1, {2, 4});
+      REQUIRE(decoder.DecodeRecord(record.data(), add) == 2);
+      REQUIRE(ids == std::vector<int>{RPC::GetId(16, 1, 4), RPC::GetId(16, 1, 6)});
+      record = RPCRecord(18, 15, {48});
+      ids.clear();
+      REQUIRE(decoder.DecodeRecord(record.data(), add) == 6);
+      REQUIRE(ids == std::vector<int>{RPC::GetId(18, 15, 54)});
+   }
+   SECTION("Agrees with the original unpacker loop")
+   {
+      std::mt19937 generator(42);
+      for (auto i : ROOT::TSeqI(10000)) {
+         std::vector<unsigned char> record(sizeof(RPC::RawHit));
+         for (auto &&byte : record) {
+            // Sparse and dense patterns
+            byte = generator() & (i % 2 ? 0xFF : generator());
+         }
+         record[0] = generator() % 2 ? 16 : 18;
+         record[1] = 1 + generator() % 15;
+         ids.clear();
+         reference_ids.clear();
+         REQUIRE(decoder.DecodeRecord(record.data(), add) == OriginalDecodeRecord(record.data(), add_reference));
+         REQUIRE(ids == reference_ids);
+         ids.clear();
+         reference_ids.clear();
+         REQUIRE(RPC::DecodeRecordReference(record.data(), add) == OriginalDecodeRecord(record.data(), add_reference));
+         REQUIRE(ids == reference_ids);
+      }
+   }
+}
+
+// Payload of an event builder frame: sub-frames of the given partitions with nhits hits each
+std::vector<int32_t> EventPayload(const std::vector<uint16_t> &partitions, int nhits)
+{
+   std::vector<int32_t> payload;
+   for (auto &&partition : partitions) {
+      std::vector<int32_t> subframe((sizeof(DataFrameHeader) + nhits * sizeof(RawDataHit)) / sizeof(int32_t), 0);
+      auto df = reinterpret_cast<DataFrame *>(subframe.data());
+      df->header.size = subframe.size() * sizeof(int32_t);
+      df->header.partitionId = partition;
+      payload.insert(payload.end(), subframe.begin(), subframe.end());
+   }
+   return payload;
+}
+
+TEST_CASE("Sub-frames of the pipelined mode", "[tdcsource]")
+{
+   struct Unpacker {
+   };
+   Unpacker a, b;
+   auto lookup = [&a, &b](uint16_t partitionId) -> Unpacker * {
+      return partitionId == 0x0C00 ? &a : partitionId == 0x0B00 ? &b : nullptr;
+   };
+   ShipTdcSubFrames<Unpacker> subframes;
+   auto queued = [&subframes](Unpacker *unpacker) {
+      std::vector<int32_t *> frames;
+      for (auto &&item : subframes) {
+         if (item.first == unpacker) {
+            for (auto &&subframe : item.second) {
+               frames.push_back(subframe.first);
+            }
+         }
+      }
+      return frames;
+   };
+   auto first = EventPayload({0x0C00, 0x0B00, 0x0C00}, 2);
+   auto second = EventPayload({0x0B00, 0x0800, 0x0C00}, 1);
+   auto third = EventPayload({0x0B00}, 3);
+   SECTION("Grouped by unpacker in frame order")
+   {
+      REQUIRE(subframes.Queue(first.data(), first.size() * sizeof(int32_t), lookup));
+      REQUIRE(subframes.GetNSubFrames() == 3);
+      REQUIRE(queued(&a) == std::vector<int32_t *>{first.data(), first.data() + 2 * first.size() / 3});
+      REQUIRE(queued(&b) == std::vector<int32_t *>{first.data() + first.size() / 3});
+   }
+   SECTION("Event frame with an unknown partition")
+   {
+      REQUIRE(subframes.Queue(first.data(), first.size() * sizeof(int32_t), lookup));
+      // Neither the sub-frames of the previous frame nor the ones before the unknown partition stay queued
+      REQUIRE(!subframes.Queue(second.data(), second.size() * sizeof(int32_t), lookup));
+      REQUIRE(subframes.GetNSubFrames() == 0);
+      REQUIRE(subframes.Queue(third.data(), third.size() * sizeof(int32_t), lookup));
+      REQUIRE(queued(&a).empty());
+      REQUIRE(queued(&b) == std::vector<int32_t *>{third.data()});
+   }
+}